@@ -0,0 +1,249 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <glad/glad.h>
+
+#include <string>
+#include <algorithm>
+#include <string_view>
+#include <initializer_list>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+// GL_ARB_get_program_binary (core since 4.1), our glad is generated for 3.3 core only
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+
+struct ProgramBinaryCacheStats
+{
+    unsigned int hits{};
+    unsigned int misses{};
+    unsigned int rejected{};        // binary found on disk but refused by the driver
+    double       loadMs{};          // time spent in glProgramBinary for hits
+    double       compileMs{};       // time spent compiling + linking from source on misses
+};
+
+
+/*
+    on-disk cache of linked program binaries
+
+    a program is stored under <directory>/<key>.bin, where the key is a hash of every source
+    string, the defines and the driver vendor/renderer/version strings. a driver update or a
+    different GPU therefore never hits an old binary, and if the driver still rejects a binary
+    (glProgramBinary fails to link) the caller falls back to a full compile and overwrites it.
+
+    usage (after gladLoadGLLoader):
+        ProgramBinaryCache::enable(".shader-cache", (GLADloadproc)glfwGetProcAddress);
+*/
+class ProgramBinaryCache
+{
+    using GetProgramBinaryProc   = void (APIENTRYP)(GLuint, GLsizei, GLsizei*, GLenum*, void*);
+    using ProgramBinaryProc      = void (APIENTRYP)(GLuint, GLenum, const void*, GLsizei);
+    using ProgramParameteriProc  = void (APIENTRYP)(GLuint, GLenum, GLint);
+
+    struct FileHeader
+    {
+        char          magic[4]{ 'L', 'G', 'P', 'B' };
+        std::uint32_t version{ 1 };
+        std::uint32_t format{};
+        std::uint32_t length{};
+        std::uint64_t key{};
+    };
+
+    static inline GetProgramBinaryProc  s_getProgramBinary{ nullptr };
+    static inline ProgramBinaryProc     s_programBinary{ nullptr };
+    static inline ProgramParameteriProc s_programParameteri{ nullptr };
+
+    static inline bool                  s_enabled{ false };
+    static inline std::filesystem::path s_directory{};
+    static inline std::string           s_driver{};         // vendor + renderer + version
+
+public:
+    static inline ProgramBinaryCacheStats stats{};
+
+    // returns false (and leaves the cache disabled) if the driver exposes no binary format
+    static bool enable(const std::filesystem::path& directory, GLADloadproc loader)
+    {
+        s_getProgramBinary  = reinterpret_cast<GetProgramBinaryProc>(loader("glGetProgramBinary"));
+        s_programBinary     = reinterpret_cast<ProgramBinaryProc>(loader("glProgramBinary"));
+        s_programParameteri = reinterpret_cast<ProgramParameteriProc>(loader("glProgramParameteri"));
+
+        int formatCount{ 0 };
+        if (s_getProgramBinary && s_programBinary && s_programParameteri)
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+
+        if (formatCount <= 0)
+        {
+            std::cerr << "ProgramBinaryCache: driver does not support program binaries, cache disabled\n";
+            s_enabled = false;
+            return false;
+        }
+
+        std::error_code error{};
+        std::filesystem::create_directories(directory, error);
+        if (error)
+        {
+            std::cerr << "ProgramBinaryCache: can't create cache directory " << directory << ": " << error.message() << '\n';
+            s_enabled = false;
+            return false;
+        }
+
+        s_directory = directory;
+        s_driver = getString(GL_VENDOR) + '\n' + getString(GL_RENDERER) + '\n' + getString(GL_VERSION);
+        s_enabled = true;
+        return true;
+    }
+
+    static void disable() { s_enabled = false; }
+    static bool isEnabled() { return s_enabled; }
+
+    // combine content hashes (sources, defines, ...) with the driver identification
+    static std::uint64_t makeKey(std::initializer_list<std::uint64_t> contentHashes)
+    {
+        std::uint64_t hash{ hashBytes(s_driver) };
+        for (auto contentHash : contentHashes)
+            hash = hashBytes({ reinterpret_cast<const char*>(&contentHash), sizeof(contentHash) }, hash);
+        return hash;
+    }
+
+    static std::uint64_t hashBytes(std::string_view bytes, std::uint64_t hash = 0xcbf29ce484222325ull)
+    {
+        for (char c : bytes)
+        {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    // must be called before glLinkProgram, otherwise the driver may not keep the binary around
+    static void markRetrievable(unsigned int program)
+    {
+        if (s_enabled)
+            s_programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    // try to link `program` from the cached binary, returns false on miss or format mismatch
+    static bool load(unsigned int program, std::uint64_t key)
+    {
+        if (!s_enabled)
+            return false;
+
+        auto start{ std::chrono::steady_clock::now() };
+
+        std::ifstream file{ pathOf(key), std::ios::binary };
+        FileHeader header{};
+        if (!file || !file.read(reinterpret_cast<char*>(&header), sizeof(header)) || !isValid(header, key))
+        {
+            ++stats.misses;
+            return false;
+        }
+
+        std::vector<char> binary(header.length);
+        if (!file.read(binary.data(), header.length))
+        {
+            ++stats.misses;
+            return false;
+        }
+
+        s_programBinary(program, header.format, binary.data(), static_cast<GLsizei>(header.length));
+
+        int success{};
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            ++stats.rejected;
+            ++stats.misses;
+            return false;
+        }
+
+        ++stats.hits;
+        stats.loadMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return true;
+    }
+
+    // write the binary of a successfully linked program
+    static void store(unsigned int program, std::uint64_t key)
+    {
+        if (!s_enabled)
+            return;
+
+        int length{};
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+            return;
+
+        std::vector<char> binary(static_cast<std::size_t>(length));
+        GLenum format{};
+        s_getProgramBinary(program, length, nullptr, &format, binary.data());
+
+        FileHeader header{};
+        header.format = format;
+        header.length = static_cast<std::uint32_t>(length);
+        header.key = key;
+
+        // write to a temporary file first so a crash never leaves a truncated binary behind
+        auto path{ pathOf(key) };
+        auto tempPath{ path };
+        tempPath += ".tmp";
+        {
+            std::ofstream file{ tempPath, std::ios::binary | std::ios::trunc };
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(binary.data(), length);
+            if (!file)
+                return;
+        }
+        std::error_code error{};
+        std::filesystem::rename(tempPath, path, error);
+    }
+
+    static void addCompileTime(double ms) { stats.compileMs += ms; }
+
+    // estimated time saved = hits * (average compile time) - time spent loading binaries
+    static void printStats(std::ostream& out = std::cout)
+    {
+        unsigned int compiled{ stats.misses };
+        double averageCompileMs{ compiled ? stats.compileMs / compiled : 0.0 };
+
+        out << "ProgramBinaryCache: " << stats.hits << " hit(s), " << stats.misses << " miss(es), "
+            << stats.rejected << " rejected | load " << stats.loadMs << " ms, compile " << stats.compileMs << " ms";
+        if (compiled && stats.hits)
+            out << ", ~" << (stats.hits * averageCompileMs - stats.loadMs) << " ms saved";
+        out << '\n';
+    }
+
+private:
+    static std::string getString(GLenum name)
+    {
+        auto str{ reinterpret_cast<const char*>(glGetString(name)) };
+        return str ? str : "";
+    }
+
+    static std::filesystem::path pathOf(std::uint64_t key)
+    {
+        char name[32]{};
+        std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+        return s_directory / name;
+    }
+
+    static bool isValid(const FileHeader& header, std::uint64_t key)
+    {
+        FileHeader expected{};
+        return std::equal(std::begin(header.magic), std::end(header.magic), std::begin(expected.magic))
+            && header.version == expected.version
+            && header.key == key
+            && header.length > 0;
+    }
+};
+
+
+#endif
@@ -4,10 +4,138 @@
 #include <glad/glad.h>  // include glad to get all the required OpenGL headers
 #include <glm/glm.hpp>
 
+#include <shader_header/program_cache.h>
+#include <shader_header/shader_source.h>
+#include <shader_header/uniform_buffer.h>
+#include <gl_state_header/gl_state.h>
+
 #include <string>
-#include <fstream>
-#include <sstream>
+#include <string_view>
+#include <vector>
+#include <cstdint>
 #include <iostream>
+#include <chrono>
+
+
+// handle to a uniform, resolved once through Shader::uniform() and reused in hot loops.
+// it only means something to the Shader that returned it (owner), another one resolves it to -1
+struct UniformHandle
+{
+    int slot{ -1 };
+    std::uint32_t owner{ 0 };
+
+    bool isValid() const { return slot >= 0; }
+};
+
+
+// id of the handle slots of a Shader: a copy gets a new one, its slots grow independently.
+// a move keeps it (the slots move along)
+class UniformHandleOwner
+{
+    static inline std::uint32_t s_next{ 1 };
+    std::uint32_t m_id{ s_next++ };
+
+public:
+    UniformHandleOwner() = default;
+    UniformHandleOwner(const UniformHandleOwner&) : m_id{ s_next++ } {}
+    UniformHandleOwner(UniformHandleOwner&&) noexcept = default;
+    UniformHandleOwner& operator=(const UniformHandleOwner&) { m_id = s_next++; return *this; }
+    UniformHandleOwner& operator=(UniformHandleOwner&&) noexcept = default;
+
+    std::uint32_t id() const { return m_id; }
+};
+
+
+// open addressing hash table of the active uniforms of a program, filled once at link time
+class UniformTable
+{
+    struct Entry
+    {
+        std::uint64_t hash{ 0 };        // 0 means empty slot
+        int location{ -1 };
+        std::string name{};
+    };
+
+    std::vector<Entry> m_entries{};
+    std::size_t m_count{ 0 };
+
+public:
+    // FNV-1a, usable at compile time for string literals
+    static constexpr std::uint64_t hashName(std::string_view name)
+    {
+        std::uint64_t hash{ 0xcbf29ce484222325ull };
+        for (char c : name)
+        {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 0x100000001b3ull;
+        }
+        return hash ? hash : 1;
+    }
+
+    void clear()
+    {
+        m_entries.clear();
+        m_count = 0;
+    }
+
+    void insert(std::string_view name, int location)
+    {
+        // keep load factor under 0.5
+        if ((m_count + 1) * 2 > m_entries.size())
+            rehash(m_entries.empty() ? 16 : m_entries.size() * 2);
+
+        std::uint64_t hash{ hashName(name) };
+        std::size_t mask{ m_entries.size() - 1 };
+        for (std::size_t i{ hash & mask }; ; i = (i + 1) & mask)
+        {
+            auto& entry{ m_entries[i] };
+            if (entry.hash == 0)
+            {
+                entry = { hash, location, std::string{ name } };
+                ++m_count;
+                return;
+            }
+            if (entry.hash == hash && entry.name == name)
+            {
+                entry.location = location;
+                return;
+            }
+        }
+    }
+
+    // returns -1 if not found (glUniform* silently ignores location -1)
+    int find(std::string_view name, std::uint64_t hash) const
+    {
+        if (m_entries.empty())
+            return -1;
+
+        std::size_t mask{ m_entries.size() - 1 };
+        for (std::size_t i{ hash & mask }; ; i = (i + 1) & mask)
+        {
+            const auto& entry{ m_entries[i] };
+            if (entry.hash == 0)
+                return -1;
+            if (entry.hash == hash && entry.name == name)
+                return entry.location;
+        }
+    }
+
+    int find(std::string_view name) const { return find(name, hashName(name)); }
+
+    std::size_t size() const { return m_count; }
+
+private:
+    void rehash(std::size_t capacity)
+    {
+        std::vector<Entry> old{ std::move(m_entries) };
+        m_entries = std::vector<Entry>(capacity);
+        m_count = 0;
+        for (auto& entry : old)
+            if (entry.hash != 0)
+                insert(entry.name, entry.location);
+    }
+};
+
 
 class Shader
 {
@@ -33,150 +161,286 @@ public:
             "   FragColor = vec4(1.0f, 0.5f, 0.2f, 1.0f);\n"
             "}\0" };
 
-        ID = compileShader(vDefaultShaderCode, fDefaultShaderCode);
+        ID = compileShader(ShaderSource::fromString(vDefaultShaderCode), ShaderSource::fromString(fDefaultShaderCode));
+        cacheUniforms();
     }
 
     // constructor read and build the shader
     //-----------------------------------------------------------------------------------
-    Shader(const char* vertexPath, const char* fragmentPath)
-    {
-        // 1. retrieve the vertex/fragment source code from filePath
-        std::string vertexCode;
-        std::string fragmentCode;
-        std::ifstream vShaderFile;
-        std::ifstream fShaderFile;
-        // ensure ifstream object can throw exceptions:
-        vShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        fShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        try
-        {
-            // open files
-            vShaderFile.open(vertexPath);
-            fShaderFile.open(fragmentPath);
-            std::stringstream vShaderStream, fShaderStream;
-            // read file's buffer contents into streams
-            vShaderStream << vShaderFile.rdbuf();
-            fShaderStream << fShaderFile.rdbuf();
-            // close file handlers
-            vShaderFile.close();
-            fShaderFile.close();
-            // convert stream into string
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();
-        }
-        catch(std::ifstream::failure e)
+    // (1. the vertex/fragment source code is memory mapped from filePath, #include resolved)
+    // defines select a variant of the shader, they are injected after the #version line of both stages
+    Shader(const char* vertexPath, const char* fragmentPath, const ShaderDefines& defines = {})
+        : Shader{ ShaderSource{ vertexPath, defines }, ShaderSource{ fragmentPath, defines } }
+    {
+    }
+
+    // constructor build the shader from already loaded sources
+    //-----------------------------------------------------------------------------------
+    Shader(const ShaderSource& vertexSource, const ShaderSource& fragmentSource)
+    {
+        ID = compileShader(vertexSource, fragmentSource);
+        cacheUniforms();
+    }
+
+    // rebuild the program from new sources, the old program is kept if the new one fails to link.
+    // uniform handles stay valid, they are re-resolved against the new program
+    //-----------------------------------------------------------------------------------
+    bool reload(const ShaderSource& vertexSource, const ShaderSource& fragmentSource)
+    {
+        unsigned int program{ compileShader(vertexSource, fragmentSource) };
+
+        int success{};
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success)
         {
-            std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << std::endl;
+            glDeleteProgram(program);
+            return false;
         }
-        const char* vShaderCode { vertexCode.c_str() };
-        const char* fShaderCode { fragmentCode.c_str() };
 
-        ID = compileShader(vShaderCode, fShaderCode);
+        GLState::forgetProgram(ID);
+        glDeleteProgram(ID);
+        ID = program;
+        cacheUniforms();
+        return true;
     }
     
     // use/activate the shader
     //-----------------------------------------------------------------------------------
     void use() const
     {
-        glUseProgram(ID);
+        GLState::useProgram(ID);        // filtered if the program is already in use
     }
 
-    // utility uniform functions
+    // resolve a uniform once, use the returned handle for the per-draw setters below
     //-----------------------------------------------------------------------------------
-    void setBool(const std::string &name, bool value) const
+    UniformHandle uniform(std::string_view name)
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+        for (std::size_t i{ 0 }; i < m_handleNames.size(); ++i)
+            if (m_handleNames[i] == name)
+                return { static_cast<int>(i), m_handleOwner.id() };
+
+        m_handleNames.emplace_back(name);
+        m_handleLocations.push_back(m_uniforms.find(name));
+        return { static_cast<int>(m_handleNames.size() - 1), m_handleOwner.id() };
     }
+
+    int getUniformLocation(std::string_view name) const { return m_uniforms.find(name); }
+    int getUniformLocation(UniformHandle handle) const
+    {
+        // a handle of another Shader would index someone else's slots (or past them)
+        if (!handle.isValid() || handle.owner != m_handleOwner.id() || static_cast<std::size_t>(handle.slot) >= m_handleLocations.size())
+            return -1;
+        return m_handleLocations[static_cast<std::size_t>(handle.slot)];
+    }
+
+    // utility uniform functions (by name: hashed lookup in the uniform table, no GL query)
     //-----------------------------------------------------------------------------------
-    void setInt(const std::string &name, int value) const
+    void setBool(std::string_view name, bool value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+        glUniform1i(getUniformLocation(name), (int)value);
     }
     //-----------------------------------------------------------------------------------
-    void setFloat(const std::string &name, float value) const
+    void setInt(std::string_view name, int value) const
     {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+        glUniform1i(getUniformLocation(name), value);
     }
     //-----------------------------------------------------------------------------------
-    void setVec2(const std::string &name, const glm::vec2 &value) const
+    void setFloat(std::string_view name, float value) const
+    {
+        glUniform1f(getUniformLocation(name), value);
+    }
+    //-----------------------------------------------------------------------------------
+    void setVec2(std::string_view name, const glm::vec2 &value) const
     { 
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        glUniform2fv(getUniformLocation(name), 1, &value[0]); 
     }
-    void setVec2(const std::string &name, float x, float y) const
+    void setVec2(std::string_view name, float x, float y) const
     { 
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y); 
+        glUniform2f(getUniformLocation(name), x, y); 
     }
     //-----------------------------------------------------------------------------------
-    void setVec3(const std::string &name, const glm::vec3 &value) const
+    void setVec3(std::string_view name, const glm::vec3 &value) const
     { 
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        glUniform3fv(getUniformLocation(name), 1, &value[0]); 
     }
-    void setVec3(const std::string &name, float x, float y, float z) const
+    void setVec3(std::string_view name, float x, float y, float z) const
     { 
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z); 
+        glUniform3f(getUniformLocation(name), x, y, z); 
     }
     //-----------------------------------------------------------------------------------
-    void setVec4(const std::string &name, const glm::vec4 &value) const
+    void setVec4(std::string_view name, const glm::vec4 &value) const
     { 
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        glUniform4fv(getUniformLocation(name), 1, &value[0]); 
     }
-    void setVec4(const std::string &name, float x, float y, float z, float w) 
+    void setVec4(std::string_view name, float x, float y, float z, float w) 
     { 
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w); 
+        glUniform4f(getUniformLocation(name), x, y, z, w); 
     }
     //-----------------------------------------------------------------------------------
-    void setMat2(const std::string &name, const glm::mat2 &mat) const
+    void setMat2(std::string_view name, const glm::mat2 &mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix2fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
     }
     //-----------------------------------------------------------------------------------
-    void setMat3(const std::string &name, const glm::mat3 &mat) const
+    void setMat3(std::string_view name, const glm::mat3 &mat) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix3fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
     }
     //-----------------------------------------------------------------------------------
-    void setMat4(const std::string &name, const glm::mat4 &mat) const
+    void setMat4(std::string_view name, const glm::mat4 &mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
+    }
+
+    // utility uniform functions (by handle: a single array index)
+    //-----------------------------------------------------------------------------------
+    void setBool(UniformHandle handle, bool value) const
+    {
+        glUniform1i(getUniformLocation(handle), (int)value);
+    }
+    void setInt(UniformHandle handle, int value) const
+    {
+        glUniform1i(getUniformLocation(handle), value);
+    }
+    void setFloat(UniformHandle handle, float value) const
+    {
+        glUniform1f(getUniformLocation(handle), value);
+    }
+    void setVec2(UniformHandle handle, const glm::vec2 &value) const
+    {
+        glUniform2fv(getUniformLocation(handle), 1, &value[0]);
+    }
+    void setVec3(UniformHandle handle, const glm::vec3 &value) const
+    {
+        glUniform3fv(getUniformLocation(handle), 1, &value[0]);
+    }
+    void setVec4(UniformHandle handle, const glm::vec4 &value) const
+    {
+        glUniform4fv(getUniformLocation(handle), 1, &value[0]);
+    }
+    void setMat2(UniformHandle handle, const glm::mat2 &mat) const
+    {
+        glUniformMatrix2fv(getUniformLocation(handle), 1, GL_FALSE, &mat[0][0]);
+    }
+    void setMat3(UniformHandle handle, const glm::mat3 &mat) const
+    {
+        glUniformMatrix3fv(getUniformLocation(handle), 1, GL_FALSE, &mat[0][0]);
+    }
+    void setMat4(UniformHandle handle, const glm::mat4 &mat) const
+    {
+        glUniformMatrix4fv(getUniformLocation(handle), 1, GL_FALSE, &mat[0][0]);
     }
 
 private:
-    unsigned int compileShader(const char* vShaderCode, const char* fShaderCode)
+    // uniform locations, queried once after linking
+    UniformTable m_uniforms{};
+    std::vector<std::string> m_handleNames{};
+    std::vector<int> m_handleLocations{};
+    UniformHandleOwner m_handleOwner{};
+
+    // introspect all active uniforms of the linked program (run once at link time)
+    //-----------------------------------------------------------------------------------
+    void cacheUniforms()
+    {
+        m_uniforms.clear();
+
+        int count{};
+        int maxLength{};
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+        std::string name(static_cast<std::size_t>(maxLength) + 1, '\0');
+        for (int i{ 0 }; i < count; ++i)
+        {
+            int length{};
+            int size{};
+            GLenum type{};
+            glGetActiveUniform(ID, static_cast<GLuint>(i), maxLength + 1, &length, &size, &type, name.data());
+
+            std::string_view uniformName{ name.data(), static_cast<std::size_t>(length) };
+            int location{ glGetUniformLocation(ID, name.c_str()) };
+            if (location < 0)
+                continue;       // uniform block member, not settable through glUniform*
+
+            m_uniforms.insert(uniformName, location);
+
+            // arrays of basic type are reported once as "name[0]", register "name" and every element
+            if (uniformName.ends_with("[0]"))
+            {
+                std::string_view baseName{ uniformName.substr(0, uniformName.size() - 3) };
+                m_uniforms.insert(baseName, location);
+
+                for (int element{ 1 }; element < size; ++element)
+                {
+                    std::string elementName{ std::string{ baseName } + '[' + std::to_string(element) + ']' };
+                    m_uniforms.insert(elementName, glGetUniformLocation(ID, elementName.c_str()));
+                }
+            }
+        }
+
+        // keep handles obtained before (re)linking pointing at the right uniforms
+        for (std::size_t i{ 0 }; i < m_handleNames.size(); ++i)
+            m_handleLocations[i] = m_uniforms.find(m_handleNames[i]);
+
+        // attach the program's uniform blocks to the shared uniform buffers
+        UniformBlockBindings::apply(ID);
+    }
+
+    unsigned int compileShader(const ShaderSource& vertexSource, const ShaderSource& fragmentSource)
     {
+        // 1.5. try the program binary cache first
+        //-----------------------------------------------------------------------------------
+        std::uint64_t cacheKey{};
+        if (ProgramBinaryCache::isEnabled())
+        {
+            cacheKey = ProgramBinaryCache::makeKey({ vertexSource.hash(), fragmentSource.hash() });
+            unsigned int program{ glCreateProgram() };
+            if (ProgramBinaryCache::load(program, cacheKey))
+                return program;
+            glDeleteProgram(program);   // miss or format mismatch, fall back to a full compile
+        }
+        auto compileStart{ std::chrono::steady_clock::now() };
+
         // 2. compile shaders
         //-----------------------------------------------------------------------------------
         unsigned int vertex, fragment;
-        char infoLog[512];
 
         // vertex shader
         vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, NULL);
+        glShaderSource(vertex, vertexSource.getCount(), vertexSource.getStrings(), vertexSource.getLengths());
         glCompileShader(vertex);
         checkCompileErrors(vertex, "VERTEX");   // print compile error if any
 
         // fragment shader
         fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, NULL);
+        glShaderSource(fragment, fragmentSource.getCount(), fragmentSource.getStrings(), fragmentSource.getLengths());
         glCompileShader(fragment);
         checkCompileErrors(fragment, "FRAGMENT");   // print compile error if any
 
         // shader program
-        ID = glCreateProgram();
-        glAttachShader(ID, vertex);
-        glAttachShader(ID, fragment);
-        glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");  // print linking error if any
+        unsigned int program{ glCreateProgram() };
+        glAttachShader(program, vertex);
+        glAttachShader(program, fragment);
+        ProgramBinaryCache::markRetrievable(program);
+        glLinkProgram(program);
+        bool linked{ checkCompileErrors(program, "PROGRAM") };  // print linking error if any
 
         // delete the shaders as they're linked onto our program now and no longer necessary
         glDeleteShader(vertex);
         glDeleteShader(fragment);
 
-        return ID;
+        if (linked && ProgramBinaryCache::isEnabled())
+        {
+            ProgramBinaryCache::addCompileTime(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - compileStart).count());
+            ProgramBinaryCache::store(program, cacheKey);
+        }
+
+        return program;
     }
 
     // utility function for checking shader compilation/linking errors
     //-----------------------------------------------------------------------------------
-    void checkCompileErrors(unsigned int shader, std::string type)
+    bool checkCompileErrors(unsigned int shader, std::string type)
     {
         int success;
         char infoLog[1024];
@@ -198,6 +462,7 @@ private:
                 std::cerr << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << '\n' << infoLog << std::endl;
             }
         }
+        return success;
     }
 };
 
@@ -0,0 +1,322 @@
+#ifndef SHADER_LIBRARY_H
+#define SHADER_LIBRARY_H
+
+#include <glad/glad.h>
+
+#include <shader_header/shader.h>
+#include <shader_header/shader_source.h>
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <filesystem>
+#include <unordered_map>
+#include <iostream>
+#include <cstdint>
+
+// linux file watching
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+
+
+/*
+    owns the Shader programs of an application and hot-reloads them when their sources change
+
+    a worker thread watches (inotify) the directories of every file a program depends on,
+    including #include-d files. when one of them is written, the worker preprocesses the
+    sources of the affected programs and hashes them; programs whose hash actually changed
+    are queued, as a copy of their preprocessed text: the files may be rewritten (truncated)
+    again before the reload is compiled, no mapping is kept past the worker. update() is called
+    by the render thread once per frame (frame boundary): it compiles the queued programs and
+    swaps their IDs. a program that fails to compile keeps
+    its old ID, uniform handles obtained from the Shader stay valid across reloads. uniform
+    values don't survive a reload: update() returns the reloaded Shaders, values set once
+    (materials, ...) have to be set again on them.
+
+    Shader references returned by load() are stable for the lifetime of the library.
+
+    variants: the same files loaded with different ShaderDefines are separate programs, built
+    lazily on the first load() of a define set and found again by (files, defines): the hash
+    of the key only picks the bucket, a hit is compared in full, so the render loop can
+    cheaply pick the specialized program matching each object.
+*/
+class ShaderLibrary
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Program
+    {
+        std::filesystem::path              vertexPath{};
+        std::filesystem::path              fragmentPath{};
+        ShaderDefines                      defines{};
+        std::vector<std::filesystem::path> dependencies{};      // canonical paths of both sources and their includes
+        std::uint64_t                      sourceHash{};
+    };
+
+    struct PendingReload
+    {
+        std::size_t       program{};
+        std::string       vertex{};         // preprocessed sources, owned
+        std::string       fragment{};
+        std::vector<std::filesystem::path> dependencies{};
+        std::uint64_t     sourceHash{};
+        Clock::time_point detected{};
+    };
+
+    std::vector<std::unique_ptr<Shader>> m_shaders{};           // render thread only
+    std::vector<Program>                 m_programs{};          // shared with the worker, guarded by m_mutex
+    std::vector<PendingReload>           m_pending{};           // shared with the worker, guarded by m_mutex
+    std::mutex                           m_mutex{};
+
+    struct VariantKey
+    {
+        std::filesystem::path vertexPath{};
+        std::filesystem::path fragmentPath{};
+        ShaderDefines         defines{};
+
+        bool operator==(const VariantKey&) const = default;
+    };
+
+    struct VariantHash
+    {
+        std::size_t operator()(const VariantKey& key) const
+        {
+            return static_cast<std::size_t>(variantHash(key.vertexPath, key.fragmentPath, key.defines));
+        }
+    };
+
+    std::unordered_map<VariantKey, std::size_t, VariantHash> m_variants{};     // variant -> index, render thread only
+
+    int                                            m_inotify{ -1 };
+    std::unordered_map<int, std::filesystem::path> m_watchedDirectories{};     // watch descriptor -> directory
+    std::jthread                                   m_worker{};
+
+public:
+    ShaderLibrary()
+    {
+        m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (m_inotify < 0)
+        {
+            std::cerr << "ShaderLibrary: inotify unavailable, hot reload disabled\n";
+            return;
+        }
+
+        m_worker = std::jthread{ [this](std::stop_token stop) { watch(stop); } };
+    }
+
+    ShaderLibrary(const ShaderLibrary&) = delete;
+    ShaderLibrary& operator=(const ShaderLibrary&) = delete;
+
+    ~ShaderLibrary()
+    {
+        if (m_worker.joinable())
+        {
+            m_worker.request_stop();
+            m_worker.join();
+        }
+        if (m_inotify >= 0)
+            ::close(m_inotify);
+    }
+
+    // load (or return the already loaded) program built from the given files and defines
+    Shader& load(const std::filesystem::path& vertexPath, const std::filesystem::path& fragmentPath, const ShaderDefines& defines = {})
+    {
+        VariantKey key{ vertexPath, fragmentPath, defines };
+        if (auto it{ m_variants.find(key) }; it != m_variants.end())
+            return *m_shaders[it->second];
+
+        ShaderSource vertex{ vertexPath, defines };
+        ShaderSource fragment{ fragmentPath, defines };
+        m_shaders.push_back(std::make_unique<Shader>(vertex, fragment));
+        m_variants.emplace(std::move(key), m_shaders.size() - 1);
+
+        Program program{ vertexPath, fragmentPath, defines, dependenciesOf(vertex, fragment), hashOf(vertex, fragment) };
+        watchDependencies(program.dependencies);
+
+        std::scoped_lock lock{ m_mutex };
+        m_programs.push_back(std::move(program));
+        return *m_shaders.back();
+    }
+
+    static std::uint64_t variantHash(const std::filesystem::path& vertexPath, const std::filesystem::path& fragmentPath, const ShaderDefines& defines)
+    {
+        std::uint64_t hash{ defines.hash() };
+        for (const auto* path : { &vertexPath, &fragmentPath })
+            for (char c : path->native())
+            {
+                hash ^= static_cast<unsigned char>(c);
+                hash *= 0x100000001b3ull;
+            }
+        return hash;
+    }
+
+    // call once per frame from the thread that owns the GL context, returns the Shaders whose
+    // program was replaced (their uniforms are back to their defaults)
+    std::vector<Shader*> update()
+    {
+        std::vector<PendingReload> pending{};
+        {
+            std::scoped_lock lock{ m_mutex };
+            pending.swap(m_pending);
+        }
+
+        std::vector<Shader*> reloaded{};
+        for (auto& reload : pending)
+        {
+            Shader& shader{ *m_shaders[reload.program] };
+            bool success{ shader.reload(ShaderSource::fromString(reload.vertex.c_str()), ShaderSource::fromString(reload.fragment.c_str())) };
+
+            if (success)
+                reloaded.push_back(&shader);
+
+            auto latency{ std::chrono::duration<double, std::milli>(Clock::now() - reload.detected).count() };
+
+            watchDependencies(reload.dependencies);        // a new #include may have been added
+            {
+                std::scoped_lock lock{ m_mutex };
+                auto& program{ m_programs[reload.program] };
+                program.dependencies = std::move(reload.dependencies);
+                program.sourceHash = reload.sourceHash;     // also on failure: don't retry until the file changes again
+
+                std::cout << "ShaderLibrary: " << (success ? "reloaded " : "failed to reload ")
+                          << program.vertexPath << " + " << program.fragmentPath
+                          << (program.defines.empty() ? "" : " (variant)")
+                          << " (" << latency << " ms after the change)\n";
+            }
+        }
+        return reloaded;
+    }
+
+    std::size_t size() const { return m_shaders.size(); }
+
+private:
+    static std::uint64_t hashOf(const ShaderSource& vertex, const ShaderSource& fragment)
+    {
+        return fragment.hash(vertex.hash());
+    }
+
+    static std::vector<std::filesystem::path> dependenciesOf(const ShaderSource& vertex, const ShaderSource& fragment)
+    {
+        std::vector<std::filesystem::path> dependencies{};
+        for (const auto* source : { &vertex, &fragment })
+            for (const auto& file : source->getFiles())
+                dependencies.push_back(file.path);
+        return dependencies;
+    }
+
+    // watch directories instead of files: editors usually save by writing a new file and renaming it
+    void watchDependencies(const std::vector<std::filesystem::path>& dependencies)
+    {
+        if (m_inotify < 0)
+            return;
+
+        std::scoped_lock lock{ m_mutex };
+        for (const auto& dependency : dependencies)
+        {
+            auto directory{ dependency.parent_path() };
+
+            bool watched{ false };
+            for (const auto& [descriptor, path] : m_watchedDirectories)
+                watched = watched || path == directory;
+            if (watched)
+                continue;
+
+            int descriptor{ inotify_add_watch(m_inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) };
+            if (descriptor >= 0)
+                m_watchedDirectories[descriptor] = directory;
+        }
+    }
+
+    // worker thread
+    void watch(std::stop_token stop)
+    {
+        alignas(inotify_event) char buffer[4096];
+
+        while (!stop.stop_requested())
+        {
+            pollfd descriptor{ m_inotify, POLLIN, 0 };
+            if (::poll(&descriptor, 1, 50) <= 0)
+                continue;
+
+            auto detected{ Clock::now() };
+            std::vector<std::filesystem::path> changed{};
+
+            // drain everything that is queued now plus whatever the editor writes right after (save = several events)
+            for (int idle{ 0 }; idle < 2; )
+            {
+                ssize_t length{ ::read(m_inotify, buffer, sizeof(buffer)) };
+                if (length <= 0)
+                {
+                    ++idle;
+                    std::this_thread::sleep_for(std::chrono::milliseconds{ 2 });
+                    continue;
+                }
+
+                std::scoped_lock lock{ m_mutex };
+                for (char* ptr{ buffer }; ptr < buffer + length; )
+                {
+                    auto* event{ reinterpret_cast<inotify_event*>(ptr) };
+                    if (event->len > 0 && m_watchedDirectories.contains(event->wd))
+                        changed.push_back(m_watchedDirectories[event->wd] / event->name);
+                    ptr += sizeof(inotify_event) + event->len;
+                }
+            }
+
+            if (!changed.empty())
+                revalidate(changed, detected);
+        }
+    }
+
+    // worker thread: preprocess + hash the programs that depend on a changed file, the mappings
+    // are released before returning
+    void revalidate(const std::vector<std::filesystem::path>& changed, Clock::time_point detected)
+    {
+        // snapshot, so the (slow) preprocessing happens without holding the lock
+        std::vector<std::pair<std::size_t, Program>> affected{};
+        {
+            std::scoped_lock lock{ m_mutex };
+            for (std::size_t i{ 0 }; i < m_programs.size(); ++i)
+                for (const auto& dependency : m_programs[i].dependencies)
+                    if (std::find(changed.begin(), changed.end(), dependency) != changed.end())
+                    {
+                        affected.emplace_back(i, m_programs[i]);
+                        break;
+                    }
+        }
+
+        for (auto& [index, program] : affected)
+        {
+            PendingReload reload{ index };
+            {
+                ShaderSource vertex{ program.vertexPath, program.defines };
+                ShaderSource fragment{ program.fragmentPath, program.defines };
+                if (!vertex.isValid() || !fragment.isValid())
+                    continue;       // file is mid-save or was removed, wait for the next event
+
+                reload.vertex = vertex.toString();
+                reload.fragment = fragment.toString();
+                reload.dependencies = dependenciesOf(vertex, fragment);
+            }
+
+            // the hash of the copies, what gets compiled is what was compared
+            reload.sourceHash = hashOf(ShaderSource::fromString(reload.vertex.c_str()), ShaderSource::fromString(reload.fragment.c_str()));
+            if (reload.sourceHash == program.sourceHash)
+                continue;       // touched but not changed
+            reload.detected = detected;
+
+            std::scoped_lock lock{ m_mutex };
+
+            // replace an older pending reload of the same program
+            std::erase_if(m_pending, [index](const PendingReload& pending) { return pending.program == index; });
+            m_pending.push_back(std::move(reload));
+        }
+    }
+};
+
+
+#endif
@@ -0,0 +1,345 @@
+#ifndef SHADER_SOURCE_H
+#define SHADER_SOURCE_H
+
+#include <glad/glad.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <initializer_list>
+#include <memory>
+#include <filesystem>
+#include <iostream>
+#include <cstdint>
+
+// POSIX memory mapping
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+// read-only memory mapping of a whole file
+class MappedFile
+{
+    const char* m_data{ nullptr };
+    std::size_t m_size{ 0 };
+    bool        m_isOpen{ false };
+
+public:
+    explicit MappedFile(const std::filesystem::path& path)
+    {
+        int fd{ ::open(path.c_str(), O_RDONLY | O_CLOEXEC) };
+        if (fd < 0)
+            return;
+
+        struct stat info{};
+        if (::fstat(fd, &info) == 0)
+        {
+            m_size = static_cast<std::size_t>(info.st_size);
+            m_isOpen = true;
+
+            // mmap can't map an empty file, an empty view is fine though
+            if (m_size > 0)
+            {
+                void* data{ ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0) };
+                if (data == MAP_FAILED)
+                {
+                    m_size = 0;
+                    m_isOpen = false;
+                }
+                else
+                    m_data = static_cast<const char*>(data);
+            }
+        }
+        ::close(fd);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile()
+    {
+        if (m_data)
+            ::munmap(const_cast<char*>(m_data), m_size);
+    }
+
+    bool isOpen() const { return m_isOpen; }
+    std::string_view view() const { return { m_data, m_size }; }
+};
+
+
+// set of preprocessor defines selecting a shader variant, e.g. { { "NR_POINT_LIGHTS", "2" }, { "HAS_EMISSION", "1" } }
+class ShaderDefines
+{
+    std::vector<std::pair<std::string, std::string>> m_defines{};     // sorted by name, so equal sets compare/hash equal
+
+public:
+    ShaderDefines() = default;
+
+    ShaderDefines(std::initializer_list<std::pair<std::string, std::string>> defines)
+    {
+        for (const auto& [name, value] : defines)
+            set(name, value);
+    }
+
+    ShaderDefines& set(const std::string& name, const std::string& value = "1")
+    {
+        auto it{ std::lower_bound(m_defines.begin(), m_defines.end(), name,
+                                  [](const auto& define, const std::string& key) { return define.first < key; }) };
+        if (it != m_defines.end() && it->first == name)
+            it->second = value;
+        else
+            m_defines.insert(it, { name, value });
+        return *this;
+    }
+
+    ShaderDefines& set(const std::string& name, int value) { return set(name, std::to_string(value)); }
+
+    bool empty() const { return m_defines.empty(); }
+
+    // one "#define NAME VALUE" line per define
+    std::string toString() const
+    {
+        std::string result{};
+        for (const auto& [name, value] : m_defines)
+            result += "#define " + name + ' ' + value + '\n';
+        return result;
+    }
+
+    std::uint64_t hash(std::uint64_t hash = 0xcbf29ce484222325ull) const
+    {
+        for (char c : toString())
+        {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    bool operator==(const ShaderDefines&) const = default;
+};
+
+
+/*
+    shader source assembled from memory mapped files
+
+    `#include "path"` directives are resolved relative to the directory of the including file. every file is
+    included at most once per source (like an include guard / #pragma once), and the source
+    is handed to glShaderSource as a list of (pointer, length) segments pointing straight
+    into the mapped files instead of being copied into one concatenated string.
+
+    the files a source depends on (itself + every include) are kept, together with the
+    include edges between them, so callers can tell which programs a changed file affects.
+
+    defines are injected as an extra segment right after the #version line of the main file,
+    shaders give their tunables a default with #ifndef NAME / #define NAME ... / #endif.
+*/
+class ShaderSource
+{
+public:
+    struct File
+    {
+        std::filesystem::path       path{};         // canonical path
+        std::unique_ptr<MappedFile> mapping{};
+        std::vector<std::size_t>    includes{};     // indices of the files this one includes directly
+    };
+
+private:
+    std::vector<File>        m_files{};             // m_files[0] is the main file
+    std::vector<const char*> m_strings{};
+    std::vector<GLint>       m_lengths{};
+    std::unique_ptr<std::string> m_preamble{};      // the defines (heap allocated so segments survive a move)
+    bool                     m_isValid{ true };
+
+public:
+    ShaderSource() = default;
+
+    explicit ShaderSource(const std::filesystem::path& path, const ShaderDefines& defines = {})
+    {
+        if (!defines.empty())
+            m_preamble = std::make_unique<std::string>('\n' + defines.toString());
+
+        m_isValid = appendFile(path, "");
+    }
+
+    // wrap an in-memory string (not copied, it must outlive the ShaderSource)
+    static ShaderSource fromString(const char* code)
+    {
+        ShaderSource source{};
+        source.appendSegment(code);
+        return source;
+    }
+
+    bool isValid() const { return m_isValid; }
+
+    // glShaderSource(shader, getCount(), getStrings(), getLengths())
+    GLsizei getCount() const { return static_cast<GLsizei>(m_strings.size()); }
+    const char* const* getStrings() const { return m_strings.data(); }
+    const GLint* getLengths() const { return m_lengths.data(); }
+
+    const std::vector<File>& getFiles() const { return m_files; }
+
+    // true if `path` is the main file or one of its (transitive) includes
+    bool dependsOn(const std::filesystem::path& path) const
+    {
+        auto canonical{ canonicalOf(path) };
+        for (const auto& file : m_files)
+            if (file.path == canonical)
+                return true;
+        return false;
+    }
+
+    // FNV-1a over every segment, in order
+    std::uint64_t hash(std::uint64_t hash = 0xcbf29ce484222325ull) const
+    {
+        for (std::size_t i{ 0 }; i < m_strings.size(); ++i)
+            for (GLint j{ 0 }; j < m_lengths[i]; ++j)
+            {
+                hash ^= static_cast<unsigned char>(m_strings[i][j]);
+                hash *= 0x100000001b3ull;
+            }
+        return hash;
+    }
+
+    // concatenated source, a copy that outlives the mappings (e.g. handed to another thread)
+    std::string toString() const
+    {
+        std::string result{};
+        for (std::size_t i{ 0 }; i < m_strings.size(); ++i)
+            result.append(m_strings[i], static_cast<std::size_t>(m_lengths[i]));
+        return result;
+    }
+
+private:
+    static std::filesystem::path canonicalOf(const std::filesystem::path& path)
+    {
+        std::error_code error{};
+        auto canonical{ std::filesystem::weakly_canonical(path, error) };
+        return error ? path : canonical;
+    }
+
+    void appendSegment(std::string_view segment)
+    {
+        if (segment.empty())
+            return;
+        m_strings.push_back(segment.data());
+        m_lengths.push_back(static_cast<GLint>(segment.size()));
+    }
+
+    // returns false if the file (or one of its includes) can't be read
+    bool appendFile(const std::filesystem::path& path, std::string_view includedFrom)
+    {
+        auto canonical{ canonicalOf(path) };
+
+        // include guard: every file is pasted only once
+        for (const auto& file : m_files)
+            if (file.path == canonical)
+                return true;
+
+        auto mapping{ std::make_unique<MappedFile>(canonical) };
+        if (!mapping->isOpen())
+        {
+            if (includedFrom.empty())
+                std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << path << '\n';
+            else
+                std::cerr << "ERROR::SHADER::INCLUDE_NOT_FOUND: " << path << " (included from " << includedFrom << ")\n";
+            return false;
+        }
+
+        std::string_view text{ mapping->view() };
+        std::size_t index{ m_files.size() };
+        m_files.push_back({ canonical, std::move(mapping), {} });
+
+        bool success{ true };
+        bool preambleInserted{ !includedFrom.empty() };     // only the main file gets the defines
+        std::size_t segmentStart{ 0 };
+        for (std::size_t lineStart{ 0 }; lineStart < text.size(); )
+        {
+            std::size_t lineEnd{ text.find('\n', lineStart) };
+            if (lineEnd == std::string_view::npos)
+                lineEnd = text.size();
+
+            std::string_view line{ text.substr(lineStart, lineEnd - lineStart) };
+            std::string_view includePath{};
+            if (m_preamble && !preambleInserted && isVersionDirective(line))
+            {
+                // "#version ..." then the defines (they start with the newline ending the version line)
+                appendSegment(text.substr(segmentStart, lineEnd - segmentStart));
+                appendSegment(*m_preamble);
+                preambleInserted = true;
+                segmentStart = lineEnd;
+            }
+            else if (parseInclude(line, includePath))
+            {
+                // everything before the directive, then the included file (the directive line itself is dropped,
+                // its newline is kept and terminates the last line of the included file)
+                appendSegment(text.substr(segmentStart, lineStart - segmentStart));
+
+                auto includedPath{ path.parent_path() / includePath };
+                success = appendFile(includedPath, canonical.native()) && success;
+
+                // record the edge, also when the include was already pasted earlier
+                auto includedCanonical{ canonicalOf(includedPath) };
+                for (std::size_t i{ 0 }; i < m_files.size(); ++i)
+                    if (m_files[i].path == includedCanonical)
+                        m_files[index].includes.push_back(i);
+
+                segmentStart = lineEnd;
+            }
+
+            lineStart = lineEnd + 1;
+        }
+        appendSegment(text.substr(segmentStart));
+
+        // no #version line, defines go first
+        if (!preambleInserted && m_preamble)
+        {
+            m_strings.insert(m_strings.begin(), m_preamble->data());
+            m_lengths.insert(m_lengths.begin(), static_cast<GLint>(m_preamble->size()));
+        }
+
+        return success;
+    }
+
+    static bool isVersionDirective(std::string_view line)
+    {
+        auto start{ line.find_first_not_of(" \t") };
+        return start != std::string_view::npos && line.substr(start, 8) == "#version";
+    }
+
+    // matches: [spaces] # [spaces] include [spaces] "path"
+    static bool parseInclude(std::string_view line, std::string_view& path)
+    {
+        auto skipSpaces{ [&line](std::size_t i) {
+            while (i < line.size() && (line[i] == ' ' || line[i] == '\t'))
+                ++i;
+            return i;
+        } };
+
+        std::size_t i{ skipSpaces(0) };
+        if (i >= line.size() || line[i] != '#')
+            return false;
+
+        i = skipSpaces(i + 1);
+        constexpr std::string_view directive{ "include" };
+        if (line.substr(i, directive.size()) != directive)
+            return false;
+
+        i = skipSpaces(i + directive.size());
+        if (i >= line.size() || line[i] != '"')
+            return false;
+
+        std::size_t end{ line.find('"', i + 1) };
+        if (end == std::string_view::npos)
+            return false;
+
+        path = line.substr(i + 1, end - i - 1);
+        return true;
+    }
+};
+
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef UNIFORM_BUFFER_H
+#define UNIFORM_BUFFER_H
+
+#include <glad/glad.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <type_traits>
+
+
+// uniform block name -> binding point, applied by Shader to every program it links (also on hot reload)
+class UniformBlockBindings
+{
+    static inline std::vector<std::pair<std::string, GLuint>> s_bindings{};
+
+public:
+    static void set(std::string_view blockName, GLuint binding)
+    {
+        for (auto& [name, point] : s_bindings)
+            if (name == blockName)
+            {
+                point = binding;
+                return;
+            }
+        s_bindings.emplace_back(blockName, binding);
+    }
+
+    // bind every registered block the program declares, GL 3.3 has no layout(binding = N) for blocks
+    static void apply(unsigned int program)
+    {
+        for (const auto& [name, binding] : s_bindings)
+        {
+            GLuint index{ glGetUniformBlockIndex(program, name.c_str()) };
+            if (index != GL_INVALID_INDEX)
+                glUniformBlockBinding(program, index, binding);
+        }
+    }
+};
+
+
+/*
+    uniform buffer holding one std140 block, shared by every program that declares the block
+
+    `Block` is a C++ struct laid out exactly like the std140 GLSL block (check the offsets with
+    static_assert). the buffer stays bound to its binding point, so a frame only needs one
+    update() per block instead of setting the uniforms of every program.
+
+    create the buffers before the programs using them are linked, the block name is then
+    bound automatically by Shader.
+*/
+template <typename Block>
+class UniformBuffer
+{
+    static_assert(std::is_trivially_copyable_v<Block>, "uniform block must be trivially copyable");
+    static_assert(sizeof(Block) % 16 == 0, "std140 block size must be a multiple of 16 bytes");
+
+    unsigned int m_ID{ 0 };
+    GLuint       m_binding{ 0 };
+
+public:
+    UniformBuffer(std::string_view blockName, GLuint binding)
+        : m_binding{ binding }
+    {
+        glGenBuffers(1, &m_ID);
+        glBindBuffer(GL_UNIFORM_BUFFER, m_ID);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(Block), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+        glBindBufferBase(GL_UNIFORM_BUFFER, m_binding, m_ID);
+        UniformBlockBindings::set(blockName, m_binding);
+    }
+
+    UniformBuffer(const UniformBuffer&) = delete;
+    UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+    ~UniformBuffer()
+    {
+        glDeleteBuffers(1, &m_ID);
+    }
+
+    // upload the whole block
+    void update(const Block& block)
+    {
+        glBindBuffer(GL_UNIFORM_BUFFER, m_ID);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Block), &block);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    // upload a single member, e.g. update(offsetof(Block, member), sizeof(Block::member), &value)
+    void update(GLintptr offset, GLsizeiptr size, const void* data)
+    {
+        glBindBuffer(GL_UNIFORM_BUFFER, m_ID);
+        glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    unsigned int getID() const { return m_ID; }
+    GLuint getBinding() const { return m_binding; }
+};
+
+
+#endif
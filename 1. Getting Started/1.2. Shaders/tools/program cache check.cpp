@@ -0,0 +1,153 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <shader_header/shader.h>
+#include <shader_header/program_cache.h>
+
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <iostream>
+
+
+//=======================================================================================
+
+
+namespace
+{
+    const char* s_vertexCode{ R"(#version 330 core
+layout (location = 0) in vec3 aPos;
+uniform mat4 model;
+void main()
+{
+    gl_Position = model * vec4(aPos, 1.0);
+}
+)" };
+
+    const char* s_fragmentCode{ R"(#version 330 core
+uniform vec3 color;
+out vec4 FragColor;
+void main()
+{
+    FragColor = vec4(color, 1.0);
+}
+)" };
+
+    int s_failed{ 0 };
+
+    // links the program once and compares the counters it changed with the expected ones
+    void link(const char* step, unsigned int hits, unsigned int misses, unsigned int rejected)
+    {
+        ProgramBinaryCacheStats before{ ProgramBinaryCache::stats };
+        Shader shader{ ShaderSource::fromString(s_vertexCode), ShaderSource::fromString(s_fragmentCode) };
+        const auto& after{ ProgramBinaryCache::stats };
+
+        int linked{};
+        glGetProgramiv(shader.ID, GL_LINK_STATUS, &linked);
+        bool uniformsFound{ shader.getUniformLocation("model") >= 0 && shader.getUniformLocation("color") >= 0 };
+
+        bool passed{ linked && uniformsFound && after.hits - before.hits == hits && after.misses - before.misses == misses
+                     && after.rejected - before.rejected == rejected };
+        std::cout << (passed ? "ok   " : "FAIL ") << step << ": " << after.hits - before.hits << " hit(s), "
+                  << after.misses - before.misses << " miss(es), " << after.rejected - before.rejected << " rejected"
+                  << (linked ? "" : ", not linked") << (uniformsFound ? "" : ", uniforms missing") << '\n';
+        if (!passed)
+            ++s_failed;
+
+        glDeleteProgram(shader.ID);
+    }
+
+    // flips every byte of the second half of each cached binary (the header stays valid)
+    bool corruptBinaries(const std::filesystem::path& directory)
+    {
+        bool corrupted{ false };
+        for (const auto& entry : std::filesystem::directory_iterator{ directory })
+        {
+            if (entry.path().extension() != ".bin")
+                continue;
+
+            std::fstream file{ entry.path(), std::ios::binary | std::ios::in | std::ios::out };
+            std::vector<char> bytes((std::istreambuf_iterator<char>{ file }), std::istreambuf_iterator<char>{});
+            for (std::size_t i{ bytes.size() / 2 }; i < bytes.size(); ++i)
+                bytes[i] = static_cast<char>(~bytes[i]);
+
+            file.clear();
+            file.seekp(0);
+            file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+            corrupted = static_cast<bool>(file);
+        }
+        return corrupted;
+    }
+}
+
+
+/*
+    links the same program against an empty cache directory in the temp directory and checks
+    the counters of ProgramBinaryCache:
+
+        1. first link            1 miss (compiled and stored)
+        2. second link           1 hit
+        3. binary corrupted      1 rejected + 1 miss (compiled again, binary overwritten)
+        4. after the rejection   1 hit
+
+        ./program_cache_check
+
+    a hidden window provides the context, the directory is removed afterwards. returns 1 if a
+    step fails.
+*/
+int main()
+{
+    namespace fs = std::filesystem;
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow* window{ glfwCreateWindow(64, 64, "program cache check", NULL, NULL) };
+    if (!window)
+    {
+        std::cerr << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cerr << "Failed to initialize GLAD" << std::endl;
+        glfwTerminate();
+        return 1;
+    }
+
+    fs::path directory{ fs::temp_directory_path() / "program-cache-check" };
+    std::error_code error{};
+    fs::remove_all(directory, error);
+
+    if (!ProgramBinaryCache::enable(directory, (GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "no program binary formats, nothing to check" << std::endl;
+        glfwTerminate();
+        return 0;
+    }
+
+    link("first link", 0, 1, 0);
+    link("second link", 1, 0, 0);
+
+    if (corruptBinaries(directory))
+        link("corrupted binary", 0, 1, 1);
+    else
+    {
+        std::cout << "FAIL corrupted binary: no binary was stored\n";
+        ++s_failed;
+    }
+    link("after the rejection", 1, 0, 0);
+
+    ProgramBinaryCache::printStats();
+    ProgramBinaryCache::disable();
+    fs::remove_all(directory, error);
+
+    glfwTerminate();
+    return s_failed ? 1 : 0;
+}
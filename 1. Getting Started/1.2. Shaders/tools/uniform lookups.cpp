@@ -0,0 +1,198 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+
+#include <shader_header/shader.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <iostream>
+
+
+//=======================================================================================
+
+
+namespace
+{
+    // the per-frame uniforms of the lighting demos before the uniform buffers
+    const char* s_vertexCode{ R"(#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform mat3 normalMatrix;
+out vec3 Normal;
+out vec3 FragPos;
+void main()
+{
+    FragPos = vec3(model * vec4(aPos, 1.0));
+    Normal = normalMatrix * aNormal;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
+)" };
+
+    const char* s_fragmentCode{ R"(#version 330 core
+struct Light { vec3 position; vec3 ambient; vec3 diffuse; vec3 specular; float constant; float linear; float quadratic; };
+uniform Light pointLights[4];
+uniform vec3 viewPos;
+uniform vec3 color;
+uniform float shininess;
+in vec3 Normal;
+in vec3 FragPos;
+out vec4 FragColor;
+void main()
+{
+    vec3 result = vec3(0.0);
+    for (int i = 0; i < 4; ++i)
+    {
+        float distance = length(pointLights[i].position - FragPos);
+        float attenuation = 1.0 / (pointLights[i].constant + pointLights[i].linear * distance + pointLights[i].quadratic * distance * distance);
+        vec3 lightDir = normalize(pointLights[i].position - FragPos);
+        vec3 reflectDir = reflect(-lightDir, normalize(Normal));
+        float spec = pow(max(dot(normalize(viewPos - FragPos), reflectDir), 0.0), shininess);
+        result += attenuation * (pointLights[i].ambient + pointLights[i].diffuse * max(dot(normalize(Normal), lightDir), 0.0) + pointLights[i].specular * spec);
+    }
+    FragColor = vec4(result * color, 1.0);
+}
+)" };
+
+    // every glGetUniformLocation call goes through here while counting
+    PFNGLGETUNIFORMLOCATIONPROC s_getUniformLocation{};
+    std::size_t s_lookups{ 0 };
+
+    GLint APIENTRY countingGetUniformLocation(GLuint program, const GLchar* name)
+    {
+        ++s_lookups;
+        return s_getUniformLocation(program, name);
+    }
+
+    struct Uniform
+    {
+        std::string name{};
+        GLenum type{};
+        UniformHandle handle{};
+    };
+
+    enum class Path
+    {
+        QUERY,      // glGetUniformLocation per set, what Shader::set* did before
+        NAME,       // Shader::set*(name), hashed lookup in the uniform table
+        HANDLE,     // Shader::set*(handle), resolved once
+    };
+
+    void setUniform(Shader& shader, const Uniform& uniform, Path path)
+    {
+        const glm::mat4 matrix{ 1.0f };
+        const glm::vec3 vector{ 0.5f };
+
+        int location{ -1 };
+        if (path == Path::QUERY)
+            location = glGetUniformLocation(shader.ID, uniform.name.c_str());
+        else if (path == Path::NAME)
+            location = shader.getUniformLocation(uniform.name);
+        else
+            location = shader.getUniformLocation(uniform.handle);
+
+        switch (uniform.type)
+        {
+        case GL_FLOAT_MAT4: glUniformMatrix4fv(location, 1, GL_FALSE, &matrix[0][0]); break;
+        case GL_FLOAT_MAT3: glUniformMatrix3fv(location, 1, GL_FALSE, &glm::mat3{ matrix }[0][0]); break;
+        case GL_FLOAT_VEC3: glUniform3fv(location, 1, &vector[0]); break;
+        default:            glUniform1f(location, 1.0f); break;
+        }
+    }
+}
+
+
+/*
+    sets every uniform of a lighting program for each of a frame's draws, three ways: querying
+    the location with glGetUniformLocation (as Shader::set* did before the uniform table), by name
+    through the table, and by handle. prints the glGetUniformLocation calls and the CPU time per
+    frame of each, the difference is what the table saves:
+
+        ./uniform_lookups [draws per frame]
+
+    a hidden window provides the context.
+*/
+int main(int argc, char* argv[])
+{
+    int draws{ argc > 1 ? std::max(1, std::atoi(argv[1])) : 1000 };
+    constexpr int frames{ 20 };
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow* window{ glfwCreateWindow(64, 64, "uniform lookups", NULL, NULL) };
+    if (!window)
+    {
+        std::cerr << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cerr << "Failed to initialize GLAD" << std::endl;
+        glfwTerminate();
+        return 1;
+    }
+
+    {
+        // link time lookups are counted separately, they happen once per program
+        s_getUniformLocation = glad_glGetUniformLocation;
+        glad_glGetUniformLocation = countingGetUniformLocation;
+
+        Shader shader{ ShaderSource::fromString(s_vertexCode), ShaderSource::fromString(s_fragmentCode) };
+        std::size_t linkLookups{ s_lookups };
+
+        // the uniforms a draw sets, as the demos set them
+        std::vector<Uniform> uniforms{ { "model", GL_FLOAT_MAT4 }, { "view", GL_FLOAT_MAT4 }, { "projection", GL_FLOAT_MAT4 },
+                                       { "normalMatrix", GL_FLOAT_MAT3 }, { "viewPos", GL_FLOAT_VEC3 }, { "color", GL_FLOAT_VEC3 },
+                                       { "shininess", GL_FLOAT } };
+        for (int i{ 0 }; i < 4; ++i)
+        {
+            std::string light{ "pointLights[" + std::to_string(i) + "]." };
+            for (const char* member : { "position", "ambient", "diffuse", "specular" })
+                uniforms.push_back({ light + member, GL_FLOAT_VEC3 });
+            for (const char* member : { "constant", "linear", "quadratic" })
+                uniforms.push_back({ light + member, GL_FLOAT });
+        }
+        for (auto& uniform : uniforms)
+            uniform.handle = shader.uniform(uniform.name);
+
+        shader.use();
+        std::cout << uniforms.size() << " uniforms per draw, " << draws << " draws per frame, "
+                  << linkLookups << " lookups at link time\n";
+
+        for (Path path : { Path::QUERY, Path::NAME, Path::HANDLE })
+        {
+            glFinish();
+            s_lookups = 0;
+            auto start{ std::chrono::steady_clock::now() };
+            for (int frame{ 0 }; frame < frames; ++frame)
+                for (int draw{ 0 }; draw < draws; ++draw)
+                    for (const auto& uniform : uniforms)
+                        setUniform(shader, uniform, path);
+            glFinish();
+            double ms{ std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames };
+
+            const char* name{ path == Path::QUERY ? "glGetUniformLocation" : path == Path::NAME ? "by name" : "by handle" };
+            std::cout << "    " << name << ": " << s_lookups / frames << " glGetUniformLocation calls per frame, " << ms << " ms per frame\n";
+        }
+        std::cout << "saved per frame: " << draws * uniforms.size() << " glGetUniformLocation calls" << std::endl;
+
+        glad_glGetUniformLocation = s_getUniformLocation;
+    }
+
+    glfwTerminate();
+    return 0;
+}
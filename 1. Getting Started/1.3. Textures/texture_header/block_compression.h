@@ -0,0 +1,384 @@
+#ifndef BLOCK_COMPRESSION_H
+#define BLOCK_COMPRESSION_H
+
+#include <vector>
+#include <array>
+#include <span>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>          // std::memcpy
+
+
+/*
+    CPU encoder / decoder of the S3TC and RGTC block formats
+
+        BC1 (DXT1)  RGB, 4 bits per texel
+        BC3 (DXT5)  RGBA: BC1 color + BC4 alpha, 8 bits per texel
+        BC4 (ATI1)  one channel, 4 bits per texel
+        BC5 (ATI2)  two channels (two BC4 blocks), 8 bits per texel
+
+    images are split into 4x4 blocks, blocks at the right/bottom border replicate the last
+    column/row. the encoders are of the fast kind (bounding box of the block, no iterative
+    refinement), good enough for albedo and specular maps; they run in the offline cooker.
+
+    decoding is only needed when the driver lacks GL_EXT_texture_compression_s3tc, the GPU
+    decodes the blocks otherwise.
+*/
+namespace bc
+{
+    enum class Format : std::uint8_t
+    {
+        BC1,
+        BC3,
+        BC4,
+        BC5,
+    };
+
+    constexpr std::size_t blockSize(Format format)
+    {
+        return format == Format::BC1 || format == Format::BC4 ? 8 : 16;
+    }
+
+    constexpr std::size_t levelSize(Format format, int width, int height)
+    {
+        return static_cast<std::size_t>((width + 3) / 4) * static_cast<std::size_t>((height + 3) / 4) * blockSize(format);
+    }
+
+    // 4x4 texels of RGBA8
+    using Block = std::array<std::array<std::uint8_t, 4>, 16>;
+
+    namespace detail
+    {
+        inline std::uint16_t to565(int r, int g, int b)
+        {
+            return static_cast<std::uint16_t>(((r * 31 + 127) / 255) << 11 | ((g * 63 + 127) / 255) << 5 | ((b * 31 + 127) / 255));
+        }
+
+        inline std::array<int, 3> from565(std::uint16_t color)
+        {
+            int r{ (color >> 11) & 31 };
+            int g{ (color >> 5) & 63 };
+            int b{ color & 31 };
+            return { (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2) };
+        }
+
+        inline void store16(std::uint8_t* out, std::uint16_t value)
+        {
+            out[0] = static_cast<std::uint8_t>(value & 0xff);
+            out[1] = static_cast<std::uint8_t>(value >> 8);
+        }
+
+        inline std::uint16_t load16(const std::uint8_t* in)
+        {
+            return static_cast<std::uint16_t>(in[0] | in[1] << 8);
+        }
+
+        // BC1 color part (8 bytes), always in 4 color mode
+        inline void encodeColor(const Block& block, std::uint8_t* out)
+        {
+            std::array<int, 3> low{ 255, 255, 255 };
+            std::array<int, 3> high{ 0, 0, 0 };
+            std::array<int, 3> mean{ 0, 0, 0 };
+            for (const auto& texel : block)
+                for (int c{ 0 }; c < 3; ++c)
+                {
+                    low[c] = std::min<int>(low[c], texel[c]);
+                    high[c] = std::max<int>(high[c], texel[c]);
+                    mean[c] += texel[c];
+                }
+
+            // the box diagonal that follows the colors: green/blue against red
+            int covarianceG{ 0 };
+            int covarianceB{ 0 };
+            for (const auto& texel : block)
+            {
+                int r{ texel[0] * 16 - mean[0] };
+                covarianceG += r * (texel[1] * 16 - mean[1]);
+                covarianceB += r * (texel[2] * 16 - mean[2]);
+            }
+            if (covarianceG < 0)
+                std::swap(low[1], high[1]);
+            if (covarianceB < 0)
+                std::swap(low[2], high[2]);
+
+            // inset the box a little, the extremes are rarely worth an exact endpoint
+            for (int c{ 0 }; c < 3; ++c)
+            {
+                int inset{ (high[c] - low[c]) / 16 };
+                high[c] -= inset;
+                low[c] += inset;
+            }
+
+            std::uint16_t color0{ to565(high[0], high[1], high[2]) };
+            std::uint16_t color1{ to565(low[0], low[1], low[2]) };
+            if (color0 < color1)
+                std::swap(color0, color1);
+
+            store16(out, color0);
+            store16(out + 2, color1);
+
+            std::uint32_t indices{ 0 };
+            if (color0 != color1)
+            {
+                auto c0{ from565(color0) };
+                auto c1{ from565(color1) };
+                std::array<std::array<int, 3>, 4> palette{};
+                for (int c{ 0 }; c < 3; ++c)
+                {
+                    palette[0][c] = c0[c];
+                    palette[1][c] = c1[c];
+                    palette[2][c] = (2 * c0[c] + c1[c]) / 3;
+                    palette[3][c] = (c0[c] + 2 * c1[c]) / 3;
+                }
+
+                for (int i{ 0 }; i < 16; ++i)
+                {
+                    int best{ 0 };
+                    int bestError{ 1 << 30 };
+                    for (int p{ 0 }; p < 4; ++p)
+                    {
+                        int error{ 0 };
+                        for (int c{ 0 }; c < 3; ++c)
+                        {
+                            int d{ block[i][c] - palette[p][c] };
+                            error += d * d;
+                        }
+                        if (error < bestError)
+                        {
+                            bestError = error;
+                            best = p;
+                        }
+                    }
+                    indices |= static_cast<std::uint32_t>(best) << (2 * i);
+                }
+            }
+
+            for (int row{ 0 }; row < 4; ++row)
+                out[4 + row] = static_cast<std::uint8_t>(indices >> (8 * row));
+        }
+
+        inline void decodeColor(const std::uint8_t* in, Block& block)
+        {
+            std::uint16_t color0{ load16(in) };
+            std::uint16_t color1{ load16(in + 2) };
+            auto c0{ from565(color0) };
+            auto c1{ from565(color1) };
+
+            std::array<std::array<int, 4>, 4> palette{};
+            for (int c{ 0 }; c < 3; ++c)
+            {
+                palette[0][c] = c0[c];
+                palette[1][c] = c1[c];
+                if (color0 > color1)
+                {
+                    palette[2][c] = (2 * c0[c] + c1[c]) / 3;
+                    palette[3][c] = (c0[c] + 2 * c1[c]) / 3;
+                }
+                else
+                {
+                    // 3 color mode, the fourth entry is transparent black
+                    palette[2][c] = (c0[c] + c1[c]) / 2;
+                    palette[3][c] = 0;
+                }
+            }
+            palette[0][3] = palette[1][3] = palette[2][3] = 255;
+            palette[3][3] = color0 > color1 ? 255 : 0;
+
+            for (int i{ 0 }; i < 16; ++i)
+            {
+                int index{ (in[4 + i / 4] >> (2 * (i % 4))) & 3 };
+                for (int c{ 0 }; c < 4; ++c)
+                    block[i][c] = static_cast<std::uint8_t>(palette[index][c]);
+            }
+        }
+
+        // BC4 block (8 bytes) of channel `channel`, always in 8 value mode
+        inline void encodeChannel(const Block& block, int channel, std::uint8_t* out)
+        {
+            int low{ 255 };
+            int high{ 0 };
+            for (const auto& texel : block)
+            {
+                low = std::min<int>(low, texel[channel]);
+                high = std::max<int>(high, texel[channel]);
+            }
+
+            out[0] = static_cast<std::uint8_t>(high);
+            out[1] = static_cast<std::uint8_t>(low);
+
+            std::uint64_t indices{ 0 };
+            if (high != low)
+            {
+                for (int i{ 0 }; i < 16; ++i)
+                {
+                    // weight of `high` in sevenths, index 0 is high, 1 is low, 2..7 in between
+                    int weight{ ((block[i][channel] - low) * 7 + (high - low) / 2) / (high - low) };
+                    int index{ weight == 7 ? 0 : weight == 0 ? 1 : 8 - weight };
+                    indices |= static_cast<std::uint64_t>(index) << (3 * i);
+                }
+            }
+
+            for (int byte{ 0 }; byte < 6; ++byte)
+                out[2 + byte] = static_cast<std::uint8_t>(indices >> (8 * byte));
+        }
+
+        inline void decodeChannel(const std::uint8_t* in, int channel, Block& block)
+        {
+            int value0{ in[0] };
+            int value1{ in[1] };
+
+            std::array<int, 8> palette{ value0, value1 };
+            for (int i{ 2 }; i < 8; ++i)
+            {
+                if (value0 > value1)
+                    palette[i] = ((8 - i) * value0 + (i - 1) * value1) / 7;
+                else
+                    palette[i] = i < 6 ? ((6 - i) * value0 + (i - 1) * value1) / 5 : (i == 6 ? 0 : 255);
+            }
+
+            std::uint64_t indices{ 0 };
+            for (int byte{ 0 }; byte < 6; ++byte)
+                indices |= static_cast<std::uint64_t>(in[2 + byte]) << (8 * byte);
+
+            for (int i{ 0 }; i < 16; ++i)
+                block[i][channel] = static_cast<std::uint8_t>(palette[(indices >> (3 * i)) & 7]);
+        }
+
+        // reverse the first `rows` texel rows of a BC1 color block
+        inline void flipColor(std::uint8_t* block, int rows)
+        {
+            std::reverse(block + 4, block + 4 + rows);
+        }
+
+        // reverse the first `rows` texel rows of a BC4 block (12 bits of indices per row)
+        inline void flipChannel(std::uint8_t* block, int rows)
+        {
+            std::uint64_t indices{ 0 };
+            for (int byte{ 0 }; byte < 6; ++byte)
+                indices |= static_cast<std::uint64_t>(block[2 + byte]) << (8 * byte);
+
+            std::uint64_t flipped{ indices };
+            for (int row{ 0 }; row < rows; ++row)
+            {
+                std::uint64_t bits{ (indices >> (12 * row)) & 0xfff };
+                int target{ rows - 1 - row };
+                flipped = (flipped & ~(0xfffull << (12 * target))) | (bits << (12 * target));
+            }
+
+            for (int byte{ 0 }; byte < 6; ++byte)
+                block[2 + byte] = static_cast<std::uint8_t>(flipped >> (8 * byte));
+        }
+    }
+
+    inline void encodeBlock(Format format, const Block& block, std::uint8_t* out)
+    {
+        switch (format)
+        {
+        case Format::BC1: detail::encodeColor(block, out); break;
+        case Format::BC3: detail::encodeChannel(block, 3, out); detail::encodeColor(block, out + 8); break;
+        case Format::BC4: detail::encodeChannel(block, 0, out); break;
+        case Format::BC5: detail::encodeChannel(block, 0, out); detail::encodeChannel(block, 1, out + 8); break;
+        }
+    }
+
+    inline void decodeBlock(Format format, const std::uint8_t* in, Block& block)
+    {
+        block = {};
+        for (auto& texel : block)
+            texel[3] = 255;
+
+        switch (format)
+        {
+        case Format::BC1: detail::decodeColor(in, block); break;
+        case Format::BC3: detail::decodeColor(in + 8, block); detail::decodeChannel(in, 3, block); break;
+        case Format::BC4: detail::decodeChannel(in, 0, block); break;
+        case Format::BC5: detail::decodeChannel(in, 0, block); detail::decodeChannel(in + 8, 1, block); break;
+        }
+    }
+
+    // compress a level of RGBA8 texels (row by row, top first)
+    inline std::vector<std::uint8_t> compress(Format format, std::span<const std::uint8_t> rgba, int width, int height)
+    {
+        std::vector<std::uint8_t> blocks(levelSize(format, width, height));
+        std::uint8_t* out{ blocks.data() };
+
+        for (int y{ 0 }; y < height; y += 4)
+            for (int x{ 0 }; x < width; x += 4)
+            {
+                Block block{};
+                for (int i{ 0 }; i < 16; ++i)
+                {
+                    int px{ std::min(x + i % 4, width - 1) };
+                    int py{ std::min(y + i / 4, height - 1) };
+                    std::memcpy(block[i].data(), rgba.data() + (static_cast<std::size_t>(py) * width + px) * 4, 4);
+                }
+
+                encodeBlock(format, block, out);
+                out += blockSize(format);
+            }
+
+        return blocks;
+    }
+
+    // decompress a level to RGBA8 (missing channels: 0 for color, 255 for alpha)
+    inline std::vector<std::uint8_t> decompress(Format format, std::span<const std::uint8_t> blocks, int width, int height)
+    {
+        std::vector<std::uint8_t> rgba(static_cast<std::size_t>(width) * height * 4);
+        const std::uint8_t* in{ blocks.data() };
+
+        for (int y{ 0 }; y < height; y += 4)
+            for (int x{ 0 }; x < width; x += 4)
+            {
+                Block block{};
+                decodeBlock(format, in, block);
+                in += blockSize(format);
+
+                for (int i{ 0 }; i < 16; ++i)
+                {
+                    int px{ x + i % 4 };
+                    int py{ y + i / 4 };
+                    if (px < width && py < height)
+                        std::memcpy(rgba.data() + (static_cast<std::size_t>(py) * width + px) * 4, block[i].data(), 4);
+                }
+            }
+
+        return rgba;
+    }
+
+    // a level can be flipped in place if no texel row has to move across a block border
+    constexpr bool canFlip(int height)
+    {
+        return height % 4 == 0 || height < 4;
+    }
+
+    // flip a level upside down without decoding it (see canFlip())
+    inline void flip(Format format, std::span<std::uint8_t> blocks, int width, int height)
+    {
+        std::size_t rowSize{ static_cast<std::size_t>((width + 3) / 4) * blockSize(format) };
+        int blockRows{ (height + 3) / 4 };
+        int texelRows{ std::min(height, 4) };
+
+        // block rows in reverse order
+        for (int row{ 0 }; row < blockRows / 2; ++row)
+            std::swap_ranges(blocks.begin() + static_cast<std::ptrdiff_t>(row * rowSize),
+                             blocks.begin() + static_cast<std::ptrdiff_t>((row + 1) * rowSize),
+                             blocks.begin() + static_cast<std::ptrdiff_t>((blockRows - 1 - row) * rowSize));
+
+        // then the texel rows inside every block
+        for (std::size_t offset{ 0 }; offset < blocks.size(); offset += blockSize(format))
+        {
+            std::uint8_t* block{ blocks.data() + offset };
+            switch (format)
+            {
+            case Format::BC1: detail::flipColor(block, texelRows); break;
+            case Format::BC3: detail::flipChannel(block, texelRows); detail::flipColor(block + 8, texelRows); break;
+            case Format::BC4: detail::flipChannel(block, texelRows); break;
+            case Format::BC5: detail::flipChannel(block, texelRows); detail::flipChannel(block + 8, texelRows); break;
+            }
+        }
+    }
+}
+
+
+#endif
@@ -0,0 +1,198 @@
+#ifndef DDS_H
+#define DDS_H
+
+#include <texture_header/block_compression.h>
+
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>          // std::memcmp
+
+
+// block compressed image with its mip chain, as stored in a .dds file
+struct DDSImage
+{
+    struct Level
+    {
+        int         width{};
+        int         height{};
+        std::size_t offset{};           // into data
+        std::size_t size{};
+    };
+
+    bc::Format                format{};
+    std::vector<Level>        levels{};
+    std::vector<std::uint8_t> data{};
+
+    explicit operator bool() const { return !levels.empty(); }
+};
+
+
+/*
+    minimal reader / writer of DirectDraw Surface files: 2D, block compressed (FourCC DXT1,
+    DXT5, ATI1/BC4U, ATI2/BC5U), with or without mipmaps. that's all the texture cooker writes
+    and what common tools (texconv, compressonator, GIMP) produce for these formats.
+
+    levels are stored top row first, like the images decoded by stb_image.
+*/
+namespace dds
+{
+    namespace detail
+    {
+        struct PixelFormat
+        {
+            std::uint32_t size{ 32 };
+            std::uint32_t flags{ 0x4 };             // DDPF_FOURCC
+            char          fourCC[4]{};
+            std::uint32_t rgbBitCount{};
+            std::uint32_t masks[4]{};
+        };
+
+        struct Header
+        {
+            char          magic[4]{ 'D', 'D', 'S', ' ' };
+            std::uint32_t size{ 124 };
+            std::uint32_t flags{ 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000 };       // caps, height, width, pixel format, mipmap count, linear size
+            std::uint32_t height{};
+            std::uint32_t width{};
+            std::uint32_t linearSize{};
+            std::uint32_t depth{};
+            std::uint32_t mipMapCount{};
+            std::uint32_t reserved1[11]{};
+            PixelFormat   pixelFormat{};
+            std::uint32_t caps{ 0x1000 };           // DDSCAPS_TEXTURE
+            std::uint32_t caps2{};
+            std::uint32_t caps3{};
+            std::uint32_t caps4{};
+            std::uint32_t reserved2{};
+        };
+        static_assert(sizeof(Header) == 128, "magic + DDS_HEADER");
+
+        inline const char* fourCC(bc::Format format)
+        {
+            switch (format)
+            {
+            case bc::Format::BC1: return "DXT1";
+            case bc::Format::BC3: return "DXT5";
+            case bc::Format::BC4: return "ATI1";
+            case bc::Format::BC5: return "ATI2";
+            }
+            return "";
+        }
+
+        inline bool formatOf(const char* fourCC, bc::Format& format)
+        {
+            auto is{ [fourCC](const char* code) { return std::memcmp(fourCC, code, 4) == 0; } };
+
+            if (is("DXT1"))                 format = bc::Format::BC1;
+            else if (is("DXT5"))            format = bc::Format::BC3;
+            else if (is("ATI1") || is("BC4U"))  format = bc::Format::BC4;
+            else if (is("ATI2") || is("BC5U"))  format = bc::Format::BC5;
+            else
+                return false;
+            return true;
+        }
+    }
+
+    // empty image if the file is missing, truncated or in a format we don't handle
+    inline DDSImage read(const std::filesystem::path& path)
+    {
+        std::ifstream file{ path, std::ios::binary };
+        if (!file)
+            return {};
+
+        detail::Header header{};
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))
+            || std::memcmp(header.magic, "DDS ", 4) != 0
+            || header.size != 124
+            || !(header.pixelFormat.flags & 0x4))
+            return {};
+
+        DDSImage image{};
+        if (!detail::formatOf(header.pixelFormat.fourCC, image.format) || header.width == 0 || header.height == 0)
+            return {};
+
+        image.data.assign(std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{});
+
+        int width{ static_cast<int>(header.width) };
+        int height{ static_cast<int>(header.height) };
+        std::uint32_t levelCount{ std::max(header.mipMapCount, 1u) };
+        std::size_t offset{ 0 };
+
+        for (std::uint32_t level{ 0 }; level < levelCount; ++level)
+        {
+            std::size_t size{ bc::levelSize(image.format, width, height) };
+            if (offset + size > image.data.size())
+                return {};
+
+            image.levels.push_back({ width, height, offset, size });
+            offset += size;
+
+            if (width == 1 && height == 1)
+                break;
+            width = std::max(width / 2, 1);
+            height = std::max(height / 2, 1);
+        }
+
+        return image;
+    }
+
+    inline bool write(const std::filesystem::path& path, const DDSImage& image)
+    {
+        if (!image)
+            return false;
+
+        detail::Header header{};
+        header.width = static_cast<std::uint32_t>(image.levels[0].width);
+        header.height = static_cast<std::uint32_t>(image.levels[0].height);
+        header.linearSize = static_cast<std::uint32_t>(image.levels[0].size);
+        header.mipMapCount = static_cast<std::uint32_t>(image.levels.size());
+        std::memcpy(header.pixelFormat.fourCC, detail::fourCC(image.format), 4);
+        if (image.levels.size() > 1)
+            header.caps |= 0x8 | 0x400000;         // DDSCAPS_COMPLEX | DDSCAPS_MIPMAP
+
+        // write to a temporary file first so a crash never leaves a truncated image behind
+        auto tempPath{ path };
+        tempPath += ".tmp";
+        {
+            std::ofstream file{ tempPath, std::ios::binary | std::ios::trunc };
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(image.data.data()), static_cast<std::streamsize>(image.data.size()));
+            if (!file)
+                return false;
+        }
+
+        std::error_code error{};
+        std::filesystem::rename(tempPath, path, error);
+        return !error;
+    }
+
+    // cooked version of an image file, written next to it: <image>.dds, or <image>.srgb.dds for
+    // the chain filtered in linear space (color maps loaded with gamma)
+    inline std::filesystem::path cookedPathOf(const std::filesystem::path& source, bool srgb = false)
+    {
+        auto path{ source };
+        path += srgb ? ".srgb.dds" : ".dds";
+        return path;
+    }
+
+    // the cooked file exists and is at least as new as its source
+    inline bool isCookedUpToDate(const std::filesystem::path& source, bool srgb = false)
+    {
+        std::error_code error{};
+        auto cookedTime{ std::filesystem::last_write_time(cookedPathOf(source, srgb), error) };
+        if (error)
+            return false;
+
+        auto sourceTime{ std::filesystem::last_write_time(source, error) };
+        return !error && cookedTime >= sourceTime;
+    }
+}
+
+
+#endif
@@ -0,0 +1,290 @@
+#ifndef MIPMAP_H
+#define MIPMAP_H
+
+#include <vector>
+#include <array>
+#include <span>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MIPMAP_SSE2 1
+#endif
+
+
+// levels 1..n of a texture, level 0 stays with the caller
+struct MipChain
+{
+    struct Level
+    {
+        int         width{};
+        int         height{};
+        std::size_t offset{};           // into data
+        std::size_t size{};
+    };
+
+    std::vector<Level>        levels{};
+    std::vector<std::uint8_t> data{};
+};
+
+
+/*
+    CPU mipmap generation (2x2 box filter, 3 taps along odd sizes), as a replacement for
+    glGenerateMipmap
+
+    it runs on the texture loader threads, so the render thread only uploads the levels, and it
+    doesn't depend on the driver: software rasterizers (llvmpipe) generate mipmaps slowly and on
+    the render thread.
+
+    with srgb the color channels are averaged in linear space (the alpha channel never is), so
+    the smaller levels of a gamma texture don't get darker. a level is half the size of the one
+    above, rounded down; along an odd size (above 1) texel i averages the source texels 2i, 2i+1
+    and 2i+2 weighted 1, 2, 1, so every source texel, the last row/column included, counts the
+    same.
+
+    the linear filter sums rows with SSE2 (16 bytes at a time) where available, RGBA images of
+    even width also sum neighbouring texels with SSE2. the sRGB filter goes through lookup tables.
+*/
+namespace mipmap
+{
+    namespace detail
+    {
+        // sRGB byte -> linear [0, 1]
+        inline const std::array<float, 256>& toLinear()
+        {
+            static const std::array<float, 256> table{ [] {
+                std::array<float, 256> values{};
+                for (int i{ 0 }; i < 256; ++i)
+                {
+                    float c{ i / 255.0f };
+                    values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+                }
+                return values;
+            }() };
+            return table;
+        }
+
+        constexpr int s_srgbSteps{ 4096 };
+
+        // linear [0, 1] in 1/4095 steps -> sRGB byte
+        inline const std::array<std::uint8_t, s_srgbSteps>& toSRGB()
+        {
+            static const std::array<std::uint8_t, s_srgbSteps> table{ [] {
+                std::array<std::uint8_t, s_srgbSteps> values{};
+                for (int i{ 0 }; i < s_srgbSteps; ++i)
+                {
+                    float c{ static_cast<float>(i) / (s_srgbSteps - 1) };
+                    float srgb{ c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f };
+                    values[i] = static_cast<std::uint8_t>(std::clamp(srgb * 255.0f + 0.5f, 0.0f, 255.0f));
+                }
+                return values;
+            }() };
+            return table;
+        }
+
+        // texel i of the next level along an axis of `size` texels averages 2 source texels, or 3 if
+        // the size is odd
+        inline bool threeTaps(int size)
+        {
+            return size > 1 && size % 2 == 1;
+        }
+
+        struct Tap
+        {
+            int index{};
+            int weight{};
+        };
+
+        // source texels of texel i of the next level: 2i, 2i+1 (1, 1) or 2i, 2i+1, 2i+2 (1, 2, 1)
+        inline std::array<Tap, 3> taps(int i, int size)
+        {
+            if (threeTaps(size))
+                return { { { 2 * i, 1 }, { 2 * i + 1, 2 }, { 2 * i + 2, 1 } } };
+            return { { { std::min(2 * i, size - 1), 1 }, { std::min(2 * i + 1, size - 1), 1 }, { 0, 0 } } };
+        }
+
+        // sums[i] = row0[i] + row1[i]
+        inline void sumRows(const std::uint8_t* row0, const std::uint8_t* row1, std::uint16_t* sums, std::size_t count)
+        {
+            std::size_t i{ 0 };
+#ifdef MIPMAP_SSE2
+            const __m128i zero{ _mm_setzero_si128() };
+            for (; i + 16 <= count; i += 16)
+            {
+                __m128i a{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + i)) };
+                __m128i b{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + i)) };
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(sums + i), _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(sums + i + 8), _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero)));
+            }
+#endif
+            for (; i < count; ++i)
+                sums[i] = static_cast<std::uint16_t>(row0[i] + row1[i]);
+        }
+
+        // sums[i] = row0[i] + 2 * row1[i] + row2[i]
+        inline void sumRows(const std::uint8_t* row0, const std::uint8_t* row1, const std::uint8_t* row2, std::uint16_t* sums, std::size_t count)
+        {
+            std::size_t i{ 0 };
+#ifdef MIPMAP_SSE2
+            const __m128i zero{ _mm_setzero_si128() };
+            for (; i + 16 <= count; i += 16)
+            {
+                __m128i a{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + i)) };
+                __m128i b{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + i)) };
+                __m128i c{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(row2 + i)) };
+                __m128i low{ _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(c, zero)) };
+                __m128i high{ _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(c, zero)) };
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(sums + i), _mm_add_epi16(low, _mm_slli_epi16(_mm_unpacklo_epi8(b, zero), 1)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(sums + i + 8), _mm_add_epi16(high, _mm_slli_epi16(_mm_unpackhi_epi8(b, zero), 1)));
+            }
+#endif
+            for (; i < count; ++i)
+                sums[i] = static_cast<std::uint16_t>(row0[i] + 2 * row1[i] + row2[i]);
+        }
+
+        // out texel x = weighted average of the sums texels of taps(x, width), the sums hold
+        // `rowWeight` (2 or 4) rows each
+        inline void sumColumns(const std::uint16_t* sums, std::uint8_t* out, int width, int nextWidth, int channels, int rowWeight)
+        {
+            int x{ 0 };
+#ifdef MIPMAP_SSE2
+            if (channels == 4 && !threeTaps(width))
+            {
+                const int shift{ rowWeight == 4 ? 3 : 2 };
+                const __m128i rounding{ _mm_set1_epi16(static_cast<short>(1 << (shift - 1))) };
+                const __m128i count{ _mm_cvtsi32_si128(shift) };
+                // two output texels from four input texels
+                for (; x + 2 <= nextWidth && 2 * x + 4 <= width; x += 2)
+                {
+                    __m128i t01{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + 8 * x)) };         // texels 2x, 2x+1
+                    __m128i t23{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + 8 * x + 8)) };     // texels 2x+2, 2x+3
+                    __m128i low{ _mm_unpacklo_epi64(t01, t23) };
+                    __m128i high{ _mm_unpackhi_epi64(t01, t23) };
+                    __m128i average{ _mm_srl_epi16(_mm_add_epi16(_mm_add_epi16(low, high), rounding), count) };
+                    _mm_storel_epi64(reinterpret_cast<__m128i*>(out + 4 * x), _mm_packus_epi16(average, average));
+                }
+            }
+#endif
+            for (; x < nextWidth; ++x)
+            {
+                auto texels{ taps(x, width) };
+                int weight{ (texels[0].weight + texels[1].weight + texels[2].weight) * rowWeight };
+                for (int c{ 0 }; c < channels; ++c)
+                {
+                    int sum{ weight / 2 };
+                    for (const auto& tap : texels)
+                        sum += tap.weight * sums[tap.index * channels + c];
+                    out[x * channels + c] = static_cast<std::uint8_t>(sum / weight);
+                }
+            }
+        }
+
+        inline void downsampleSRGB(std::span<const std::uint8_t> pixels, int width, int height, int channels, std::uint8_t* out)
+        {
+            const auto& linear{ toLinear() };
+            const auto& srgb{ toSRGB() };
+            int nextWidth{ std::max(width / 2, 1) };
+            int nextHeight{ std::max(height / 2, 1) };
+
+            for (int y{ 0 }; y < nextHeight; ++y)
+            {
+                auto rows{ taps(y, height) };
+
+                for (int x{ 0 }; x < nextWidth; ++x)
+                {
+                    auto columns{ taps(x, width) };
+                    std::uint8_t* texel{ out + (static_cast<std::size_t>(y) * nextWidth + x) * channels };
+
+                    int weight{ 0 };
+                    for (const auto& row : rows)
+                        for (const auto& column : columns)
+                            weight += row.weight * column.weight;
+
+                    for (int c{ 0 }; c < channels; ++c)
+                    {
+                        int alpha{ weight / 2 };
+                        float sum{ 0.0f };
+                        for (const auto& row : rows)
+                            for (const auto& column : columns)
+                            {
+                                std::uint8_t value{ pixels[(static_cast<std::size_t>(row.index) * width + column.index) * channels + c] };
+                                alpha += row.weight * column.weight * value;
+                                sum += static_cast<float>(row.weight * column.weight) * linear[value];
+                            }
+
+                        if (c == 3)
+                            texel[c] = static_cast<std::uint8_t>(alpha / weight);
+                        else
+                            texel[c] = srgb[static_cast<int>(sum / static_cast<float>(weight) * (s_srgbSteps - 1) + 0.5f)];
+                    }
+                }
+            }
+        }
+    }
+
+    // next level of an image (rows top first, `channels` bytes per texel), written to `out`
+    inline void downsample(std::span<const std::uint8_t> pixels, int width, int height, int channels, bool srgb, std::uint8_t* out)
+    {
+        if (srgb && channels >= 3)
+        {
+            detail::downsampleSRGB(pixels, width, height, channels, out);
+            return;
+        }
+
+        int nextWidth{ std::max(width / 2, 1) };
+        int nextHeight{ std::max(height / 2, 1) };
+        std::size_t rowSize{ static_cast<std::size_t>(width) * channels };
+        std::vector<std::uint16_t> sums(rowSize);
+        bool threeRows{ detail::threeTaps(height) };
+
+        for (int y{ 0 }; y < nextHeight; ++y)
+        {
+            auto rows{ detail::taps(y, height) };
+            const std::uint8_t* row0{ pixels.data() + static_cast<std::size_t>(rows[0].index) * rowSize };
+            const std::uint8_t* row1{ pixels.data() + static_cast<std::size_t>(rows[1].index) * rowSize };
+
+            if (threeRows)
+                detail::sumRows(row0, row1, pixels.data() + static_cast<std::size_t>(rows[2].index) * rowSize, sums.data(), rowSize);
+            else
+                detail::sumRows(row0, row1, sums.data(), rowSize);
+            detail::sumColumns(sums.data(), out + static_cast<std::size_t>(y) * nextWidth * channels, width, nextWidth, channels, threeRows ? 4 : 2);
+        }
+    }
+
+    // every level below `pixels` down to 1x1
+    inline MipChain generate(std::span<const std::uint8_t> pixels, int width, int height, int channels, bool srgb)
+    {
+        MipChain chain{};
+
+        // size of the whole chain up front, the levels are written in place
+        std::size_t total{ 0 };
+        for (int w{ width }, h{ height }; w > 1 || h > 1;)
+        {
+            w = std::max(w / 2, 1);
+            h = std::max(h / 2, 1);
+            std::size_t size{ static_cast<std::size_t>(w) * h * channels };
+            chain.levels.push_back({ w, h, total, size });
+            total += size;
+        }
+        chain.data.resize(total);
+
+        std::span<const std::uint8_t> previous{ pixels };
+        int previousWidth{ width };
+        int previousHeight{ height };
+        for (const auto& level : chain.levels)
+        {
+            downsample(previous, previousWidth, previousHeight, channels, srgb, chain.data.data() + level.offset);
+            previous = { chain.data.data() + level.offset, level.size };
+            previousWidth = level.width;
+            previousHeight = level.height;
+        }
+
+        return chain;
+    }
+}
+
+
+#endif
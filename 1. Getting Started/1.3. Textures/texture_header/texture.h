@@ -5,31 +5,29 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image/stb_image.h>
 
+#include <gl_state_header/gl_state.h>
+#include <texture_header/texture_loader.h>
+#include <texture_header/texture_cache.h>
+
 #include <iostream>
-#include <limits>
 
 
 class Texture
 {
-    static inline unsigned int s_textureUnitCount{ 0 };
-
     int imageWidth{};
     int imageHeight{};
     int nrChannels{};
     unsigned char* imageData{};
+    TextureHandle handle{};         // keeps the cached texture of a file alive
 
 
 public:
-    static inline constexpr unsigned int maxUnitNum{ std::numeric_limits<unsigned int>::max() };
-
-    unsigned int textureUnitNum{ maxUnitNum };      // means no texture loaded
+    // bound to a unit per draw through TextureUnits, textures don't own a unit
     unsigned int textureID;
 
     // texture but basic material actually
     Texture(const unsigned char red=0x0, const unsigned char green=0x0, const unsigned char blue=0x0)
     {
-        textureUnitNum = s_textureUnitCount++;
-
         nrChannels = 3;
 
         imageData = new unsigned char[3];
@@ -47,20 +45,17 @@ public:
         imageData = nullptr;
     }
 
-    Texture(const char* texFilePath, bool flipVertically = true)
+    // shared through the TextureCache: every Texture (and Model) of the same file uses one GL texture.
+    // async: decode on the thread pool, the texture is a placeholder until TextureLoader::shared().update() uploads it
+    Texture(const char* texFilePath, bool flipVertically = true, bool async = false)
     {
-        textureUnitNum = s_textureUnitCount++;
-
-        stbi_set_flip_vertically_on_load(flipVertically);
-        imageData = stbi_load(texFilePath, &imageWidth, &imageHeight, &nrChannels, 0);
+        TextureOptions options{};
+        options.wrap = GL_MIRRORED_REPEAT;
+        options.minFilter = GL_NEAREST;
+        options.flipVertically = flipVertically;
 
-        if(!imageData)
-            std::cerr << "Failed to load texture: " << texFilePath << '\n';
-        else
-            generateTexture();
-    
-        stbi_image_free(imageData);
-        imageData = nullptr;
+        handle = TextureCache::acquire(texFilePath, options, async);
+        textureID = handle.id();
     }
 
 private:
@@ -71,7 +66,7 @@ private:
         glGenTextures(1, &textureID);
 
         // bind texture
-        glBindTexture(GL_TEXTURE_2D, textureID);
+        GLState::bindTexture(GL_TEXTURE_2D, textureID);
 
         // set texture parameters
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
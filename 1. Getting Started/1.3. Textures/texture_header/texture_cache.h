@@ -0,0 +1,229 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <glad/glad.h>
+
+#include <gl_state_header/gl_state.h>
+#include <texture_header/texture_loader.h>
+#include <texture_header/texture_units.h>
+
+#include <string>
+#include <filesystem>
+#include <unordered_map>
+#include <utility>
+#include <cstddef>
+#include <iostream>
+
+
+struct TextureCacheStats
+{
+    unsigned int hits{};
+    unsigned int misses{};
+    unsigned int textures{};            // currently alive
+    std::size_t  bytesResident{};       // GPU size of the alive textures (known once uploaded)
+};
+
+
+class TextureCache;
+
+
+// reference counted texture of the cache, the texture is deleted with its last handle
+class TextureHandle
+{
+    friend class TextureCache;
+
+    struct Entry
+    {
+        unsigned int id{};
+        unsigned int references{};
+        std::size_t  bytes{};
+    };
+    using Node = std::pair<const std::string, Entry>;     // element of the cache map, its address is stable
+
+    Node* m_node{ nullptr };
+
+    explicit TextureHandle(Node* node)
+        : m_node{ node }
+    {
+        ++m_node->second.references;
+    }
+
+public:
+    TextureHandle() = default;
+
+    TextureHandle(const TextureHandle& other)
+        : m_node{ other.m_node }
+    {
+        if (m_node)
+            ++m_node->second.references;
+    }
+
+    TextureHandle(TextureHandle&& other) noexcept
+        : m_node{ std::exchange(other.m_node, nullptr) }
+    {
+    }
+
+    TextureHandle& operator=(TextureHandle other) noexcept
+    {
+        std::swap(m_node, other.m_node);
+        return *this;
+    }
+
+    ~TextureHandle() { reset(); }
+
+    void reset();
+
+    unsigned int id() const { return m_node ? m_node->second.id : 0; }
+    explicit operator bool() const { return m_node != nullptr; }
+};
+
+
+/*
+    process wide cache of the textures loaded from files
+
+    textures are keyed by the canonical absolute path and every option that changes the GL
+    texture (sampling state, flip, mipmaps, gamma), so "./a.png" and "../dir/a.png" share one
+    texture, while a gamma and a linear load of the same file don't.
+
+        TextureHandle diffuse{ TextureCache::acquire("resources/img/container2.png", options) };
+        GLState::bindTexture(0, GL_TEXTURE_2D, diffuse.id());
+
+    handles release their texture from their destructor, which needs the GL context: handles
+    that outlive it (locals of main() destroyed after glfwTerminate()) are dealt with by
+    calling clear() while the context is still current.
+*/
+class TextureCache
+{
+    friend class TextureHandle;
+
+    static inline std::unordered_map<std::string, TextureHandle::Entry> s_textures{};
+    static inline std::unordered_map<unsigned int, TextureHandle::Node*> s_byID{};
+    static inline TextureCacheStats s_stats{};
+    static inline bool s_listening{ false };
+    static inline std::size_t s_lastUploadBytes{ 0 };
+
+public:
+    // async: decoded on the TextureLoader threads, a placeholder until TextureLoader::shared().update() uploads it
+    static TextureHandle acquire(const std::string& path, const TextureOptions& options = {}, bool async = true)
+    {
+        listen();
+
+        auto [it, inserted]{ s_textures.try_emplace(makeKey(path, options)) };
+        if (!inserted && it->second.id != 0)
+        {
+            ++s_stats.hits;
+            return TextureHandle{ &*it };
+        }
+
+        ++s_stats.misses;
+        if (inserted)
+            ++s_stats.textures;
+
+        auto& loader{ TextureLoader::shared() };
+        if (async)
+            it->second.id = loader.load(path, options);
+        else
+        {
+            // the size is reported during loadNow(), before the id is known here
+            s_lastUploadBytes = 0;
+            it->second.id = loader.loadNow(path, options);
+            it->second.bytes = s_lastUploadBytes;
+            s_stats.bytesResident += it->second.bytes;
+        }
+        s_byID[it->second.id] = &*it;
+
+        return TextureHandle{ &*it };
+    }
+
+    // delete every texture now, the handles still alive keep their entry but release it without
+    // GL calls (id() is 0). call before the context goes away (glfwTerminate())
+    static void clear()
+    {
+        for (auto& [key, entry] : s_textures)
+        {
+            if (entry.id == 0)
+                continue;
+            deleteTexture(entry.id);
+            s_stats.bytesResident -= entry.bytes;
+            entry.id = 0;
+            entry.bytes = 0;
+        }
+        s_byID.clear();
+    }
+
+    static const TextureCacheStats& getStats() { return s_stats; }
+
+    static void printStats(std::ostream& out = std::cout)
+    {
+        out << "TextureCache: " << s_stats.textures << " texture(s), " << s_stats.hits << " hit(s), "
+            << s_stats.misses << " miss(es) | " << s_stats.bytesResident / (1024.0 * 1024.0) << " MB resident\n";
+    }
+
+private:
+    static std::string makeKey(const std::string& path, const TextureOptions& options)
+    {
+        std::error_code error{};
+        auto canonical{ std::filesystem::weakly_canonical(std::filesystem::absolute(path, error), error) };
+
+        std::string key{ error ? path : canonical.string() };
+        key += '|' + std::to_string(options.wrap) + ',' + std::to_string(options.minFilter) + ',' + std::to_string(options.magFilter);
+        key += options.flipVertically ? ",flip" : "";
+        key += options.mipmaps ? ",mipmaps" : "";
+        key += options.gamma ? ",srgb" : "";
+        return key;
+    }
+
+    // sizes are only known once the loader uploaded the image
+    static void listen()
+    {
+        if (s_listening)
+            return;
+        s_listening = true;
+
+        TextureLoader::shared().setUploadCallback([](unsigned int texture, std::size_t bytes) {
+            s_lastUploadBytes = bytes;
+            auto it{ s_byID.find(texture) };
+            if (it == s_byID.end())
+                return;
+
+            auto& entry{ it->second->second };
+            s_stats.bytesResident += bytes - entry.bytes;
+            entry.bytes = bytes;
+        });
+    }
+
+    static void release(TextureHandle::Node* node)
+    {
+        auto& entry{ node->second };
+        if (--entry.references != 0)
+            return;
+
+        if (entry.id != 0)      // not deleted by clear()
+        {
+            deleteTexture(entry.id);
+            s_byID.erase(entry.id);
+        }
+
+        --s_stats.textures;
+        s_stats.bytesResident -= entry.bytes;
+        s_textures.erase(s_textures.find(node->first));
+    }
+
+    static void deleteTexture(unsigned int texture)
+    {
+        TextureLoader::shared().cancel(texture);
+        GLState::forgetTexture(texture);
+        TextureUnits::forgetTexture(texture);
+        glDeleteTextures(1, &texture);
+    }
+};
+
+
+inline void TextureHandle::reset()
+{
+    if (m_node)
+        TextureCache::release(std::exchange(m_node, nullptr));
+}
+
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef TEXTURE_COOKER_H
+#define TEXTURE_COOKER_H
+
+// declarations only: the includer may already have compiled the implementation (STB_IMAGE_IMPLEMENTATION)
+#ifndef STBI_INCLUDE_STB_IMAGE_H
+#include <stb_image/stb_image.h>
+#endif
+
+#include <texture_header/block_compression.h>
+#include <texture_header/dds.h>
+#include <texture_header/mipmap.h>
+
+#include <vector>
+#include <string>
+#include <span>
+#include <filesystem>
+#include <algorithm>
+#include <cctype>         // std::tolower
+#include <cstdint>
+#include <cstddef>
+#include <iostream>
+
+
+/*
+    offline conversion of image files to block compressed .dds files with a full mip chain
+
+    the format follows the channels of the source: 1 -> BC4, 2 -> BC5 (grey, alpha), 3 (or 4
+    with an opaque alpha) -> BC1, 4 -> BC3. the result is written next to the source as
+    <image>.dds, where TextureLoader picks it up instead of decoding the original.
+
+    the mips are built by mipmap::generate(), like the loader's. with srgb the color channels of
+    an RGB(A) image are averaged in linear space and the chain goes to <image>.srgb.dds, the
+    file gamma loads use (the linear chain darkens the distant levels of a color map).
+*/
+class TextureCooker
+{
+public:
+    static bool cook(const std::filesystem::path& source, bool srgb = false)
+    {
+        int width{};
+        int height{};
+        int channels{};
+
+        stbi_set_flip_vertically_on_load_thread(false);
+        unsigned char* pixels{ stbi_load(source.string().c_str(), &width, &height, &channels, 4) };
+        if (!pixels)
+        {
+            std::cerr << "ERROR::TEXTURE_COOKER::could not load " << source << ": " << stbi_failure_reason() << std::endl;
+            return false;
+        }
+
+        std::span<const std::uint8_t> level{ pixels, static_cast<std::size_t>(width) * height * 4 };
+
+        // grey + alpha is loaded as (grey, grey, grey, alpha), BC5 stores the first two channels:
+        // move the alpha to the second, so the cooked texture samples the (grey, alpha) a GL_RG
+        // upload of the file does
+        if (channels == 2)
+            for (std::size_t i{ 0 }; i < level.size(); i += 4)
+                pixels[i + 1] = pixels[i + 3];
+        // the loader only applies gamma to RGB(A) images, the filter follows it
+        MipChain mips{ mipmap::generate(level, width, height, 4, srgb && channels >= 3) };
+
+        DDSImage image{};
+        image.format = formatFor(channels, level);
+
+        auto addLevel{ [&image](std::span<const std::uint8_t> rgba, int levelWidth, int levelHeight) {
+            auto blocks{ bc::compress(image.format, rgba, levelWidth, levelHeight) };
+            image.levels.push_back({ levelWidth, levelHeight, image.data.size(), blocks.size() });
+            image.data.insert(image.data.end(), blocks.begin(), blocks.end());
+        } };
+
+        addLevel(level, width, height);
+        for (const auto& mip : mips.levels)
+            addLevel({ mips.data.data() + mip.offset, mip.size }, mip.width, mip.height);
+
+        stbi_image_free(pixels);
+        return dds::write(dds::cookedPathOf(source, srgb), image);
+    }
+
+    // RGB(A) images: color data, may be loaded with gamma
+    static bool isColor(const std::filesystem::path& source)
+    {
+        int width{};
+        int height{};
+        int channels{};
+        return stbi_info(source.string().c_str(), &width, &height, &channels) && channels >= 3;
+    }
+
+    // file types stb_image reads that are worth compressing
+    static bool isImage(const std::filesystem::path& path)
+    {
+        auto extension{ path.extension().string() };
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp";
+    }
+
+private:
+    static bc::Format formatFor(int channels, std::span<const std::uint8_t> rgba)
+    {
+        switch (channels)
+        {
+        case 1: return bc::Format::BC4;
+        case 2: return bc::Format::BC5;
+        case 3: return bc::Format::BC1;
+        default:
+            for (std::size_t i{ 3 }; i < rgba.size(); i += 4)
+                if (rgba[i] != 255)
+                    return bc::Format::BC3;
+            return bc::Format::BC1;
+        }
+    }
+};
+
+
+#endif
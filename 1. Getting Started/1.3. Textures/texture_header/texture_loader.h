@@ -0,0 +1,481 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <glad/glad.h>
+// declarations only: the includer may already have compiled the implementation (STB_IMAGE_IMPLEMENTATION)
+#ifndef STBI_INCLUDE_STB_IMAGE_H
+#include <stb_image/stb_image.h>
+#endif
+
+#include <gl_state_header/gl_state.h>
+#include <thread_header/thread_pool.h>
+#include <texture_header/block_compression.h>
+#include <texture_header/dds.h>
+#include <texture_header/mipmap.h>
+
+#include <string>
+#include <deque>
+#include <array>
+#include <atomic>
+#include <unordered_map>
+#include <thread>
+#include <algorithm>
+#include <functional>
+#include <cstddef>
+#include <cstring>          // std::memcpy
+#include <string_view>
+#include <iostream>
+
+
+// GL_EXT_texture_compression_s3tc (+ GL_EXT_texture_sRGB), not part of any core version
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+
+// sampling state of a loaded texture
+struct TextureOptions
+{
+    GLint wrap{ GL_REPEAT };
+    GLint minFilter{ GL_LINEAR_MIPMAP_LINEAR };
+    GLint magFilter{ GL_LINEAR };
+    bool  flipVertically{ false };
+    bool  mipmaps{ true };
+    bool  gamma{ false };       // color data in sRGB, stored as GL_SRGB8(_ALPHA8) so sampling returns linear values
+    std::array<unsigned char, 4> placeholder{ 0x80, 0x80, 0x80, 0xff };      // RGBA texel shown until the image is uploaded
+};
+
+
+struct TextureLoaderStats
+{
+    unsigned int requested{};
+    unsigned int uploaded{};
+    unsigned int failed{};
+    unsigned int compressed{};          // uploaded from a cooked .dds file
+    unsigned int decompressed{};        // cooked, but decoded on the CPU (format not supported by the driver)
+    std::size_t  uploadedBytes{};       // total
+    std::size_t  frameBytes{};          // by the last update()  (GPU bytes, block compressed levels included)
+};
+
+
+/*
+    loads image files without stalling the render thread
+
+    load() creates the texture right away with a 1x1 placeholder texel, so its id can be bound
+    immediately, and queues the decode (stbi_load) on the thread pool. decoded images come back
+    through a lock-free queue, update() (render thread, once per frame) uploads them, at most
+    `byteBudget` bytes per call (but always at least one image, so a big one can't block the queue).
+
+        unsigned int id{ TextureLoader::shared().load("resources/img/container2.png") };
+        ...
+        while (...)     // render loop
+        {
+            TextureLoader::shared().update();
+            ...
+        }
+
+    if an up to date <path>.dds exists (<path>.srgb.dds for gamma loads, see TextureCooker) the
+    block compressed levels are uploaded instead, no decode and no glGenerateMipmap. without
+    the S3TC extension they are decompressed on the CPU, so cooked files always work.
+
+    with usePixelBuffer the pixels are copied into a pixel unpack buffer, glTexImage2D then only
+    schedules the copy instead of reading client memory before it returns.
+*/
+class TextureLoader
+{
+    // decoded image, travels from the worker to the render thread
+    struct Job
+    {
+        unsigned int   texture{};
+        std::string    path{};
+        TextureOptions options{};
+        unsigned char* pixels{ nullptr };
+        DDSImage       cooked{};                // instead of pixels
+        MipChain       mips{};                  // levels 1..n of pixels, when generated on the CPU
+        bool           cpuMipmaps{};
+        int            width{};
+        int            height{};
+        int            channels{};
+        Job*           next{ nullptr };         // intrusive link of the ready queue
+        bool           cancelled{ false };      // render thread only
+    };
+
+    ThreadPool&       m_pool;
+    std::atomic<Job*> m_ready{ nullptr };       // decoded jobs, pushed by the workers (LIFO, see takeReady())
+    std::atomic<int>  m_decoding{ 0 };
+    std::deque<Job*>  m_uploads{};              // render thread only, in decode order
+
+    std::unordered_map<unsigned int, Job*> m_requests{};    // texture -> job, until uploaded
+    std::function<void(unsigned int texture, std::size_t bytes)> m_onUpload{};
+    bool               m_usePixelBuffer{};
+    bool               m_cpuMipmaps{ true };
+    unsigned int       m_pixelBuffer{ 0 };
+    TextureLoaderStats m_stats{};
+
+public:
+    static constexpr std::size_t s_defaultBudget{ 16 * 1024 * 1024 };      // bytes per update()
+
+    explicit TextureLoader(bool usePixelBuffer = false, ThreadPool& pool = ThreadPool::shared())
+        : m_pool{ pool }
+        , m_usePixelBuffer{ usePixelBuffer }
+    {
+    }
+
+    TextureLoader(const TextureLoader&) = delete;
+    TextureLoader& operator=(const TextureLoader&) = delete;
+
+    ~TextureLoader()
+    {
+        // the workers still reference this loader, their last access is the decrement of m_decoding
+        while (m_decoding.load() != 0)
+            std::this_thread::yield();
+
+        takeReady();
+        for (Job* job : m_uploads)
+            release(job);
+    }
+
+    // loader of the render thread, used by Texture and Model
+    static TextureLoader& shared()
+    {
+        static TextureLoader loader{};
+        return loader;
+    }
+
+    // render thread: create the texture (placeholder content) and start decoding `path`
+    unsigned int load(const std::string& path, const TextureOptions& options = {})
+    {
+        unsigned int texture{ createTexture(options) };
+
+        auto job{ new Job{ texture, path, options } };
+        job->cpuMipmaps = m_cpuMipmaps;
+        m_requests[texture] = job;
+        ++m_stats.requested;
+        ++m_decoding;
+        m_pool.enqueue([this, job]() {
+            decode(*job);
+            push(job);
+            --m_decoding;
+        });
+
+        return texture;
+    }
+
+    // render thread: decode and upload right away (blocking), for callers that need the image before the next frame
+    unsigned int loadNow(const std::string& path, const TextureOptions& options = {})
+    {
+        unsigned int texture{ createTexture(options) };
+
+        Job job{ texture, path, options };
+        job.cpuMipmaps = m_cpuMipmaps;
+        ++m_stats.requested;
+        decode(job);
+        upload(job);
+        stbi_image_free(job.pixels);
+
+        return texture;
+    }
+
+    // generate mipmaps on the loader threads (default) or with glGenerateMipmap on the render thread
+    void setCPUMipmaps(bool cpuMipmaps)
+    {
+        m_cpuMipmaps = cpuMipmaps;
+    }
+
+    // called (render thread) after each upload with the GPU size of the texture, mip chain included
+    void setUploadCallback(std::function<void(unsigned int texture, std::size_t bytes)> onUpload)
+    {
+        m_onUpload = std::move(onUpload);
+    }
+
+    // the texture is about to be deleted, drop its pending upload (GL may reuse the name)
+    void cancel(unsigned int texture)
+    {
+        if (auto it{ m_requests.find(texture) }; it != m_requests.end())
+        {
+            it->second->cancelled = true;
+            m_requests.erase(it);
+        }
+    }
+
+    // render thread, once per frame: upload decoded images within the byte budget
+    void update(std::size_t byteBudget = s_defaultBudget)
+    {
+        takeReady();
+
+        m_stats.frameBytes = 0;
+        while (!m_uploads.empty() && (m_stats.frameBytes == 0 || m_stats.frameBytes < byteBudget))
+        {
+            Job* job{ m_uploads.front() };
+            m_uploads.pop_front();
+
+            if (!job->cancelled)
+            {
+                m_requests.erase(job->texture);
+                upload(*job);
+            }
+            release(job);
+        }
+    }
+
+    // requests not uploaded yet (decoding or waiting for update())
+    std::size_t pending() const { return m_requests.size(); }
+
+    const TextureLoaderStats& getStats() const { return m_stats; }
+
+private:
+    // texture with the sampling state of `options` and the placeholder texel as its only level
+    static unsigned int createTexture(const TextureOptions& options)
+    {
+        unsigned int texture{};
+        glGenTextures(1, &texture);
+        GLState::bindTexture(GL_TEXTURE_2D, texture);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, options.wrap);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, options.wrap);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, options.minFilter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, options.magFilter);
+
+        // a single level, the mipmapped min filters would make it incomplete otherwise
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, options.placeholder.data());
+
+        return texture;
+    }
+
+    // worker thread
+    static void decode(Job& job)
+    {
+        if (dds::isCookedUpToDate(job.path, job.options.gamma) && loadCooked(job))
+            return;
+
+        // the flip flag of stb_image is global, the thread-local one doesn't race with other loads
+        stbi_set_flip_vertically_on_load_thread(job.options.flipVertically);
+        job.pixels = stbi_load(job.path.c_str(), &job.width, &job.height, &job.channels, 0);
+
+        if (job.pixels && job.options.mipmaps && job.cpuMipmaps)
+        {
+            std::span<const std::uint8_t> pixels{ job.pixels, static_cast<std::size_t>(job.width) * job.height * job.channels };
+            job.mips = mipmap::generate(pixels, job.width, job.height, job.channels, job.options.gamma);
+        }
+    }
+
+    // worker thread: lock-free push onto the ready stack
+    void push(Job* job)
+    {
+        job->next = m_ready.load(std::memory_order_relaxed);
+        while (!m_ready.compare_exchange_weak(job->next, job, std::memory_order_release, std::memory_order_relaxed))
+            ;
+    }
+
+    // worker thread
+    static bool loadCooked(Job& job)
+    {
+        DDSImage image{ dds::read(dds::cookedPathOf(job.path, job.options.gamma)) };
+        if (!image)
+            return false;
+
+        if (!job.options.mipmaps)
+            image.levels.resize(1);
+
+        // the blocks can only be flipped as they are if no texel row crosses a block border
+        if (job.options.flipVertically)
+        {
+            for (const auto& level : image.levels)
+                if (!bc::canFlip(level.height))
+                    return false;
+
+            for (const auto& level : image.levels)
+                bc::flip(image.format, { image.data.data() + level.offset, level.size }, level.width, level.height);
+        }
+
+        job.cooked = std::move(image);
+        return true;
+    }
+
+    // render thread: take every ready job at once (single consumer, so no ABA) and restore their order
+    void takeReady()
+    {
+        Job* job{ m_ready.exchange(nullptr, std::memory_order_acquire) };
+
+        std::size_t first{ m_uploads.size() };
+        for (; job; job = job->next)
+            m_uploads.push_back(job);
+        std::reverse(m_uploads.begin() + static_cast<std::ptrdiff_t>(first), m_uploads.end());
+    }
+
+    void upload(const Job& job)
+    {
+        if (job.cooked)
+        {
+            uploadCooked(job);
+            return;
+        }
+
+        if (!job.pixels)
+        {
+            std::cerr << "Texture failed to load at path: " << job.path << std::endl;
+            ++m_stats.failed;
+            return;
+        }
+
+        GLenum format{ GL_RGBA };
+        if (job.channels == 1)
+            format = GL_RED;
+        else if (job.channels == 2)
+            format = GL_RG;
+        else if (job.channels == 3)
+            format = GL_RGB;
+
+        GLenum internalFormat{ format };
+        if (job.options.gamma && job.channels >= 3)
+            internalFormat = job.channels == 3 ? GL_SRGB8 : GL_SRGB8_ALPHA8;
+
+        std::size_t size{ static_cast<std::size_t>(job.width) * job.height * job.channels };
+        const void* pixels{ job.pixels };
+
+        GLState::bindTexture(GL_TEXTURE_2D, job.texture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);      // rows of RGB images aren't 4 byte aligned
+
+        if (m_usePixelBuffer && copyToPixelBuffer(job.pixels, size))
+            pixels = nullptr;                       // offset 0 into the bound unpack buffer
+
+        glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(internalFormat), job.width, job.height, 0, format, GL_UNSIGNED_BYTE, pixels);
+
+        if (m_pixelBuffer)
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        // levels generated by the worker, every one uploaded explicitly
+        for (std::size_t i{ 0 }; i < job.mips.levels.size(); ++i)
+        {
+            const auto& level{ job.mips.levels[i] };
+            glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i + 1), static_cast<GLint>(internalFormat), level.width, level.height, 0,
+                         format, GL_UNSIGNED_BYTE, job.mips.data.data() + level.offset);
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+        if (job.options.mipmaps && job.mips.levels.empty())
+            glGenerateMipmap(GL_TEXTURE_2D);
+
+        std::size_t bytes{ size + job.mips.data.size() };
+        ++m_stats.uploaded;
+        m_stats.uploadedBytes += bytes;
+        m_stats.frameBytes += bytes;
+
+        // a full mip chain adds a third
+        if (m_onUpload)
+            m_onUpload(job.texture, job.options.mipmaps ? size + size / 3 : size);
+    }
+
+    void uploadCooked(const Job& job)
+    {
+        const DDSImage& image{ job.cooked };
+        GLenum format{ compressedFormat(image.format, job.options.gamma) };
+
+        GLState::bindTexture(GL_TEXTURE_2D, job.texture);
+
+        std::size_t bytes{ 0 };
+        for (std::size_t i{ 0 }; i < image.levels.size(); ++i)
+        {
+            const auto& level{ image.levels[i] };
+            auto mip{ static_cast<GLint>(i) };
+
+            if (format != GL_NONE)
+            {
+                glCompressedTexImage2D(GL_TEXTURE_2D, mip, format, level.width, level.height, 0,
+                                       static_cast<GLsizei>(level.size), image.data.data() + level.offset);
+                bytes += level.size;
+            }
+            else
+            {
+                auto rgba{ bc::decompress(image.format, { image.data.data() + level.offset, level.size }, level.width, level.height) };
+                GLint internalFormat{ job.options.gamma ? GL_SRGB8_ALPHA8 : GL_RGBA8 };
+                glTexImage2D(GL_TEXTURE_2D, mip, internalFormat, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+                bytes += rgba.size();
+            }
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(image.levels.size() - 1));
+
+        ++m_stats.uploaded;
+        if (format != GL_NONE)
+            ++m_stats.compressed;
+        else
+            ++m_stats.decompressed;
+        m_stats.uploadedBytes += bytes;
+        m_stats.frameBytes += bytes;
+
+        if (m_onUpload)
+            m_onUpload(job.texture, bytes);
+    }
+
+    // GL format of a block format, GL_NONE if the driver can't sample it
+    static GLenum compressedFormat(bc::Format format, bool gamma)
+    {
+        // RGTC is core since 3.0, but has no sRGB variant
+        if (format == bc::Format::BC4 || format == bc::Format::BC5)
+            return format == bc::Format::BC4 ? GL_COMPRESSED_RED_RGTC1 : GL_COMPRESSED_RG_RGTC2;
+
+        static const bool s3tc{ hasExtension("GL_EXT_texture_compression_s3tc") };
+        static const bool s3tcSRGB{ s3tc && (hasExtension("GL_EXT_texture_sRGB") || hasExtension("GL_EXT_texture_compression_s3tc_srgb")) };
+        if (!s3tc || (gamma && !s3tcSRGB))
+            return GL_NONE;
+
+        if (format == bc::Format::BC1)
+            return gamma ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        return gamma ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    }
+
+    static bool hasExtension(std::string_view name)
+    {
+        GLint count{ 0 };
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i{ 0 }; i < count; ++i)
+        {
+            auto extension{ reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i))) };
+            if (extension && name == extension)
+                return true;
+        }
+        return false;
+    }
+
+    // leaves the buffer bound on success
+    bool copyToPixelBuffer(const unsigned char* pixels, std::size_t size)
+    {
+        if (m_pixelBuffer == 0)
+            glGenBuffers(1, &m_pixelBuffer);
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pixelBuffer);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(size), nullptr, GL_STREAM_DRAW);      // orphan
+
+        void* destination{ glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(size), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT) };
+        if (!destination)
+        {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            return false;
+        }
+
+        std::memcpy(destination, pixels, size);
+        if (!glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER))
+        {
+            // contents lost (e.g. display mode change), upload from client memory instead
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            return false;
+        }
+        return true;
+    }
+
+    static void release(Job* job)
+    {
+        stbi_image_free(job->pixels);
+        delete job;
+    }
+};
+
+
+#endif
@@ -0,0 +1,442 @@
+#ifndef TEXTURE_RESIDENCY_H
+#define TEXTURE_RESIDENCY_H
+
+#include <glad/glad.h>
+// declarations only: the includer may already have compiled the implementation (STB_IMAGE_IMPLEMENTATION)
+#ifndef STBI_INCLUDE_STB_IMAGE_H
+#include <stb_image/stb_image.h>
+#endif
+#include <glm/glm.hpp>
+
+#include <gl_state_header/gl_state.h>
+#include <thread_header/thread_pool.h>
+#include <texture_header/texture_loader.h>      // TextureOptions
+#include <texture_header/texture_units.h>
+#include <texture_header/mipmap.h>
+#include <camera_header/camera.h>
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <iostream>
+
+
+struct TextureResidencyStats
+{
+    std::size_t  residentBytes{};       // GPU size of the resident levels
+    std::size_t  budgetBytes{};
+    unsigned int textures{};
+    unsigned int pending{};             // decoding, or requested finer than resident (streaming in)
+    unsigned int streamedLevels{};      // total
+    unsigned int evictedLevels{};       // total
+};
+
+
+/*
+    streams the mip levels of textures in and out of GPU memory by how large they appear on screen
+
+    a texture starts with only its small levels resident (the largest one at most s_startSize
+    texels across). every frame the renderer requests the level it needs, from the projected size
+    of the object it is drawn on (camera fov and distance), and update() uploads the next finer
+    level of the requested textures, one level per texture per frame, within a per-frame upload
+    budget. the resident levels are [GL_TEXTURE_BASE_LEVEL, last], so the sampler never reads a
+    missing level.
+
+    the VRAM budget is kept by evicting the finest levels of the least recently requested
+    textures (a level is freed by respecifying it as 0x0). the whole mip chain stays in system
+    memory, decoded once on the thread pool, so levels come back without touching the disk. the
+    start levels count as resident bytes but are never evicted.
+
+        TextureResidency residency{ 256 * 1024 * 1024 };
+        unsigned int id{ residency.add("resources/img/container2.png") };
+        ...
+        while (...)     // render loop
+        {
+            residency.request(id, camera, objectCenter, objectRadius, viewportHeight);
+            residency.update();
+            ...
+        }
+*/
+class TextureResidency
+{
+    struct Level
+    {
+        int         width{};
+        int         height{};
+        std::size_t offset{};           // into Entry::data
+        std::size_t size{};
+    };
+
+    struct Entry
+    {
+        unsigned int              texture{};
+        std::string               path{};
+        TextureOptions            options{};
+        std::uint64_t             serial{};         // matches the decode of this entry (texture names are reused)
+        bool                      decoded{};
+        std::vector<Level>        levels{};
+        std::vector<std::uint8_t> data{};
+        GLenum                    format{};
+        GLenum                    internalFormat{};
+        int                       base{ -1 };       // finest resident level, -1 until decoded
+        int                       start{};          // level resident from the start, never evicted
+        int                       wanted{};         // finest level requested for the current frame
+        std::uint64_t             lastUse{};        // frame of the last request
+        std::size_t               residentBytes{};
+    };
+
+    // decoded chain, travels from the worker to the render thread
+    struct Decoded
+    {
+        unsigned int              texture{};
+        std::uint64_t             serial{};
+        std::vector<Level>        levels{};
+        std::vector<std::uint8_t> data{};
+        int                       channels{};
+    };
+
+    ThreadPool&                             m_pool;
+    std::unordered_map<unsigned int, Entry> m_entries{};
+    std::mutex                              m_mutex{};
+    std::vector<std::unique_ptr<Decoded>>   m_decoded{};        // guarded by m_mutex
+    std::atomic<int>                        m_decoding{ 0 };
+    std::uint64_t                           m_nextSerial{ 1 };
+    std::uint64_t                           m_frame{ 1 };
+    TextureResidencyStats                   m_stats{};
+
+public:
+    static constexpr int s_startSize{ 64 };                                 // texels, largest level resident from the start
+    static constexpr std::size_t s_defaultUploadBudget{ 8 * 1024 * 1024 };  // bytes per update()
+    static constexpr std::size_t s_defaultBudget{ 256 * 1024 * 1024 };       // VRAM of the shared instance
+
+    explicit TextureResidency(std::size_t budgetBytes, ThreadPool& pool = ThreadPool::shared())
+        : m_pool{ pool }
+    {
+        m_stats.budgetBytes = budgetBytes;
+    }
+
+    // residency of the render thread, used by Model (streamTextures)
+    static TextureResidency& shared()
+    {
+        static TextureResidency residency{ s_defaultBudget };
+        return residency;
+    }
+
+    TextureResidency(const TextureResidency&) = delete;
+    TextureResidency& operator=(const TextureResidency&) = delete;
+
+    ~TextureResidency()
+    {
+        // the workers still reference this object, their last access is the decrement of m_decoding
+        while (m_decoding.load() != 0)
+            std::this_thread::yield();
+    }
+
+    // render thread: create the texture (placeholder texel) and decode the image and its mip chain on the pool
+    unsigned int add(const std::string& path, const TextureOptions& options = {})
+    {
+        unsigned int texture{};
+        glGenTextures(1, &texture);
+        GLState::bindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, options.wrap);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, options.wrap);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, options.minFilter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, options.magFilter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, options.placeholder.data());
+
+        std::uint64_t serial{ m_nextSerial++ };
+        m_entries[texture] = { texture, path, options, serial };
+        ++m_stats.textures;
+
+        ++m_decoding;
+        m_pool.enqueue([this, texture, serial, path, flip = options.flipVertically, srgb = options.gamma]() {
+            auto decoded{ decode(path, flip, srgb) };
+            decoded->texture = texture;
+            decoded->serial = serial;
+            {
+                std::scoped_lock lock{ m_mutex };
+                m_decoded.push_back(std::move(decoded));
+            }
+            --m_decoding;
+        });
+
+        return texture;
+    }
+
+    // render thread: delete the texture, a decode still running is dropped when it arrives
+    void remove(unsigned int texture)
+    {
+        auto it{ m_entries.find(texture) };
+        if (it == m_entries.end())
+            return;
+
+        m_stats.residentBytes -= it->second.residentBytes;
+        --m_stats.textures;
+        m_entries.erase(it);
+
+        GLState::forgetTexture(texture);
+        TextureUnits::forgetTexture(texture);
+        glDeleteTextures(1, &texture);
+    }
+
+    // render thread: delete every texture while the context is current (before glfwTerminate()),
+    // later remove() calls of their owners do nothing
+    void clear()
+    {
+        for (const auto& [texture, entry] : m_entries)
+        {
+            GLState::forgetTexture(texture);
+            TextureUnits::forgetTexture(texture);
+            glDeleteTextures(1, &texture);
+        }
+        m_entries.clear();
+        m_stats.residentBytes = 0;
+        m_stats.textures = 0;
+    }
+
+    // level that maps about one texel to one pixel: `texels` across an object of `radius` at `distance`
+    static int levelFor(int texels, float radius, float distance, float fovDegrees, int viewportHeight)
+    {
+        if (distance <= radius)
+            return 0;
+
+        // diameter in pixels, (2 * radius) / (2 * distance * tan(fov / 2)) of the viewport height
+        float pixels{ radius / (distance * std::tan(glm::radians(fovDegrees) * 0.5f)) * static_cast<float>(viewportHeight) };
+        if (pixels <= 1.0f)
+            return std::max(0, static_cast<int>(std::log2(static_cast<float>(texels))));
+        return std::max(0, static_cast<int>(std::floor(std::log2(static_cast<float>(texels) / pixels))));
+    }
+
+    // render thread: the texture is drawn this frame on an object (bounding sphere in world space)
+    void request(unsigned int texture, const Camera& camera, const glm::vec3& center, float radius, int viewportHeight)
+    {
+        auto it{ m_entries.find(texture) };
+        if (it == m_entries.end())
+            return;
+
+        Entry& entry{ it->second };
+        int texels{ entry.levels.empty() ? s_startSize : std::max(entry.levels[0].width, entry.levels[0].height) };
+        request(texture, levelFor(texels, radius, glm::length(center - camera.position), camera.fov, viewportHeight));
+    }
+
+    // render thread: the texture needs `level` (or finer) this frame, several requests keep the finest
+    void request(unsigned int texture, int level)
+    {
+        auto it{ m_entries.find(texture) };
+        if (it == m_entries.end())
+            return;
+
+        Entry& entry{ it->second };
+        entry.wanted = entry.lastUse == m_frame ? std::min(entry.wanted, level) : level;
+        entry.lastUse = m_frame;
+    }
+
+    // render thread, once per frame after the requests: make the decoded textures resident, stream
+    // in the requested levels within `uploadBudget` bytes, evict to stay under the VRAM budget
+    void update(std::size_t uploadBudget = s_defaultUploadBudget)
+    {
+        takeDecoded();
+
+        // the textures missing the most levels first
+        std::vector<Entry*> streaming{};
+        for (auto& [texture, entry] : m_entries)
+            if (entry.decoded && entry.lastUse == m_frame && entry.wanted < entry.base)
+                streaming.push_back(&entry);
+        std::sort(streaming.begin(), streaming.end(), [](const Entry* a, const Entry* b) {
+            return a->base - a->wanted > b->base - b->wanted;
+        });
+
+        std::size_t frameBytes{ 0 };
+        for (Entry* entry : streaming)
+        {
+            const Level& level{ entry->levels[static_cast<std::size_t>(entry->base - 1)] };
+            if (frameBytes != 0 && frameBytes + level.size > uploadBudget)
+                break;
+            if (!makeRoom(level.size, entry))
+                break;
+
+            streamIn(*entry);
+            frameBytes += level.size;
+        }
+
+        m_stats.pending = 0;
+        for (const auto& [texture, entry] : m_entries)
+            if (!entry.decoded || (entry.lastUse == m_frame && entry.wanted < entry.base))
+                ++m_stats.pending;
+
+        ++m_frame;
+    }
+
+    // resident level range of a texture, for debugging: { base, last }, { -1, -1 } until decoded
+    std::pair<int, int> residentLevels(unsigned int texture) const
+    {
+        auto it{ m_entries.find(texture) };
+        if (it == m_entries.end() || !it->second.decoded)
+            return { -1, -1 };
+        return { it->second.base, static_cast<int>(it->second.levels.size()) - 1 };
+    }
+
+    const TextureResidencyStats& getStats() const { return m_stats; }
+
+    void printStats(std::ostream& out = std::cout) const
+    {
+        out << "TextureResidency: " << m_stats.textures << " texture(s), " << m_stats.pending << " pending | "
+            << m_stats.residentBytes / (1024.0 * 1024.0) << " of " << m_stats.budgetBytes / (1024.0 * 1024.0) << " MB resident | "
+            << m_stats.streamedLevels << " level(s) streamed, " << m_stats.evictedLevels << " evicted\n";
+    }
+
+private:
+    // worker thread: the image and every level below it, tightly packed
+    static std::unique_ptr<Decoded> decode(const std::string& path, bool flip, bool srgb)
+    {
+        auto decoded{ std::make_unique<Decoded>() };
+
+        // the flip flag of stb_image is global, the thread-local one doesn't race with other loads
+        stbi_set_flip_vertically_on_load_thread(flip);
+        int width{};
+        int height{};
+        unsigned char* pixels{ stbi_load(path.c_str(), &width, &height, &decoded->channels, 0) };
+        if (!pixels)
+            return decoded;
+
+        std::size_t size{ static_cast<std::size_t>(width) * height * decoded->channels };
+        MipChain chain{ mipmap::generate({ pixels, size }, width, height, decoded->channels, srgb) };
+
+        decoded->data.resize(size + chain.data.size());
+        std::copy_n(pixels, size, decoded->data.begin());
+        std::copy(chain.data.begin(), chain.data.end(), decoded->data.begin() + static_cast<std::ptrdiff_t>(size));
+        stbi_image_free(pixels);
+
+        decoded->levels.push_back({ width, height, 0, size });
+        for (const auto& level : chain.levels)
+            decoded->levels.push_back({ level.width, level.height, size + level.offset, level.size });
+
+        return decoded;
+    }
+
+    // the coarse levels of every texture decoded since the last frame
+    void takeDecoded()
+    {
+        std::vector<std::unique_ptr<Decoded>> decoded{};
+        {
+            std::scoped_lock lock{ m_mutex };
+            decoded.swap(m_decoded);
+        }
+
+        for (auto& image : decoded)
+        {
+            auto it{ m_entries.find(image->texture) };
+            if (it == m_entries.end() || it->second.serial != image->serial)
+                continue;       // removed while decoding
+
+            Entry& entry{ it->second };
+            if (image->levels.empty())
+            {
+                std::cerr << "Texture failed to load at path: " << entry.path << std::endl;
+                continue;
+            }
+
+            entry.format = GL_RGBA;
+            if (image->channels == 1)
+                entry.format = GL_RED;
+            else if (image->channels == 2)
+                entry.format = GL_RG;
+            else if (image->channels == 3)
+                entry.format = GL_RGB;
+            entry.internalFormat = entry.format;
+            if (entry.options.gamma && image->channels >= 3)
+                entry.internalFormat = image->channels == 3 ? GL_SRGB8 : GL_SRGB8_ALPHA8;
+
+            entry.levels = std::move(image->levels);
+            entry.data = std::move(image->data);
+            entry.decoded = true;
+
+            // without mipmaps the only level is resident, there is nothing to stream
+            if (!entry.options.mipmaps)
+                entry.levels.resize(1);
+
+            int last{ static_cast<int>(entry.levels.size()) - 1 };
+            entry.start = last;
+            while (entry.start > 0 && std::max(entry.levels[static_cast<std::size_t>(entry.start - 1)].width,
+                                               entry.levels[static_cast<std::size_t>(entry.start - 1)].height) <= s_startSize)
+                --entry.start;
+
+            // the placeholder of level 0 is outside [base, last] from here on
+            GLState::bindTexture(GL_TEXTURE_2D, entry.texture);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, last);
+            entry.base = last + 1;
+            while (entry.base > entry.start)
+                streamIn(entry);
+        }
+    }
+
+    // upload the next finer level and make it the base level
+    void streamIn(Entry& entry)
+    {
+        auto mip{ entry.base - 1 };
+        const Level& level{ entry.levels[static_cast<std::size_t>(mip)] };
+
+        GLState::bindTexture(GL_TEXTURE_2D, entry.texture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);      // rows of RGB images aren't 4 byte aligned
+        glTexImage2D(GL_TEXTURE_2D, mip, static_cast<GLint>(entry.internalFormat), level.width, level.height, 0,
+                     entry.format, GL_UNSIGNED_BYTE, entry.data.data() + level.offset);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, mip);
+
+        entry.base = mip;
+        entry.residentBytes += level.size;
+        m_stats.residentBytes += level.size;
+        ++m_stats.streamedLevels;
+    }
+
+    // free the finest resident level (never below the start level)
+    void evict(Entry& entry)
+    {
+        const Level& level{ entry.levels[static_cast<std::size_t>(entry.base)] };
+
+        GLState::bindTexture(GL_TEXTURE_2D, entry.texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, entry.base + 1);
+        glTexImage2D(GL_TEXTURE_2D, entry.base, static_cast<GLint>(entry.internalFormat), 0, 0, 0, entry.format, GL_UNSIGNED_BYTE, nullptr);
+
+        ++entry.base;
+        entry.residentBytes -= level.size;
+        m_stats.residentBytes -= level.size;
+        ++m_stats.evictedLevels;
+    }
+
+    // evict until `bytes` more fit in the budget, false if only levels in use are left
+    bool makeRoom(std::size_t bytes, const Entry* keep)
+    {
+        while (m_stats.residentBytes + bytes > m_stats.budgetBytes)
+        {
+            // least recently requested first, levels finer than requested count as unused
+            Entry* victim{ nullptr };
+            for (auto& [texture, entry] : m_entries)
+            {
+                if (&entry == keep || !entry.decoded || entry.base >= entry.start)
+                    continue;
+                if (entry.lastUse == m_frame && entry.base >= entry.wanted)
+                    continue;
+                if (!victim || entry.lastUse < victim->lastUse)
+                    victim = &entry;
+            }
+
+            if (!victim)
+                return false;
+            evict(*victim);
+        }
+        return true;
+    }
+};
+
+
+#endif
@@ -0,0 +1,144 @@
+#ifndef TEXTURE_UNITS_H
+#define TEXTURE_UNITS_H
+
+#include <glad/glad.h>
+
+#include <gl_state_header/gl_state.h>
+#include <shader_header/shader.h>
+
+#include <array>
+#include <string_view>
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+
+
+struct TextureUnitStats
+{
+    unsigned int reused{};          // the texture was still bound to a unit
+    unsigned int bound{};           // the texture took over the least recently used unit
+    unsigned int overflows{};       // a draw used more textures than there are units
+};
+
+
+/*
+    texture unit allocator, units are handed out per draw instead of once per texture
+
+    a texture that is still bound to a unit keeps it, otherwise it takes the unit that was used
+    the longest time ago. units used by the current draw (since the last beginDraw()) are never
+    taken, so a draw can use every unit at once. any number of textures can be loaded, and
+    consecutive draws that share maps don't rebind them.
+
+        TextureUnits::beginDraw();
+        TextureUnits::bind(shader, "material.diffuse", GL_TEXTURE_2D, diffuse.textureID);
+        TextureUnits::bind(shader, "material.specular", GL_TEXTURE_2D, specular.textureID);
+        glDrawArrays(...);
+
+    the shader must be in use, its sampler uniforms are set through GLState::setSampler() and
+    only change when a map lands on another unit.
+*/
+class TextureUnits
+{
+    static constexpr unsigned int s_maxUnits{ GLState::trackedTextureUnits() };
+
+    // zero initialized, a target of 0 is a unit that nothing was bound to through the allocator
+    struct Unit
+    {
+        GLenum        target;
+        unsigned int  texture;
+        std::uint64_t lastUse;
+    };
+
+    static inline std::array<Unit, s_maxUnits> s_units{};
+    static inline unsigned int s_unitCount{ 0 };            // queried on the first bind, needs a context
+    static inline std::uint64_t s_draw{ 1 };                // units with lastUse == s_draw belong to the current draw
+    static inline TextureUnitStats s_stats{};
+
+public:
+    // units bound after this call may be taken by textures of the previous draws again
+    static void beginDraw() { ++s_draw; }
+
+    // unit of `texture`, bound to it if it isn't already
+    static unsigned int bind(GLenum target, unsigned int texture)
+    {
+        if (s_unitCount == 0)
+            queryUnitCount();
+
+        unsigned int unit{ find(target, texture) };
+        if (unit < s_unitCount)
+            ++s_stats.reused;
+        else
+        {
+            unit = leastRecentlyUsed();
+            s_units[unit].target = target;
+            s_units[unit].texture = texture;
+            ++s_stats.bound;
+        }
+
+        s_units[unit].lastUse = s_draw;
+
+        // filtered by GLState if the unit still holds the texture, issued again if GLState was invalidated
+        GLState::bindTexture(unit, target, texture);
+        return unit;
+    }
+
+    // binds `texture` and points the sampler uniform of the shader (in use) at its unit
+    static unsigned int bind(const Shader& shader, std::string_view sampler, GLenum target, unsigned int texture)
+    {
+        unsigned int unit{ bind(target, texture) };
+        GLState::setSampler(shader.getUniformLocation(sampler), static_cast<int>(unit));
+        return unit;
+    }
+
+    // the texture is deleted, its unit is free again
+    static void forgetTexture(unsigned int texture)
+    {
+        for (auto& unit : s_units)
+            if (unit.texture == texture)
+                unit = Unit{};
+    }
+
+    static const TextureUnitStats& getStats() { return s_stats; }
+
+    static void printStats(std::ostream& out = std::cout)
+    {
+        out << "TextureUnits: " << s_unitCount << " unit(s) | " << s_stats.reused << " reused, "
+            << s_stats.bound << " bound, " << s_stats.overflows << " overflow(s)\n";
+    }
+
+private:
+    static void queryUnitCount()
+    {
+        int count{};
+        glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &count);
+        s_unitCount = std::clamp(static_cast<unsigned int>(count), 1u, s_maxUnits);
+    }
+
+    static unsigned int find(GLenum target, unsigned int texture)
+    {
+        for (unsigned int unit{ 0 }; unit < s_unitCount; ++unit)
+            if (s_units[unit].texture == texture && s_units[unit].target == target)
+                return unit;
+        return s_unitCount;
+    }
+
+    static unsigned int leastRecentlyUsed()
+    {
+        unsigned int oldest{ 0 };
+        for (unsigned int unit{ 1 }; unit < s_unitCount; ++unit)
+            if (s_units[unit].lastUse < s_units[oldest].lastUse)
+                oldest = unit;
+
+        // every unit is used by this draw, one of its textures is lost
+        if (s_units[oldest].lastUse == s_draw)
+        {
+            if (s_stats.overflows++ == 0)
+                std::cerr << "TextureUnits: a draw uses more than " << s_unitCount << " textures\n";
+        }
+
+        return oldest;
+    }
+};
+
+
+#endif
@@ -0,0 +1,73 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image/stb_image.h>
+
+#include <texture_header/texture_cooker.h>
+
+#include <filesystem>
+#include <chrono>
+#include <iostream>
+
+
+//=======================================================================================
+
+
+/*
+    block compresses every image in the given files / directories (recursively) to <image>.dds,
+    RGB(A) images also to <image>.srgb.dds (mips filtered in linear space, for gamma loads).
+    images with up to date .dds files are skipped (--force cooks them again):
+
+        ./cook_textures resources/img resources/model
+
+    no window or GL context is created.
+*/
+int main(int argc, char* argv[])
+{
+    namespace fs = std::filesystem;
+
+    bool force{ false };
+    std::vector<fs::path> images{};
+
+    for (int i{ 1 }; i < argc; ++i)
+    {
+        fs::path path{ argv[i] };
+        if (path == "--force")
+            force = true;
+        else if (fs::is_directory(path))
+        {
+            for (const auto& entry : fs::recursive_directory_iterator{ path })
+                if (entry.is_regular_file() && TextureCooker::isImage(entry.path()))
+                    images.push_back(entry.path());
+        }
+        else
+            images.push_back(path);
+    }
+
+    if (images.empty())
+    {
+        std::cerr << "usage: " << argv[0] << " [--force] <image or directory> [...]" << std::endl;
+        return 1;
+    }
+
+    int failed{ 0 };
+    for (const auto& image : images)
+    {
+        for (bool srgb : { false, true })
+        {
+            if (srgb && !TextureCooker::isColor(image))
+                continue;
+            if (!force && dds::isCookedUpToDate(image, srgb))
+                continue;
+
+            auto start{ std::chrono::steady_clock::now() };
+            bool cooked{ TextureCooker::cook(image, srgb) };
+            double ms{ std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() };
+
+            if (cooked)
+                std::cout << image.string() << " -> " << dds::cookedPathOf(image, srgb).string() << " (" << ms << " ms)" << std::endl;
+            else
+                ++failed;
+        }
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,173 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image/stb_image.h>
+
+#include <texture_header/mipmap.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <iostream>
+
+
+//=======================================================================================
+
+
+namespace configuration
+{
+    constexpr int runs{ 5 };            // best of
+}
+
+
+namespace
+{
+    // an RGBA texture of `width` x `height` with `levels` levels (storage only)
+    unsigned int createTexture(int width, int height, int levels)
+    {
+        unsigned int texture{};
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+        for (int level{ 0 }, w{ width }, h{ height }; level < levels; ++level, w = std::max(w / 2, 1), h = std::max(h / 2, 1))
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        return texture;
+    }
+
+    // level 0 + glGenerateMipmap, until glFinish
+    double gpuMipmaps(unsigned int texture, const std::uint8_t* pixels, int width, int height)
+    {
+        auto start{ std::chrono::steady_clock::now() };
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glFinish();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // mipmap::generate() (what the loader threads do) and the upload of every level (what the render thread does)
+    void cpuMipmaps(unsigned int texture, const std::uint8_t* pixels, int width, int height, double& generateMs, double& uploadMs)
+    {
+        auto start{ std::chrono::steady_clock::now() };
+        MipChain chain{ mipmap::generate({ pixels, static_cast<std::size_t>(width) * height * 4 }, width, height, 4, false) };
+        auto generated{ std::chrono::steady_clock::now() };
+
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+        for (std::size_t i{ 0 }; i < chain.levels.size(); ++i)
+        {
+            const auto& level{ chain.levels[i] };
+            glTexSubImage2D(GL_TEXTURE_2D, static_cast<int>(i) + 1, 0, 0, level.width, level.height, GL_RGBA, GL_UNSIGNED_BYTE, chain.data.data() + level.offset);
+        }
+        glFinish();
+
+        generateMs = std::chrono::duration<double, std::milli>(generated - start).count();
+        uploadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - generated).count();
+    }
+
+    std::vector<std::uint8_t> readLevel(unsigned int texture, int level, int width, int height)
+    {
+        std::vector<std::uint8_t> texels(static_cast<std::size_t>(width) * height * 4);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glGetTexImage(GL_TEXTURE_2D, level, GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+        return texels;
+    }
+}
+
+
+/*
+    glGenerateMipmap against the CPU mipmaps of the texture loader (mipmap::generate() + one
+    glTexSubImage2D per level) for the given images, best of 5 runs each, and the largest
+    difference between the levels both produce (drivers may filter odd sizes differently):
+
+        cd "1. Getting Started/1.3. Textures" && ./tools/mipmap_compare [image ...]
+
+    without arguments the images of img/ are used. a hidden window provides the context. on a
+    software rasterizer (llvmpipe) glGenerateMipmap runs on the render thread, while
+    mipmap::generate() runs on the loader threads in the demos.
+*/
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> images{};
+    for (int i{ 1 }; i < argc; ++i)
+        images.push_back(argv[i]);
+    if (images.empty())
+        images = { "img/container.jpg", "img/wall.jpg", "img/awesomeface.png", "img/marble.jpg", "img/nakiri_2x.jpg" };
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow* window{ glfwCreateWindow(64, 64, "mipmap compare", NULL, NULL) };
+    if (!window)
+    {
+        std::cerr << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cerr << "Failed to initialize GLAD" << std::endl;
+        glfwTerminate();
+        return 1;
+    }
+
+    int failed{ 0 };
+    std::cout << "image\tsize\tglGenerateMipmap (ms)\tgenerate (ms)\tupload (ms)\tmax difference\n";
+    for (const auto& path : images)
+    {
+        int width{}, height{}, channels{};
+        stbi_uc* pixels{ stbi_load(path.c_str(), &width, &height, &channels, 4) };
+        if (!pixels)
+        {
+            std::cerr << "ERROR::MIPMAP_COMPARE::could not load " << path << std::endl;
+            ++failed;
+            continue;
+        }
+
+        int levels{ 1 };
+        for (int w{ width }, h{ height }; w > 1 || h > 1; w = std::max(w / 2, 1), h = std::max(h / 2, 1))
+            ++levels;
+
+        unsigned int gpuTexture{ createTexture(width, height, levels) };
+        unsigned int cpuTexture{ createTexture(width, height, levels) };
+
+        double gpuMs{ 1e30 }, generateMs{ 1e30 }, uploadMs{ 1e30 };
+        for (int run{ 0 }; run < configuration::runs; ++run)
+        {
+            gpuMs = std::min(gpuMs, gpuMipmaps(gpuTexture, pixels, width, height));
+
+            double generate{}, upload{};
+            cpuMipmaps(cpuTexture, pixels, width, height, generate, upload);
+            generateMs = std::min(generateMs, generate);
+            uploadMs = std::min(uploadMs, upload);
+        }
+
+        int difference{ 0 };
+        for (int level{ 1 }, w{ std::max(width / 2, 1) }, h{ std::max(height / 2, 1) }; level < levels; ++level, w = std::max(w / 2, 1), h = std::max(h / 2, 1))
+        {
+            auto gpu{ readLevel(gpuTexture, level, w, h) };
+            auto cpu{ readLevel(cpuTexture, level, w, h) };
+            for (std::size_t i{ 0 }; i < gpu.size(); ++i)
+                difference = std::max(difference, std::abs(gpu[i] - cpu[i]));
+        }
+
+        std::cout << path << '\t' << width << 'x' << height << '\t' << gpuMs << "\t\t\t" << generateMs << "\t\t" << uploadMs << "\t\t" << difference << '\n';
+
+        glDeleteTextures(1, &gpuTexture);
+        glDeleteTextures(1, &cpuTexture);
+        stbi_image_free(pixels);
+    }
+    std::cout.flush();
+
+    glfwTerminate();
+    return failed ? 1 : 0;
+}
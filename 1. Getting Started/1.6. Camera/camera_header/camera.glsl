@@ -0,0 +1,9 @@
+// per-frame camera data shared by all programs (GLSL counterpart of std140::CameraBlock in camera.h)
+// include with: #include "<relative path>/camera_header/camera.glsl"
+
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
@@ -5,6 +5,8 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <cstddef>      // for offsetof
+
 enum class CameraMovement
 {
     FORWARD,
@@ -25,6 +27,21 @@ namespace camera_constant
     constexpr float FOV { 45.0f };
 }
 
+// GPU side layout of the per-frame camera data, matching the std140 uniform block in camera.glsl
+namespace std140
+{
+    struct CameraBlock
+    {
+        glm::mat4 view{};
+        glm::mat4 projection{};
+        glm::vec3 viewPos{};
+        float     pad0{};
+    };
+
+    static_assert(offsetof(CameraBlock, projection) == 64 && offsetof(CameraBlock, viewPos) == 128);
+    static_assert(sizeof(CameraBlock) == 144);
+}
+
 
 class Camera
 {
@@ -76,6 +93,16 @@ public:
         // return getLookAtMatrix();        // implemented manually
     }
 
+    // per-frame data for the Camera uniform block
+    std140::CameraBlock toStd140(const glm::mat4& projection)
+    {
+        std140::CameraBlock block{};
+        block.view = getViewMatrix();
+        block.projection = projection;
+        block.viewPos = position;
+        return block;
+    }
+
     // process camera movement
     void moveCamera(CameraMovement movement, float deltaTime)
     {
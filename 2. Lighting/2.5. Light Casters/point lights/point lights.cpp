@@ -17,6 +17,8 @@
 
 // texture
 #include <texture_header/texture.h>
+#include <texture_header/texture_units.h>
+#include <gl_state_header/gl_state.h>
 
 // shapes
 #include <shapes/sphere/sphere.h>
@@ -141,12 +143,7 @@ public:
             Material<MaterialTextured> mat{ *((Material<MaterialTextured>*)mat_void) };
 
             shader.use();
-            shader.setInt("material.diffuse",     mat.getDiffuse().textureUnitNum);
-            shader.setInt("material.specular",    mat.getSpecular().textureUnitNum);
             shader.setFloat("material.shininess", mat.getShininess());
-            
-            // repurpose ambient as emission
-            shader.setInt("material.emission",    mat.getAmbient().textureUnitNum);
         }
     }
 
@@ -158,17 +155,17 @@ public:
         void* mat_void{ &material };
         auto mat{ *((Material<MaterialTextured>*)mat_void) };
 
+        // units are picked per draw, a map that is still bound keeps its unit
+        TextureUnits::beginDraw();
+
         // diffuse map
-        glActiveTexture(GL_TEXTURE0 + mat.getDiffuse().textureUnitNum);
-        glBindTexture(GL_TEXTURE_2D, mat.getDiffuse().textureID);
+        TextureUnits::bind(shader, "material.diffuse", GL_TEXTURE_2D, mat.getDiffuse().textureID);
 
         // specular map
-        glActiveTexture(GL_TEXTURE0 + mat.getSpecular().textureUnitNum);
-        glBindTexture(GL_TEXTURE_2D, mat.getSpecular().textureID);
+        TextureUnits::bind(shader, "material.specular", GL_TEXTURE_2D, mat.getSpecular().textureID);
 
         // emissive map (from repurposed ambient map)
-        glActiveTexture(GL_TEXTURE0 + mat.getAmbient().textureUnitNum);
-        glBindTexture(GL_TEXTURE_2D, mat.getAmbient().textureID);
+        TextureUnits::bind(shader, "material.emission", GL_TEXTURE_2D, mat.getAmbient().textureID);
     }
 
 private:
@@ -359,6 +356,9 @@ int main()
         updateDeltaTime();
     }
 
+    // the cached textures are deleted while the context is current, the locals holding them outlive it
+    TextureCache::clear();
+
     // clearing all previously allocated GLFW resources.
     // sphere.getObject().~Cube();
     glfwTerminate();
@@ -1,10 +1,22 @@
 #version 330 core
 
+#ifndef INSTANCED
+#define INSTANCED 0
+#endif
+
 out vec4 FragColor;
 
+#if INSTANCED
+flat in vec3 InstanceColor;
+#else
 uniform vec3 color;
+#endif
 
 void main()
 {
+#if INSTANCED
+    FragColor = vec4(InstanceColor, 1.0);
+#else
     FragColor = vec4(color, 1.0);
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,44 @@
+// light source structs shared by the lighting shaders (GLSL counterpart of light.h)
+// include with: #include "<relative path>/light_header/light.glsl"
+//
+// members are ordered so that each scalar fills the padding after a vec3 in std140 blocks,
+// keep in sync with the std140 structs in light.h
+
+// directional light source
+struct DirLight
+{
+    vec3 direction;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+// point light source
+struct PointLight
+{
+    vec3 position;
+    float constant;
+
+    vec3 ambient;
+    float linear;
+    vec3 diffuse;
+    float quadratic;
+    vec3 specular;
+};
+
+// spotlight
+struct SpotLight
+{
+    vec3 position;
+    float constant;
+    vec3 direction;
+    float cutOff;
+
+    vec3 ambient;
+    float outerCutOff;
+    vec3 diffuse;
+    float linear;
+    vec3 specular;
+    float quadratic;
+};
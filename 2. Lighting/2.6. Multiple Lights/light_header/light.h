@@ -5,6 +5,78 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <cstddef>      // for offsetof
+
+
+
+// GPU side layouts of the lights, matching the std140 uniform blocks in light_block.glsl
+// (a vec3 is 16 bytes aligned, the scalar following it fills its last 4 bytes)
+namespace std140
+{
+    constexpr std::size_t MAX_POINT_LIGHTS{ 8 };    // must match MAX_POINT_LIGHTS in light_block.glsl
+
+    struct DirLight
+    {
+        glm::vec3 direction{};
+        float     pad0{};
+        glm::vec3 ambient{};
+        float     pad1{};
+        glm::vec3 diffuse{};
+        float     pad2{};
+        glm::vec3 specular{};
+        float     pad3{};
+    };
+
+    struct PointLight
+    {
+        glm::vec3 position{};
+        float     constant{};
+        glm::vec3 ambient{};
+        float     linear{};
+        glm::vec3 diffuse{};
+        float     quadratic{};
+        glm::vec3 specular{};
+        float     pad0{};
+    };
+
+    struct SpotLight
+    {
+        glm::vec3 position{};
+        float     constant{};
+        glm::vec3 direction{};
+        float     cutOff{};             // cosine
+        glm::vec3 ambient{};
+        float     outerCutOff{};        // cosine
+        glm::vec3 diffuse{};
+        float     linear{};
+        glm::vec3 specular{};
+        float     quadratic{};
+    };
+
+    // uniform block Lights
+    struct LightsBlock
+    {
+        DirLight   dirLight{};
+        SpotLight  spotLight{};
+        PointLight pointLights[MAX_POINT_LIGHTS]{};
+    };
+
+    static_assert(sizeof(DirLight) == 64);
+    static_assert(offsetof(DirLight, ambient) == 16 && offsetof(DirLight, diffuse) == 32 && offsetof(DirLight, specular) == 48);
+
+    static_assert(sizeof(PointLight) == 64);
+    static_assert(offsetof(PointLight, constant) == 12 && offsetof(PointLight, ambient) == 16 && offsetof(PointLight, linear) == 28);
+    static_assert(offsetof(PointLight, diffuse) == 32 && offsetof(PointLight, quadratic) == 44 && offsetof(PointLight, specular) == 48);
+
+    static_assert(sizeof(SpotLight) == 80);
+    static_assert(offsetof(SpotLight, direction) == 16 && offsetof(SpotLight, cutOff) == 28 && offsetof(SpotLight, ambient) == 32);
+    static_assert(offsetof(SpotLight, outerCutOff) == 44 && offsetof(SpotLight, diffuse) == 48 && offsetof(SpotLight, linear) == 60);
+    static_assert(offsetof(SpotLight, specular) == 64 && offsetof(SpotLight, quadratic) == 76);
+
+    static_assert(offsetof(LightsBlock, spotLight) == 64 && offsetof(LightsBlock, pointLights) == 144);
+    static_assert(sizeof(LightsBlock) == 144 + 64 * MAX_POINT_LIGHTS);
+}
+
 
 
 class Light
@@ -38,6 +110,16 @@ public:
         , Light{ amb, diff, spec }
     {
     }
+
+    std140::DirLight toStd140() const
+    {
+        std140::DirLight light{};
+        light.direction = direction;
+        light.ambient   = ambient;
+        light.diffuse   = diffuse;
+        light.specular  = specular;
+        return light;
+    }
 };
 
 
@@ -64,6 +146,19 @@ public:
         , quadratic{ quad }
         {
         }
+
+    std140::PointLight toStd140() const
+    {
+        std140::PointLight light{};
+        light.position  = position;
+        light.ambient   = ambient;
+        light.diffuse   = diffuse;
+        light.specular  = specular;
+        light.constant  = constant;
+        light.linear    = linear;
+        light.quadratic = quadratic;
+        return light;
+    }
 };
 
 
@@ -88,6 +183,23 @@ public:
         , outerCutOff{ outercutoff }
     {
     }
+
+    // the shader compares cosines, the angles are converted here
+    std140::SpotLight toStd140() const
+    {
+        std140::SpotLight light{};
+        light.position    = position;
+        light.direction   = direction;
+        light.ambient     = ambient;
+        light.diffuse     = diffuse;
+        light.specular    = specular;
+        light.constant    = constant;
+        light.linear      = linear;
+        light.quadratic   = quadratic;
+        light.cutOff      = glm::cos(glm::radians(cutOff));
+        light.outerCutOff = glm::cos(glm::radians(outerCutOff));
+        return light;
+    }
 };
 
 
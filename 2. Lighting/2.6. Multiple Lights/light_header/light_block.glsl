@@ -0,0 +1,13 @@
+// per-frame light data shared by all programs (GLSL counterpart of std140::LightsBlock in light.h)
+// include with: #include "<relative path>/light_header/light_block.glsl"
+
+#include "light.glsl"
+
+#define MAX_POINT_LIGHTS 8          // must match std140::MAX_POINT_LIGHTS
+
+layout (std140) uniform Lights
+{
+    DirLight dirLight;
+    SpotLight spotLight;
+    PointLight pointLights[MAX_POINT_LIGHTS];       // the first NR_POINT_LIGHTS are used
+};
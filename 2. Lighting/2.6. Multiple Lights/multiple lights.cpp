@@ -13,10 +13,16 @@
 //----------
 // shader
 #include <shader_header/shader.h>
+#include <shader_header/shader_library.h>
+#include <shader_header/uniform_buffer.h>
+#include <render_queue_header/render_queue.h>
+#include <transform_header/transform.h>
 // camera
 #include <camera_header/camera.h>
 // texture
 #include <texture_header/texture.h>
+#include <texture_header/texture_units.h>
+#include <gl_state_header/gl_state.h>
 // shapes
 #include <shapes/sphere/sphere.h>
 #include <shapes/cube/cube.h>
@@ -30,6 +36,9 @@
 // STL
 #include <iostream>
 #include <typeinfo>     // for typeid()
+#include <type_traits>  // for std::is_same_v
+#include <algorithm>    // for std::min()
+#include <limits>
 #include <vector>
 #include <string>       // for std::to_string()
 
@@ -81,16 +90,17 @@ class Object
     object_type object{};
     glm::vec3 position{};
     glm::vec3 scale{ 1.0f };
-    Shader shader{};
+    Shader* shader{};           // owned by the ShaderLibrary (hot reloaded)
     Material<material_type> material{};
     glm::mat4 modelMatrix{ glm::mat4(1.0f) };
+    glm::mat3 normalMatrix{ glm::mat3(1.0f) };
 
 public:
-    Object(object_type obj, glm::vec3 objPos, Shader objShader, Material<material_type> material)
+    Object(object_type obj, glm::vec3 objPos, Shader& objShader, Material<material_type> material)
         : object{ obj }
         , position { objPos }
         , scale{ 1.0f }
-        , shader{ objShader }
+        , shader{ &objShader }
         , material{ material }
         , modelMatrix{ glm::mat4(1.0f) }
     {
@@ -99,14 +109,15 @@ public:
     void setPosition(glm::vec3& pos) { position = pos; }
     void setPosition(float x, float y, float z) { setPosition(glm::vec3{ x, y, z }); }
     void setScale(float scaling) { scale = scaling; }
-    void setShader(Shader& shdr) { shader = shdr; }
+    void setShader(Shader& shdr) { shader = &shdr; }
     void setMaterial(Material<material_type>& mat) { material = mat; }
 
     auto& getObject() { return object; }
     auto& getPosition() { return position; }
-    auto& getShader() { return shader; }
+    auto& getShader() { return *shader; }
     auto& getMaterial() { return material; }
     auto& getModelMatrix() { updateModelMatrix(); return modelMatrix; }
+    auto& getNormalMatrix() { updateModelMatrix(); return normalMatrix; }
 
     // apply material through shader
     void applyMaterial()
@@ -117,23 +128,18 @@ public:
         {
             Material<MaterialBasic> mat{ *((Material<MaterialBasic>*)mat_void) };
 
-            shader.use();
-            shader.setVec3("material.ambient",    mat.getAmbient());
-            shader.setVec3("material.diffuse",    mat.getDiffuse());
-            shader.setVec3("material.specular",   mat.getSpecular());
-            shader.setFloat("material.shininess", mat.getShininess());
+            shader->use();
+            shader->setVec3("material.ambient",    mat.getAmbient());
+            shader->setVec3("material.diffuse",    mat.getDiffuse());
+            shader->setVec3("material.specular",   mat.getSpecular());
+            shader->setFloat("material.shininess", mat.getShininess());
         }
         else if (typeid(material) == typeid(Material<MaterialTextured>))
         {
             Material<MaterialTextured> mat{ *((Material<MaterialTextured>*)mat_void) };
 
-            shader.use();
-            shader.setInt("material.diffuse",     mat.getDiffuse().textureUnitNum);
-            shader.setInt("material.specular",    mat.getSpecular().textureUnitNum);
-            shader.setFloat("material.shininess", mat.getShininess());
-            
-            // repurpose ambient as emission
-            shader.setInt("material.emission",    mat.getAmbient().textureUnitNum);
+            shader->use();
+            shader->setFloat("material.shininess", mat.getShininess());
         }
     }
 
@@ -145,17 +151,28 @@ public:
         void* mat_void{ &material };
         auto mat{ *((Material<MaterialTextured>*)mat_void) };
 
+        // units are picked per draw, a map that is still bound keeps its unit
+        TextureUnits::beginDraw();
+
         // diffuse map
-        glActiveTexture(GL_TEXTURE0 + mat.getDiffuse().textureUnitNum);
-        glBindTexture(GL_TEXTURE_2D, mat.getDiffuse().textureID);
+        TextureUnits::bind(*shader, "material.diffuse", GL_TEXTURE_2D, mat.getDiffuse().textureID);
 
         // specular map
-        glActiveTexture(GL_TEXTURE0 + mat.getSpecular().textureUnitNum);
-        glBindTexture(GL_TEXTURE_2D, mat.getSpecular().textureID);
+        TextureUnits::bind(*shader, "material.specular", GL_TEXTURE_2D, mat.getSpecular().textureID);
 
         // emissive map (from repurposed ambient map)
-        glActiveTexture(GL_TEXTURE0 + mat.getAmbient().textureUnitNum);
-        glBindTexture(GL_TEXTURE_2D, mat.getAmbient().textureID);
+        TextureUnits::bind(*shader, "material.emission", GL_TEXTURE_2D, mat.getAmbient().textureID);
+    }
+
+    // RenderQueue material callback (`obj` is the Object), called only when the material changes between draws
+    static void bindMaterial(void* obj, Shader& shdr)
+    {
+        auto& self{ *static_cast<Object*>(obj) };
+
+        if constexpr (std::is_same_v<material_type, MaterialTextured>)
+            self.applyTexture();
+        else
+            shdr.setVec3("color", self.material.getDiffuse());
     }
 
 private:
@@ -163,6 +180,9 @@ private:
     {
         modelMatrix = glm::translate(glm::mat4(1.0f), position);
         modelMatrix = glm::scale(modelMatrix, scale);
+
+        // once per object instead of per vertex (no inverse for a uniform scale)
+        normalMatrix = ::normalMatrix(modelMatrix);
     }
 };
 
@@ -207,13 +227,41 @@ int main()
         return -1;
     }
 
+    // keep linked programs on disk so the next launch skips compiling them
+    ProgramBinaryCache::enable(".shader-cache", (GLADloadproc)glfwGetProcAddress);
+
     // disable cursor
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
     mouse::captureMouse = true;
 
     // enable depth testing
-    glEnable(GL_DEPTH_TEST);
+    GLState::enable(GL_DEPTH_TEST);
+
 
+    // per-frame camera and light data, one buffer update per frame shared by every program
+    // (created before the programs so their blocks get bound at link time)
+    UniformBuffer<std140::CameraBlock> cameraBuffer{ "Camera", 0 };
+    UniformBuffer<std140::LightsBlock> lightsBuffer{ "Lights", 1 };
+
+    // all programs are owned by the library, edit a .vs/.fs (or an included file) while running to reload it
+    ShaderLibrary shaderLibrary{};
+
+    // point light objects position
+    glm::vec3 pointLightPositions[]{
+        glm::vec3( 0.7f,  0.2f,  2.0f),
+        glm::vec3( 2.3f, -3.3f, -4.0f),
+        glm::vec3(-4.0f,  2.0f, -12.0f),
+        glm::vec3( 0.0f,  0.0f, -3.0f)
+    };
+
+    // the cube program is specialized for the number of point lights in the scene, both
+    // the cubes and the light spheres are drawn instanced (one draw call each)
+    ShaderDefines cubeDefines{};
+    cubeDefines.set("NR_POINT_LIGHTS", static_cast<int>(std::size(pointLightPositions)));
+    cubeDefines.set("INSTANCED");
+
+    ShaderDefines lightDefines{};
+    lightDefines.set("INSTANCED");
 
     // create objects
     //---------------
@@ -221,7 +269,7 @@ int main()
     Object<Cube, MaterialTextured> cube(
         Cube(0.5f),
         glm::vec3{ 0.0f,  0.0f,  0.0f},
-        Shader("shader.vs", "shader.fs"),
+        shaderLibrary.load("shader.vs", "shader.fs", cubeDefines),
         Material<MaterialTextured>{
             // Texture{"../../../resources/img/matrix.jpg"},      // ambient is repurposed as emission map
             Texture{},
@@ -253,14 +301,6 @@ int main()
         {  1.0f,  1.0f,  1.0f }         // spec
     };
 
-    // point light objects position
-    glm::vec3 pointLightPositions[]{
-        glm::vec3( 0.7f,  0.2f,  2.0f),
-        glm::vec3( 2.3f, -3.3f, -4.0f),
-        glm::vec3(-4.0f,  2.0f, -12.0f),
-        glm::vec3( 0.0f,  0.0f, -3.0f)
-    };
-
     // point lights
     std::vector<PointLight> pointLights;
     for (auto& pos : pointLightPositions)
@@ -299,7 +339,7 @@ int main()
         Object<Sphere> light{
             Sphere(0.2f, 32, 16),
             pointLights[i].position,
-            Shader("light-source-shader.vs", "light-source-shader.fs"),
+            shaderLibrary.load("light-source-shader.vs", "light-source-shader.fs", lightDefines),
             Material{
                 pointLights[i].specular,
                 pointLights[i].specular,
@@ -320,50 +360,54 @@ int main()
 
     // uniforms
     //---------
-    // set light uniform in shader.fs;
+    // lights block, the spotlight follows the camera and is refreshed every frame
+    std140::LightsBlock lights{};
+    lights.dirLight = dirLight.toStd140();
+    for (std::size_t i{ 0 }; i < pointLights.size() && i < std140::MAX_POINT_LIGHTS; ++i)
+        lights.pointLights[i] = pointLights[i].toStd140();
 
-    {
-        Shader& shader{ cube.getShader() };
-        shader.use();
-        
-        // set directional light uniforms
-        shader.setVec3("dirLight.direction", dirLight.direction);
-        shader.setVec3("dirLight.ambient",   dirLight.ambient);
-        shader.setVec3("dirLight.diffuse",   dirLight.diffuse);
-        shader.setVec3("dirLight.specular",  dirLight.specular);
-
-        // set point lights
-        for (std::size_t i{ 0 }; i < pointLights.size(); ++i)
-        {
-            auto num{ std::to_string(i) };
-            shader.setVec3("pointLights[" + num + "].position", pointLights[i].position);
-            shader.setVec3("pointLights[" + num + "].ambient", pointLights[i].ambient);
-            shader.setVec3("pointLights[" + num + "].diffuse", pointLights[i].diffuse);
-            shader.setVec3("pointLights[" + num + "].specular", pointLights[i].specular);
-            shader.setFloat("pointLights[" + num + "].constant", pointLights[i].constant);
-            shader.setFloat("pointLights[" + num + "].linear", pointLights[i].linear);
-            shader.setFloat("pointLights[" + num + "].quadratic", pointLights[i].quadratic);
-        }
 
-        // set spot light
-        shader.setVec3("spotLight.position", spotLight.position);
-        shader.setVec3("spotLight.direction", spotLight.direction);
-        shader.setVec3("spotLight.ambient", spotLight.ambient);
-        shader.setVec3("spotLight.diffuse", spotLight.diffuse);
-        shader.setVec3("spotLight.specular", spotLight.specular);
-        shader.setFloat("spotLight.constant", spotLight.constant);
-        shader.setFloat("spotLight.linear", spotLight.linear);
-        shader.setFloat("spotLight.quadratic", spotLight.quadratic);
-        shader.setFloat("spotLight.cutOff", glm::cos(glm::radians(spotLight.cutOff)));
-        shader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(spotLight.outerCutOff)));
+    // draws are collected every frame and submitted sorted by program, material and depth
+    RenderQueue renderQueue{};
+
+    // instance data, the cubes don't move so their matrices are computed once
+    std::vector<glm::mat4> cubeModels{};
+    std::vector<glm::mat3> cubeNormalMatrices{};
+    for(unsigned int i = 0; i < 10; i++)
+    {
+        // model matrix
+        glm::mat4 model = glm::mat4(1.0f);
+        model = glm::translate(model, cubePositions[i]);
+        float angle = 20.0f * i;
+        model = glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
+
+        cubeModels.push_back(model);
+        cubeNormalMatrices.push_back(normalMatrix(model));
     }
 
+    std::vector<glm::mat4> lightModels(pointLightObjects.size());
+    std::vector<glm::mat3> lightNormalMatrices(pointLightObjects.size());
+    std::vector<glm::vec3> lightColors{};
+    for (auto& light : pointLightObjects)
+        lightColors.push_back(light.getMaterial().getDiffuse());
+
 
     //=======================================================================================================
 
     // render loop
     while (!glfwWindowShouldClose(window))
     {
+        // swap in shaders that changed on disk (frame boundary), a new program starts with
+        // its uniforms zeroed: set the materials again
+        for (Shader* reloaded : shaderLibrary.update())
+        {
+            if (reloaded == &cube.getShader())
+                cube.applyMaterial();
+            for (auto& l : pointLightObjects)
+                if (reloaded == &l.getShader())
+                    l.applyMaterial();
+        }
+
         // input
         processInput(window);
 
@@ -373,79 +417,68 @@ int main()
         // clear color buffer and depth buffer
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // view is handled by camera class
-        auto view { camera.getViewMatrix() };
-
         // projection matrix changes because of the aspect ratio, so we'll update it
         auto projection { glm::perspective(glm::radians(camera.fov), configuration::aspectRatio, 0.1f, 100.0f) };
 
+        // view, projection and viewPos for every program (view is handled by camera class)
+        cameraBuffer.update(camera.toStd140(projection));
+
+        // update spotlight position and direction
+        spotLight.position = camera.position;
+        spotLight.direction = camera.front;
+        lights.spotLight = spotLight.toStd140();
+        lightsBuffer.update(lights);
+
+        // view is handled by camera class, needed here for the depth of each draw
+        auto view { camera.getViewMatrix() };
+
         // container
         //----------
-        {
-            auto& shader{ cube.getShader() };
-
-            // use shader
-            shader.use();
-
-            // apply texture
-            cube.applyTexture();
-
-            // set uniform
-            shader.setVec3("viewPos", camera.position);
-            
-            // update spotlight position and direction
-            shader.setVec3("spotLight.position", camera.position);
-            shader.setVec3("spotLight.direction", camera.front);
-
-            // set matrices
-            shader.setMat4("projection", projection);
-            shader.setMat4("view", view);
-            
-            // applied 10 times
-            for(unsigned int i = 0; i < 10; i++)
-            {
-                // model matrix
-                glm::mat4 model = glm::mat4(1.0f);
-                model = glm::translate(model, cubePositions[i]);
-                float angle = 20.0f * i;
-                model = glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
-                shader.setMat4("model", model);
-
-                // draw
-                cube.getObject().draw();
-            }
-        }
+        // 10 instances, the batch is sorted by its nearest cube
+        float cubesDepth{ std::numeric_limits<float>::max() };
+        for (const auto& model : cubeModels)
+            cubesDepth = std::min(cubesDepth, RenderQueue::viewDepth(view, model));
+
+        renderQueue.submitInstanced(RenderPass::OPAQUE, cube.getShader(), cube.getObject(), cubeModels, cubesDepth,
+                                    &cube, decltype(cube)::bindMaterial, cubeNormalMatrices);
         //----------
 
 
         // point lights
         //-------------
+        // all light spheres share the geometry of the first one, the color comes with each instance
+        float lightsDepth{ std::numeric_limits<float>::max() };
         for (std::size_t i{ 0 }; i < pointLightObjects.size(); ++i)
         {
-            auto& light{ pointLightObjects[i] };
-            auto& lightShader{ light.getShader() };
+            lightModels[i] = pointLightObjects[i].getModelMatrix();
+            lightNormalMatrices[i] = pointLightObjects[i].getNormalMatrix();
+            lightsDepth = std::min(lightsDepth, RenderQueue::viewDepth(view, lightModels[i]));
+        }
 
-            lightShader.use();
+        auto& lightSphere{ pointLightObjects.front() };
+        renderQueue.submitInstanced(RenderPass::OPAQUE, lightSphere.getShader(), lightSphere.getObject(), lightModels, lightsDepth,
+                                    nullptr, nullptr, lightNormalMatrices, lightColors);
+        //-------------
 
-            // matrices
-            lightShader.setMat4("view", view);
-            lightShader.setMat4("projection", projection);
-            lightShader.setMat4("model", light.getModelMatrix() );
 
-            // color
-            lightShader.setVec3("color", light.getMaterial().getDiffuse());
+        // draw everything (model matrix set by the queue, view and projection come from the camera block)
+        renderQueue.flush();
 
-            // draw
-            light.getObject().draw();
-        }
-        //-------------
 
+        // issued vs. filtered state changes of this frame
+        GLState::endFrame();
 
         glfwSwapBuffers(window);
         glfwPollEvents();
         updateDeltaTime();
     }
 
+    ProgramBinaryCache::printStats();
+    GLState::printStats();
+
+    // the cached textures are deleted while the context is current, the locals holding them outlive it
+    TextureCache::clear();
+
     // clearing all previously allocated GLFW resources.
     // sphere.getObject().~Cube();
     glfwTerminate();
@@ -1,5 +1,16 @@
 #version 330 core
 
+// variant defines (overridable through ShaderDefines, see shader_source.h)
+#ifndef NR_POINT_LIGHTS
+#define NR_POINT_LIGHTS 4                           // the number of point lights we want to have in our scene
+#endif
+#ifndef HAS_SPECULAR_MAP
+#define HAS_SPECULAR_MAP 1                          // sample material.specular, otherwise no specular highlight
+#endif
+#ifndef HAS_EMISSION
+#define HAS_EMISSION 0                              // add material.emission on top of the lighting
+#endif
+
 // material
 struct Material
 {
@@ -10,51 +21,15 @@ struct Material
 };
 uniform Material material;
 
-// directional light source
-struct DirLight
-{
-    vec3 direction;
-
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-};
-uniform DirLight dirLight;
-
-// point light source
-struct PointLight
-{
-    vec3 position;
-
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-
-    float constant;
-    float linear;
-    float quadratic;
-};
-#define NR_POINT_LIGHTS 4                           // define the number of point lights we want to have in our scene
-uniform PointLight pointLights[NR_POINT_LIGHTS];    // an array of point light
-
-// spotlight
-struct SpotLight
-{
-    vec3 position;
-    vec3 direction;
+// dirLight, spotLight, pointLights[] (uniform buffer shared by all programs)
+#include "light_header/light_block.glsl"
 
-    float cutOff;
-    float outerCutOff;
+#if NR_POINT_LIGHTS > MAX_POINT_LIGHTS
+#error "NR_POINT_LIGHTS exceeds MAX_POINT_LIGHTS"
+#endif
 
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-
-    float constant;
-    float linear;
-    float quadratic;
-};
-uniform SpotLight spotLight;
+// view, projection, viewPos (uniform buffer shared by all programs)
+#include "../../include/camera_header/camera.glsl"
 
 in vec2 TexCoords;
 in vec3 Normal;
@@ -62,8 +37,6 @@ in vec3 FragPos;
 
 out vec4 FragColor;
 
-uniform vec3 viewPos;
-
 
 //=======================================================================================
 // function declarations
@@ -71,6 +44,7 @@ uniform vec3 viewPos;
 vec3 calcDirLight(DirLight light, vec3 normal, vec3 viewDir);
 vec3 calcPointLight(PointLight light, vec3 normal, vec3 FragPos, vec3 viewDir);
 vec3 calcSpotLight(SpotLight light, vec3 normal, vec3 FragPos, vec3 viewDir);
+vec3 specularMap();
 
 //=======================================================================================
 
@@ -88,12 +62,19 @@ void main()
     result = calcDirLight(dirLight, norm, viewDir);
 
     // point lights
+#if NR_POINT_LIGHTS > 0
     for (int i = 0; i < NR_POINT_LIGHTS; ++i)
         result += calcPointLight(pointLights[i], norm, FragPos, viewDir);
+#endif
     
     // spotlight
     result += calcSpotLight(spotLight, norm, FragPos, viewDir);
 
+#if HAS_EMISSION
+    // emission
+    result += texture(material.emission, TexCoords).xyz;
+#endif
+
     FragColor = vec4(result, 1.0);
     //------------------------
 }
@@ -102,6 +83,16 @@ void main()
 //=======================================================================================
 // function definitions
 
+// specular intensity of the fragment
+vec3 specularMap()
+{
+#if HAS_SPECULAR_MAP
+    return texture(material.specular, TexCoords).xyz;
+#else
+    return vec3(0.0);
+#endif
+}
+
 // calculate directional light
 vec3 calcDirLight(DirLight light, vec3 normal, vec3 viewDir)
 {
@@ -117,7 +108,7 @@ vec3 calcDirLight(DirLight light, vec3 normal, vec3 viewDir)
     // combine results
     vec3 ambient = light.ambient * texture(material.diffuse, TexCoords).xyz;
     vec3 diffuse = light.diffuse * diff * texture(material.diffuse, TexCoords).xyz;
-    vec3 specular = light.specular * spec * texture(material.specular, TexCoords).xyz;
+    vec3 specular = light.specular * spec * specularMap();
 
     return (ambient + diffuse + specular);
 }
@@ -141,7 +132,7 @@ vec3 calcPointLight(PointLight light, vec3 normal, vec3 FragPos, vec3 viewDir)
     // combine results
     vec3 ambient = light.ambient * texture(material.diffuse, TexCoords).xyz;
     vec3 diffuse = light.diffuse * diff * texture(material.diffuse, TexCoords).xyz;
-    vec3 specular = light.specular * spec * texture(material.specular, TexCoords).xyz;
+    vec3 specular = light.specular * spec * specularMap();
     ambient *= attenuation;
     diffuse *= attenuation;
     specular *= attenuation;
@@ -173,7 +164,7 @@ vec3 calcSpotLight(SpotLight light, vec3 normal, vec3 FragPos, vec3 viewDir)
     // combine results
     vec3 ambient = light.ambient * texture(material.diffuse, TexCoords).xyz;
     vec3 diffuse = light.diffuse * diff * texture(material.diffuse, TexCoords).xyz;
-    vec3 specular = light.specular * spec * texture(material.specular, TexCoords).xyz;
+    vec3 specular = light.specular * spec * specularMap();
     ambient *= attenuation * intensity;
     diffuse *= attenuation * intensity;
     specular *= attenuation * intensity;
@@ -1,24 +1,43 @@
 #version 330 core
 
+// variant defines (overridable through ShaderDefines, see shader_source.h)
+#ifndef INSTANCED
+#define INSTANCED 0                                 // model/normal matrices per instance (Cube::drawInstanced)
+#endif
+
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
 
+#if INSTANCED
+layout (location = 3) in mat4 aInstanceModel;          // locations 3-6
+layout (location = 7) in mat3 aInstanceNormalMatrix;   // locations 7-9
+#endif
+
 out vec3 Normal;
 out vec2 TexCoords;
 out vec3 FragPos;
 
+#if !INSTANCED
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform mat3 normalMatrix;                          // inverse transpose of model, computed on the CPU
+#endif
+
+// view, projection, viewPos (uniform buffer shared by all programs)
+#include "../../include/camera_header/camera.glsl"
 
 
 void main()
 {
+#if INSTANCED
+    mat4 model = aInstanceModel;
+    mat3 normalMatrix = aInstanceNormalMatrix;
+#endif
+
     gl_Position = projection * view * model * vec4(aPos, 1.0);
 
     // remove the effect of wronglyscaling the normal vectors
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+    Normal = normalMatrix * aNormal;
 
     TexCoords = aTexCoords;
 
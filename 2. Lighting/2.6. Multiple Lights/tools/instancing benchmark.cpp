@@ -0,0 +1,165 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <shader_header/shader.h>
+#include <shader_header/shader_library.h>
+#include <shader_header/uniform_buffer.h>
+#include <transform_header/transform.h>
+#include <camera_header/camera.h>
+#include <light_header/light.h>
+#include <texture_header/texture.h>
+#include <texture_header/texture_units.h>
+#include <gl_state_header/gl_state.h>
+#include <shapes/cube/cube.h>
+
+#include <chrono>
+#include <cmath>
+#include <vector>
+#include <iostream>
+
+
+//=======================================================================================
+
+
+namespace configuration
+{
+    constexpr int width{ 800 };
+    constexpr int height{ 600 };
+    constexpr int frames{ 10 };
+    constexpr int counts[]{ 100, 1000, 10000, 100000 };
+}
+
+
+/*
+    frame time of n cubes drawn one by one (model and normal matrix uniforms + glDrawElements per
+    cube, the loop of multiple lights.cpp before instancing) against a single drawInstanced()
+    (matrices streamed into the instance buffer, one glDrawElementsInstanced), for n from 100 to
+    100000. the cubes are small and spread on a grid in front of the camera, so the numbers are
+    about submission, not fill rate:
+
+        cd "2. Lighting/2.6. Multiple Lights" && ./tools/instancing_benchmark
+
+    a hidden window provides the context (the shaders are loaded from shader.vs / shader.fs).
+    the frame time includes glFinish().
+*/
+int main()
+{
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow* window{ glfwCreateWindow(configuration::width, configuration::height, "instancing benchmark", NULL, NULL) };
+    if (!window)
+    {
+        std::cerr << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cerr << "Failed to initialize GLAD" << std::endl;
+        glfwTerminate();
+        return 1;
+    }
+
+    {
+        GLState::enable(GL_DEPTH_TEST);
+
+        UniformBuffer<std140::CameraBlock> cameraBuffer{ "Camera", 0 };
+        UniformBuffer<std140::LightsBlock> lightsBuffer{ "Lights", 1 };
+
+        Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+        auto projection{ glm::perspective(glm::radians(camera.fov), static_cast<float>(configuration::width) / configuration::height, 0.1f, 200.0f) };
+        cameraBuffer.update(camera.toStd140(projection));
+
+        std140::LightsBlock lights{};
+        lights.dirLight = DirectionalLight{ { -0.2f, -1.0f, -0.3f }, glm::vec3{ 0.05f }, glm::vec3{ 0.5f }, glm::vec3{ 1.0f } }.toStd140();
+        lightsBuffer.update(lights);
+
+        ShaderDefines defines{};
+        defines.set("NR_POINT_LIGHTS", 0);
+        ShaderDefines instancedDefines{ defines };
+        instancedDefines.set("INSTANCED");
+
+        ShaderLibrary shaderLibrary{};
+        Shader& single{ shaderLibrary.load("shader.vs", "shader.fs", defines) };
+        Shader& instanced{ shaderLibrary.load("shader.vs", "shader.fs", instancedDefines) };
+
+        Texture diffuse{ 0xa0, 0x80, 0x60 };
+        Texture specular{ 0x80, 0x80, 0x80 };
+        for (Shader* shader : { &single, &instanced })
+        {
+            shader->use();
+            shader->setFloat("material.shininess", 32.0f);
+        }
+
+        Cube cube{ 0.05f };
+        UniformHandle modelHandle{ single.uniform("model") };
+        UniformHandle normalMatrixHandle{ single.uniform("normalMatrix") };
+
+        auto frameTime{ [](auto draw) {
+            draw();             // warm up (buffer allocation)
+            glFinish();
+
+            auto start{ std::chrono::steady_clock::now() };
+            for (int frame{ 0 }; frame < configuration::frames; ++frame)
+                draw();
+            glFinish();
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / configuration::frames;
+        } };
+
+        std::cout << "cubes\tone by one (ms)\tinstanced (ms)\tspeedup\n";
+        for (int count : configuration::counts)
+        {
+            // a square grid of cubes on the floor, receding from the camera
+            int side{ static_cast<int>(std::ceil(std::sqrt(static_cast<float>(count)))) };
+            std::vector<glm::mat4> models{};
+            std::vector<glm::mat3> normalMatrices{};
+            for (int i{ 0 }; i < count; ++i)
+            {
+                glm::vec3 position{ (i % side - side * 0.5f) * 0.2f, -1.0f, -2.0f - (i / side) * 0.2f };
+                models.push_back(glm::rotate(glm::translate(glm::mat4(1.0f), position), glm::radians(20.0f * i), glm::vec3(1.0f, 0.3f, 0.5f)));
+                normalMatrices.push_back(normalMatrix(models.back()));
+            }
+
+            auto bindMaterial{ [&](Shader& shader) {
+                shader.use();
+                TextureUnits::beginDraw();
+                TextureUnits::bind(shader, "material.diffuse", GL_TEXTURE_2D, diffuse.textureID);
+                TextureUnits::bind(shader, "material.specular", GL_TEXTURE_2D, specular.textureID);
+            } };
+
+            double oneByOneMs{ frameTime([&] {
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                bindMaterial(single);
+                for (int i{ 0 }; i < count; ++i)
+                {
+                    single.setMat4(modelHandle, models[i]);
+                    single.setMat3(normalMatrixHandle, normalMatrices[i]);
+                    cube.draw();
+                }
+            }) };
+
+            double instancedMs{ frameTime([&] {
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                bindMaterial(instanced);
+                cube.drawInstanced(models, normalMatrices);
+            }) };
+
+            std::cout << count << '\t' << oneByOneMs << "\t\t" << instancedMs << "\t\t" << oneByOneMs / instancedMs << "x\n";
+        }
+        std::cout.flush();
+
+        cube.deleteBuffers();
+    }
+
+    glfwTerminate();
+    return 0;
+}
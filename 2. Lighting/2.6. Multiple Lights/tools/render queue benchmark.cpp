@@ -0,0 +1,253 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <shader_header/shader.h>
+#include <shader_header/shader_library.h>
+#include <shader_header/uniform_buffer.h>
+#include <render_queue_header/render_queue.h>
+#include <transform_header/transform.h>
+#include <camera_header/camera.h>
+#include <light_header/light.h>
+#include <texture_header/texture.h>
+#include <texture_header/texture_units.h>
+#include <gl_state_header/gl_state.h>
+#include <shapes/cube/cube.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include <iostream>
+
+
+//=======================================================================================
+
+
+namespace configuration
+{
+    constexpr int width{ 800 };
+    constexpr int height{ 600 };
+    constexpr int programs{ 4 };        // variants: 1 to 4 point lights
+    constexpr int materials{ 16 };
+    constexpr int frames{ 20 };
+}
+
+
+// textured material of an Object
+struct BenchmarkMaterial
+{
+    Texture diffuse{};
+    Texture specular{};
+};
+
+
+// the cube objects of the lighting demos, reduced to what a draw needs
+template <class object_type>
+class Object
+{
+    object_type object{};
+    Shader* shader{};
+    BenchmarkMaterial* material{};
+    glm::mat4 modelMatrix{ glm::mat4(1.0f) };
+
+public:
+    Object(const object_type& obj, glm::vec3 position, Shader& objShader, BenchmarkMaterial& objMaterial)
+        : object{ obj }
+        , shader{ &objShader }
+        , material{ &objMaterial }
+        , modelMatrix{ glm::translate(glm::mat4(1.0f), position) }
+    {
+    }
+
+    auto& getObject() { return object; }
+    auto& getShader() { return *shader; }
+    auto& getMaterial() { return *material; }
+    auto& getModelMatrix() { return modelMatrix; }
+
+    // RenderQueue material callback (`mat` is the BenchmarkMaterial)
+    static void bindMaterial(void* mat, Shader& shdr)
+    {
+        auto& self{ *static_cast<BenchmarkMaterial*>(mat) };
+
+        TextureUnits::beginDraw();
+        TextureUnits::bind(shdr, "material.diffuse", GL_TEXTURE_2D, self.diffuse.textureID);
+        TextureUnits::bind(shdr, "material.specular", GL_TEXTURE_2D, self.specular.textureID);
+    }
+};
+
+
+/*
+    draws thousands of Object<Cube> with random programs, materials and positions, once in
+    submission order (switching program and material whenever the next object needs another
+    one, as the hand-written render loops did) and once through the RenderQueue. prints the
+    draws, program and material changes and CPU time per frame of both, and the sort time:
+
+        cd "2. Lighting/2.6. Multiple Lights" && ./tools/render_queue_benchmark [objects]
+
+    a hidden window provides the context (the shaders are loaded from shader.vs / shader.fs).
+*/
+int main(int argc, char* argv[])
+{
+    int objectCount{ argc > 1 ? std::max(1, std::atoi(argv[1])) : 5000 };
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow* window{ glfwCreateWindow(configuration::width, configuration::height, "render queue benchmark", NULL, NULL) };
+    if (!window)
+    {
+        std::cerr << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cerr << "Failed to initialize GLAD" << std::endl;
+        glfwTerminate();
+        return 1;
+    }
+
+    {
+        GLState::enable(GL_DEPTH_TEST);
+
+        UniformBuffer<std140::CameraBlock> cameraBuffer{ "Camera", 0 };
+        UniformBuffer<std140::LightsBlock> lightsBuffer{ "Lights", 1 };
+
+        Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+        auto projection{ glm::perspective(glm::radians(camera.fov), static_cast<float>(configuration::width) / configuration::height, 0.1f, 100.0f) };
+        auto view{ camera.getViewMatrix() };
+        cameraBuffer.update(camera.toStd140(projection));
+
+        std140::LightsBlock lights{};
+        lights.dirLight = DirectionalLight{ { -0.2f, -1.0f, -0.3f }, glm::vec3{ 0.05f }, glm::vec3{ 0.5f }, glm::vec3{ 1.0f } }.toStd140();
+        for (std::size_t i{ 0 }; i < 4; ++i)
+            lights.pointLights[i] = PointLight{ { i * 4.0f - 6.0f, 2.0f, -10.0f }, glm::vec3{ 0.05f }, glm::vec3{ 0.5f }, glm::vec3{ 1.0f },
+                                                1.0f, 0.09f, 0.032f }.toStd140();
+        lightsBuffer.update(lights);
+
+        ShaderLibrary shaderLibrary{};
+        std::vector<Shader*> shaders{};
+        for (int i{ 1 }; i <= configuration::programs; ++i)
+        {
+            ShaderDefines defines{};
+            defines.set("NR_POINT_LIGHTS", i);
+            Shader& shader{ shaderLibrary.load("shader.vs", "shader.fs", defines) };
+            shader.use();
+            shader.setFloat("material.shininess", 32.0f);
+            shaders.push_back(&shader);
+        }
+
+        std::vector<BenchmarkMaterial> materials{};
+        materials.reserve(configuration::materials);
+        for (int i{ 0 }; i < configuration::materials; ++i)
+        {
+            auto shade{ static_cast<unsigned char>(64 + i * 12) };
+            materials.push_back({ Texture{ shade, 0x80, 0x40 }, Texture{ 0x80, 0x80, 0x80 } });
+        }
+
+        // random objects in front of the camera, all sharing the buffers of one cube
+        Cube cube{ 0.25f };
+        std::mt19937 random{ 1 };
+        std::uniform_real_distribution<float> spread{ -20.0f, 20.0f };
+        std::uniform_real_distribution<float> distance{ -60.0f, -2.0f };
+        std::uniform_int_distribution<int> pickProgram{ 0, configuration::programs - 1 };
+        std::uniform_int_distribution<int> pickMaterial{ 0, configuration::materials - 1 };
+
+        std::vector<Object<Cube>> objects{};
+        objects.reserve(static_cast<std::size_t>(objectCount));
+        for (int i{ 0 }; i < objectCount; ++i)
+            objects.emplace_back(cube, glm::vec3{ spread(random), spread(random), distance(random) },
+                                 *shaders[pickProgram(random)], materials[pickMaterial(random)]);
+
+        std::cout << objectCount << " cubes, " << configuration::programs << " programs, " << configuration::materials << " materials\n";
+
+        // submission order
+        //-----------------
+        RenderQueueStats unsorted{};
+        auto drawUnsorted{ [&] {
+            unsorted = {};
+            Shader* currentShader{ nullptr };
+            BenchmarkMaterial* currentMaterial{ nullptr };
+
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            for (auto& object : objects)
+            {
+                Shader& shader{ object.getShader() };
+                if (&shader != currentShader)
+                {
+                    shader.use();
+                    currentShader = &shader;
+                    currentMaterial = nullptr;
+                    ++unsorted.programChanges;
+                }
+                if (&object.getMaterial() != currentMaterial)
+                {
+                    Object<Cube>::bindMaterial(&object.getMaterial(), shader);
+                    currentMaterial = &object.getMaterial();
+                    ++unsorted.materialChanges;
+                }
+
+                shader.setMat4("model", object.getModelMatrix());
+                shader.setMat3("normalMatrix", normalMatrix(object.getModelMatrix()));
+                object.getObject().draw();
+                ++unsorted.draws;
+            }
+            GLState::endFrame();
+        } };
+
+        // render queue
+        //-------------
+        RenderQueue renderQueue{};
+        RenderQueueStats sorted{};
+        double sortMs{ 0.0 };
+        auto drawSorted{ [&] {
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            for (auto& object : objects)
+                renderQueue.submit(RenderPass::OPAQUE, object.getShader(), object.getObject(), object.getModelMatrix(),
+                                   RenderQueue::viewDepth(view, object.getModelMatrix()), &object.getMaterial(), Object<Cube>::bindMaterial);
+            renderQueue.flush();
+            sorted = renderQueue.getStats();
+            sortMs += sorted.sortMs;
+            GLState::endFrame();
+        } };
+
+        auto frameTime{ [](auto& draw) {
+            draw();             // warm up
+            glFinish();
+
+            auto start{ std::chrono::steady_clock::now() };
+            for (int frame{ 0 }; frame < configuration::frames; ++frame)
+                draw();
+            glFinish();
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / configuration::frames;
+        } };
+
+        auto print{ [](const char* name, const RenderQueueStats& stats, double ms) {
+            const auto& frame{ GLState::getLastFrame() };
+            std::cout << "    " << name << ": " << stats.draws << " draws, " << stats.programChanges << " program changes, "
+                      << stats.materialChanges << " material changes, " << frame.issued[GLStateCounters::TEXTURE] << " texture binds, "
+                      << ms << " ms per frame\n";
+        } };
+
+        double unsortedMs{ frameTime(drawUnsorted) };
+        print("submission order", unsorted, unsortedMs);
+
+        double sortedMs{ frameTime(drawSorted) };
+        print("render queue    ", sorted, sortedMs);
+        std::cout << "    sort: " << sortMs / (configuration::frames + 1) << " ms per frame" << std::endl;
+
+        cube.deleteBuffers();
+    }
+
+    glfwTerminate();
+    return 0;
+}
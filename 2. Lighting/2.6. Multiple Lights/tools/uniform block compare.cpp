@@ -0,0 +1,267 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <shader_header/shader.h>
+#include <shader_header/uniform_buffer.h>
+#include <transform_header/transform.h>
+#include <camera_header/camera.h>
+#include <light_header/light.h>
+#include <texture_header/texture.h>
+#include <texture_header/texture_units.h>
+#include <gl_state_header/gl_state.h>
+#include <shapes/cube/cube.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <iostream>
+
+
+//=======================================================================================
+
+
+namespace configuration
+{
+    constexpr int width{ 800 };
+    constexpr int height{ 600 };
+    constexpr int tolerance{ 1 };       // per channel, 8 bit
+}
+
+
+namespace
+{
+    // "layout (std140) uniform Block { members };" -> one plain uniform per member, the shaders
+    // as they were before the uniform buffers
+    std::string withoutUniformBlocks(std::string source)
+    {
+        constexpr std::string_view marker{ "layout (std140) uniform " };
+        for (auto start{ source.find(marker) }; start != std::string::npos; start = source.find(marker, start))
+        {
+            auto open{ source.find('{', start) };
+            auto close{ source.find("};", open) };
+
+            std::string members{};
+            std::istringstream lines{ source.substr(open + 1, close - open - 1) };
+            for (std::string line{}; std::getline(lines, line);)
+            {
+                auto first{ line.find_first_not_of(" \t") };
+                if (first != std::string::npos && line.compare(first, 2, "//") != 0)
+                    members += "uniform " + line.substr(first);
+                members += '\n';
+            }
+            source.replace(start, close + 2 - start, members);
+        }
+        return source;
+    }
+
+    // the per-uniform path: what multiple lights.cpp uploaded to every program each frame
+    void setCamera(const Shader& shader, const std140::CameraBlock& camera)
+    {
+        shader.setMat4("view", camera.view);
+        shader.setMat4("projection", camera.projection);
+        shader.setVec3("viewPos", camera.viewPos);
+    }
+
+    void setLights(const Shader& shader, const std140::LightsBlock& lights, int pointLightCount)
+    {
+        shader.setVec3("dirLight.direction", lights.dirLight.direction);
+        shader.setVec3("dirLight.ambient", lights.dirLight.ambient);
+        shader.setVec3("dirLight.diffuse", lights.dirLight.diffuse);
+        shader.setVec3("dirLight.specular", lights.dirLight.specular);
+
+        const auto& spot{ lights.spotLight };
+        shader.setVec3("spotLight.position", spot.position);
+        shader.setVec3("spotLight.direction", spot.direction);
+        shader.setVec3("spotLight.ambient", spot.ambient);
+        shader.setVec3("spotLight.diffuse", spot.diffuse);
+        shader.setVec3("spotLight.specular", spot.specular);
+        shader.setFloat("spotLight.constant", spot.constant);
+        shader.setFloat("spotLight.linear", spot.linear);
+        shader.setFloat("spotLight.quadratic", spot.quadratic);
+        shader.setFloat("spotLight.cutOff", spot.cutOff);
+        shader.setFloat("spotLight.outerCutOff", spot.outerCutOff);
+
+        for (int i{ 0 }; i < pointLightCount; ++i)
+        {
+            const auto& point{ lights.pointLights[i] };
+            std::string name{ "pointLights[" + std::to_string(i) + "]." };
+            shader.setVec3(name + "position", point.position);
+            shader.setVec3(name + "ambient", point.ambient);
+            shader.setVec3(name + "diffuse", point.diffuse);
+            shader.setVec3(name + "specular", point.specular);
+            shader.setFloat(name + "constant", point.constant);
+            shader.setFloat(name + "linear", point.linear);
+            shader.setFloat(name + "quadratic", point.quadratic);
+        }
+    }
+}
+
+
+/*
+    renders the cubes of the multiple lights demo twice into an offscreen framebuffer: with the
+    camera and light data in the uniform buffers, and with the same shaders rewritten to plain
+    uniforms set one by one (the path before the uniform buffers). the two images must match
+    within 1 per channel:
+
+        cd "2. Lighting/2.6. Multiple Lights" && ./tools/uniform_block_compare
+
+    a hidden window provides the context (llvmpipe without a display: LIBGL_ALWAYS_SOFTWARE=1
+    under xvfb-run). returns 1 if the images differ.
+*/
+int main()
+{
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow* window{ glfwCreateWindow(configuration::width, configuration::height, "uniform block compare", NULL, NULL) };
+    if (!window)
+    {
+        std::cerr << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cerr << "Failed to initialize GLAD" << std::endl;
+        glfwTerminate();
+        return 1;
+    }
+
+    std::size_t differing{ 0 };
+    {
+        // offscreen target, the hidden window's framebuffer may not be rendered at all
+        unsigned int framebuffer{}, color{}, depth{};
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glGenRenderbuffers(1, &color);
+        glBindRenderbuffer(GL_RENDERBUFFER, color);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, configuration::width, configuration::height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+        glGenRenderbuffers(1, &depth);
+        glBindRenderbuffer(GL_RENDERBUFFER, depth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, configuration::width, configuration::height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+        glViewport(0, 0, configuration::width, configuration::height);
+        GLState::enable(GL_DEPTH_TEST);
+
+        UniformBuffer<std140::CameraBlock> cameraBuffer{ "Camera", 0 };
+        UniformBuffer<std140::LightsBlock> lightsBuffer{ "Lights", 1 };
+
+        // the scene of the demo, seen from its start position
+        Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+        auto projection{ glm::perspective(glm::radians(camera.fov), static_cast<float>(configuration::width) / configuration::height, 0.1f, 100.0f) };
+        std140::CameraBlock cameraBlock{ camera.toStd140(projection) };
+
+        glm::vec3 pointLightPositions[]{ { 0.7f, 0.2f, 2.0f }, { 2.3f, -3.3f, -4.0f }, { -4.0f, 2.0f, -12.0f }, { 0.0f, 0.0f, -3.0f } };
+        constexpr int pointLightCount{ static_cast<int>(std::size(pointLightPositions)) };
+
+        std140::LightsBlock lights{};
+        lights.dirLight = DirectionalLight{ { -0.2f, -1.0f, -0.3f }, glm::vec3{ 0.05f }, glm::vec3{ 0.5f }, glm::vec3{ 1.0f } }.toStd140();
+        lights.spotLight = SpotLight{ camera.position, camera.front, glm::vec3{ 0.0f }, glm::vec3{ 1.0f }, glm::vec3{ 1.0f },
+                                      1.0f, 0.09f, 0.032f, 12.5f, 15.0f }.toStd140();
+        for (int i{ 0 }; i < pointLightCount; ++i)
+            lights.pointLights[i] = PointLight{ pointLightPositions[i], glm::vec3{ 0.05f }, glm::vec3{ 0.5f }, glm::vec3{ 1.0f },
+                                                1.0f, 0.09f, 0.032f }.toStd140();
+
+        cameraBuffer.update(cameraBlock);
+        lightsBuffer.update(lights);
+
+        ShaderDefines defines{};
+        defines.set("NR_POINT_LIGHTS", pointLightCount);
+        ShaderSource vertex{ "shader.vs", defines };
+        ShaderSource fragment{ "shader.fs", defines };
+        if (!vertex.isValid() || !fragment.isValid())
+        {
+            std::cerr << "shader.vs / shader.fs not found, run from the demo directory" << std::endl;
+            glfwTerminate();
+            return 1;
+        }
+
+        Shader blocks{ vertex, fragment };
+        std::string vertexCode{ withoutUniformBlocks(vertex.toString()) };
+        std::string fragmentCode{ withoutUniformBlocks(fragment.toString()) };
+        Shader uniforms{ ShaderSource::fromString(vertexCode.c_str()), ShaderSource::fromString(fragmentCode.c_str()) };
+
+        Texture diffuse{ "../../resources/img/container2.png" };
+        Texture specular{ "../../resources/img/container2_specular_new.png" };
+        Cube cube{ 0.5f };
+
+        glm::vec3 cubePositions[]{
+            { 0.0f, 0.0f, 0.0f }, { 2.0f, 5.0f, -15.0f }, { -1.5f, -2.2f, -2.5f }, { -3.8f, -2.0f, -12.3f }, { 2.4f, -0.4f, -3.5f },
+            { -1.7f, 3.0f, -7.5f }, { 1.3f, -2.0f, -2.5f }, { 1.5f, 2.0f, -2.5f }, { 1.5f, 0.2f, -1.5f }, { -1.3f, 1.0f, -1.5f }
+        };
+
+        auto render{ [&](const Shader& shader) {
+            glClearColor(0.1f, 0.1f, 0.11f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            shader.use();
+            if (&shader == &uniforms)
+            {
+                setCamera(shader, cameraBlock);
+                setLights(shader, lights, pointLightCount);
+            }
+            shader.setFloat("material.shininess", 32.0f);
+            TextureUnits::beginDraw();
+            TextureUnits::bind(shader, "material.diffuse", GL_TEXTURE_2D, diffuse.textureID);
+            TextureUnits::bind(shader, "material.specular", GL_TEXTURE_2D, specular.textureID);
+
+            for (int i{ 0 }; i < static_cast<int>(std::size(cubePositions)); ++i)
+            {
+                glm::mat4 model{ glm::translate(glm::mat4(1.0f), cubePositions[i]) };
+                model = glm::rotate(model, glm::radians(20.0f * i), glm::vec3(1.0f, 0.3f, 0.5f));
+                shader.setMat4("model", model);
+                shader.setMat3("normalMatrix", normalMatrix(model));
+                cube.draw();
+            }
+
+            std::vector<unsigned char> pixels(static_cast<std::size_t>(configuration::width) * configuration::height * 4);
+            glReadPixels(0, 0, configuration::width, configuration::height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+            return pixels;
+        } };
+
+        auto blockImage{ render(blocks) };
+        auto uniformImage{ render(uniforms) };
+
+        int maxDifference{ 0 };
+        for (std::size_t i{ 0 }; i < blockImage.size(); i += 4)
+        {
+            int difference{ 0 };
+            for (std::size_t c{ 0 }; c < 3; ++c)
+                difference = std::max(difference, std::abs(blockImage[i + c] - uniformImage[i + c]));
+
+            maxDifference = std::max(maxDifference, difference);
+            if (difference > configuration::tolerance)
+                ++differing;
+        }
+
+        // two images of the clear color match too, the cubes have to be there
+        std::size_t lit{ static_cast<std::size_t>(std::count_if(blockImage.begin(), blockImage.end(), [](unsigned char c) { return c > 40; })) };
+        if (lit == 0)
+            differing = blockImage.size() / 4;
+
+        std::cout << (differing ? "FAIL" : "ok") << ": " << differing << " of " << blockImage.size() / 4 << " pixels differ by more than "
+                  << configuration::tolerance << " (max " << maxDifference << ")" << (lit ? "" : ", nothing was drawn") << std::endl;
+
+        glDeleteProgram(blocks.ID);
+        glDeleteProgram(uniforms.ID);
+        cube.deleteBuffers();
+        glDeleteRenderbuffers(1, &color);
+        glDeleteRenderbuffers(1, &depth);
+        glDeleteFramebuffers(1, &framebuffer);
+        TextureCache::clear();
+    }
+
+    glfwTerminate();
+    return differing ? 1 : 0;
+}
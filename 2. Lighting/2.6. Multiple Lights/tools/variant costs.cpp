@@ -0,0 +1,244 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <shader_header/shader.h>
+#include <shader_header/shader_library.h>
+#include <shader_header/uniform_buffer.h>
+#include <camera_header/camera.h>
+#include <light_header/light.h>
+#include <texture_header/texture.h>
+#include <texture_header/texture_units.h>
+#include <gl_state_header/gl_state.h>
+#include <shapes/cube/cube.h>
+
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <iostream>
+
+
+//=======================================================================================
+
+
+namespace configuration
+{
+    constexpr int width{ 1024 };
+    constexpr int height{ 768 };
+    constexpr int layers{ 10 };         // full screen layers per frame (2 per cube: front and back faces)
+    constexpr int frames{ 20 };
+    constexpr int switchDraws{ 10000 }; // draws per frame of the switching test
+}
+
+
+namespace
+{
+    struct Variant
+    {
+        std::string   name{};
+        ShaderDefines defines{};
+    };
+
+    void bindMaterial(Shader& shader, const Texture& diffuse, const Texture& specular)
+    {
+        shader.use();
+        TextureUnits::beginDraw();
+        TextureUnits::bind(shader, "material.diffuse", GL_TEXTURE_2D, diffuse.textureID);
+        TextureUnits::bind(shader, "material.specular", GL_TEXTURE_2D, specular.textureID);
+        shader.setFloat("material.shininess", 32.0f);
+    }
+
+    // GPU time of `frames` frames of `draw`, in ms per frame
+    template <class Draw>
+    double gpuTime(Draw draw)
+    {
+        unsigned int query{};
+        glGenQueries(1, &query);
+
+        draw();             // warm up (first use compiles the draw state)
+        glFinish();
+
+        double total{ 0.0 };
+        for (int frame{ 0 }; frame < configuration::frames; ++frame)
+        {
+            glBeginQuery(GL_TIME_ELAPSED, query);
+            draw();
+            glEndQuery(GL_TIME_ELAPSED);
+
+            GLuint64 ns{};
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &ns);
+            total += static_cast<double>(ns) / 1e6;
+        }
+
+        glDeleteQueries(1, &query);
+        return total / configuration::frames;
+    }
+
+    // CPU time (submission until glFinish) of `frames` frames of `draw`, in ms per frame
+    template <class Draw>
+    double cpuTime(Draw draw)
+    {
+        draw();
+        glFinish();
+
+        auto start{ std::chrono::steady_clock::now() };
+        for (int frame{ 0 }; frame < configuration::frames; ++frame)
+            draw();
+        glFinish();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / configuration::frames;
+    }
+}
+
+
+/*
+    what picking a specialized variant of the multiple lights shader costs and saves:
+
+    fragment cost: full screen layers drawn with the unspecialized program (4 point lights,
+    specular map) and with variants for 0 to 4 point lights, with and without specular map,
+    GPU time per layer from timer queries
+
+    switching: ShaderLibrary::load() of an already built variant (what the render loop pays to
+    pick a program per object), and draws alternating between two variants against the same
+    draws sorted by variant (glUseProgram per draw vs. once per variant)
+
+    run from the demo directory (the shaders are loaded from shader.vs / shader.fs):
+
+        cd "2. Lighting/2.6. Multiple Lights" && ./tools/variant_costs
+
+    a hidden window provides the context.
+*/
+int main()
+{
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow* window{ glfwCreateWindow(configuration::width, configuration::height, "variant costs", NULL, NULL) };
+    if (!window)
+    {
+        std::cerr << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cerr << "Failed to initialize GLAD" << std::endl;
+        glfwTerminate();
+        return 1;
+    }
+
+    {
+        UniformBuffer<std140::CameraBlock> cameraBuffer{ "Camera", 0 };
+        UniformBuffer<std140::LightsBlock> lightsBuffer{ "Lights", 1 };
+
+        // identity camera: the cube below covers the screen, every fragment runs the lighting
+        std140::CameraBlock camera{};
+        camera.view = glm::mat4(1.0f);
+        camera.projection = glm::mat4(1.0f);
+        camera.viewPos = glm::vec3{ 0.0f, 0.0f, 2.0f };
+        cameraBuffer.update(camera);
+
+        std140::LightsBlock lights{};
+        lights.dirLight = { { -0.2f, -1.0f, -0.3f }, 0.0f, glm::vec3{ 0.05f }, 0.0f, glm::vec3{ 0.5f }, 0.0f, glm::vec3{ 1.0f } };
+        lights.spotLight = { { 0.0f, 0.0f, 2.0f }, 1.0f, { 0.0f, 0.0f, -1.0f }, std::cos(glm::radians(12.5f)),
+                             glm::vec3{ 0.0f }, std::cos(glm::radians(15.0f)), glm::vec3{ 1.0f }, 0.09f, glm::vec3{ 1.0f }, 0.032f };
+        for (std::size_t i{ 0 }; i < 4; ++i)
+            lights.pointLights[i] = { { i * 0.5f - 0.75f, 0.2f, 1.0f }, 1.0f, glm::vec3{ 0.05f }, 0.09f, glm::vec3{ 0.5f }, 0.032f, glm::vec3{ 1.0f } };
+        lightsBuffer.update(lights);
+
+        ShaderLibrary shaderLibrary{};
+        Texture diffuse{ 0xa0, 0x80, 0x60 };
+        Texture specular{ 0x80, 0x80, 0x80 };
+
+        Cube cube{ 1.0f };
+        glm::mat4 model{ glm::scale(glm::mat4(1.0f), glm::vec3{ 1.0f, 1.0f, 0.5f }) };
+        glm::mat3 normalMatrix{ 1.0f };
+
+        glViewport(0, 0, configuration::width, configuration::height);
+
+        // fragment cost
+        //--------------
+        std::vector<Variant> variants{ { "unspecialized (4 lights, specular map)", {} } };
+        for (int lightCount : { 0, 1, 2, 4 })
+            for (int specularMap : { 1, 0 })
+            {
+                ShaderDefines defines{};
+                defines.set("NR_POINT_LIGHTS", lightCount);
+                defines.set("HAS_SPECULAR_MAP", specularMap);
+                variants.push_back({ std::to_string(lightCount) + " lights" + (specularMap ? ", specular map" : ""), defines });
+            }
+
+        std::size_t fragments{ static_cast<std::size_t>(configuration::width) * configuration::height * configuration::layers };
+        std::cout << "fragment cost, " << configuration::layers << " layers of " << configuration::width << 'x' << configuration::height << ":\n";
+        for (const auto& variant : variants)
+        {
+            Shader& shader{ shaderLibrary.load("shader.vs", "shader.fs", variant.defines) };
+            bindMaterial(shader, diffuse, specular);
+            shader.setMat4("model", model);
+            shader.setMat3("normalMatrix", normalMatrix);
+
+            double ms{ gpuTime([&cube] {
+                for (int layer{ 0 }; layer < configuration::layers / 2; ++layer)
+                    cube.draw();
+            }) };
+            std::cout << "    " << variant.name << ": " << ms << " ms per frame, " << ms * 1e6 / static_cast<double>(fragments) << " ns per fragment\n";
+        }
+
+        // switching
+        //----------
+        ShaderDefines twoLights{};
+        twoLights.set("NR_POINT_LIGHTS", 2);
+        ShaderDefines fourLights{};
+        fourLights.set("NR_POINT_LIGHTS", 4);
+
+        constexpr int lookups{ 100000 };
+        auto start{ std::chrono::steady_clock::now() };
+        for (int i{ 0 }; i < lookups; ++i)
+            shaderLibrary.load("shader.vs", "shader.fs", i % 2 ? twoLights : fourLights);
+        double lookupUs{ std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / lookups };
+        std::cout << "ShaderLibrary::load() of a built variant: " << lookupUs << " us\n";
+
+        Shader& two{ shaderLibrary.load("shader.vs", "shader.fs", twoLights) };
+        Shader& four{ shaderLibrary.load("shader.vs", "shader.fs", fourLights) };
+        for (Shader* shader : { &two, &four })
+        {
+            bindMaterial(*shader, diffuse, specular);
+            shader->setMat3("normalMatrix", normalMatrix);
+        }
+
+        // tiny cubes: the draw calls and program changes dominate, not the fragments
+        glm::mat4 tiny{ glm::scale(glm::mat4(1.0f), glm::vec3{ 0.001f }) };
+        auto drawSwitching{ [&](bool sorted) {
+            for (int i{ 0 }; i < configuration::switchDraws; ++i)
+            {
+                bool first{ sorted ? i < configuration::switchDraws / 2 : i % 2 == 0 };
+                Shader& shader{ first ? two : four };
+                shader.use();
+                shader.setMat4("model", tiny);
+                cube.draw();
+            }
+            GLState::endFrame();
+        } };
+
+        std::cout << configuration::switchDraws << " draws of two variants:\n";
+        for (bool sorted : { false, true })
+        {
+            double ms{ cpuTime([&] { drawSwitching(sorted); }) };
+            std::cout << "    " << (sorted ? "sorted by variant" : "alternating") << ": " << ms << " ms per frame, "
+                      << GLState::getLastFrame().issued[GLStateCounters::PROGRAM] << " glUseProgram calls\n";
+        }
+        std::cout.flush();
+
+        cube.deleteBuffers();
+    }
+
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,144 @@
+#ifndef INDEX_BUFFER_H
+#define INDEX_BUFFER_H
+
+#include <glad/glad.h>
+
+#include <vector>
+#include <span>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+
+/*
+    element buffer of a mesh, stored with the smallest index type its vertex count allows
+
+    a mesh of at most 65536 vertices gets GL_UNSIGNED_SHORT indices (half the memory and index
+    fetch bandwidth), larger ones GL_UNSIGNED_INT. the callers keep their indices as unsigned int,
+    they are narrowed on upload and the draw calls pass the matching type.
+
+    several ranges (a mesh and its levels of detail) are uploaded one after the other without
+    joining them first: 32 bit indices go to the buffer range by range, 16 bit ones are narrowed
+    straight into the mapped buffer.
+
+    the element buffer binding is VAO state: upload() must be called with the VAO of the mesh
+    bound, draw() expects it bound.
+*/
+class IndexBuffer
+{
+    unsigned int m_EBO{ 0 };
+    GLenum       m_type{ GL_UNSIGNED_INT };
+    GLsizei      m_count{ 0 };
+
+public:
+    static GLenum typeFor(std::size_t vertexCount)
+    {
+        return vertexCount <= 65536 ? GLenum{ GL_UNSIGNED_SHORT } : GLenum{ GL_UNSIGNED_INT };
+    }
+
+    static std::size_t sizeOf(GLenum type) { return type == GL_UNSIGNED_SHORT ? sizeof(std::uint16_t) : sizeof(std::uint32_t); }
+
+    // every index must be smaller than vertexCount
+    void upload(std::span<const unsigned int> indices, std::size_t vertexCount)
+    {
+        upload(std::span<const std::span<const unsigned int>>{ &indices, 1 }, vertexCount);
+    }
+
+    // the ranges one after the other, range i starts at the sum of the sizes before it
+    void upload(std::span<const std::span<const unsigned int>> ranges, std::size_t vertexCount)
+    {
+        if (m_EBO == 0)
+            glGenBuffers(1, &m_EBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+
+        std::size_t count{ 0 };
+        for (const auto& range : ranges)
+            count += range.size();
+
+        m_type = typeFor(vertexCount);
+        m_count = static_cast<GLsizei>(count);
+
+        auto size{ static_cast<GLsizeiptr>(count * sizeOf(m_type)) };
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, nullptr, GL_STATIC_DRAW);
+        if (size == 0 || (m_type == GL_UNSIGNED_SHORT && narrowMapped(ranges, size)))
+            return;
+
+        // 32 bit indices, or the mapping failed: range by range from client memory
+        std::vector<std::uint16_t> narrow{};
+        GLintptr offset{ 0 };
+        for (const auto& range : ranges)
+        {
+            if (m_type == GL_UNSIGNED_SHORT)
+            {
+                narrow.assign(range.begin(), range.end());
+                glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, offset, static_cast<GLsizeiptr>(narrow.size() * sizeof(std::uint16_t)), narrow.data());
+                offset += static_cast<GLintptr>(narrow.size() * sizeof(std::uint16_t));
+            }
+            else
+            {
+                glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, offset, static_cast<GLsizeiptr>(range.size_bytes()), range.data());
+                offset += static_cast<GLintptr>(range.size_bytes());
+            }
+        }
+    }
+
+    void draw(GLenum mode = GL_TRIANGLES) const
+    {
+        glDrawElements(mode, m_count, m_type, 0);
+    }
+
+    // `count` indices from index `first`
+    void draw(std::size_t first, GLsizei count, GLenum mode = GL_TRIANGLES) const
+    {
+        glDrawElements(mode, count, m_type, (void*)(first * sizeOf(m_type)));
+    }
+
+    void drawInstanced(GLsizei instances, GLenum mode = GL_TRIANGLES) const
+    {
+        glDrawElementsInstanced(mode, m_count, m_type, 0, instances);
+    }
+
+    void drawInstanced(std::size_t first, GLsizei count, GLsizei instances, GLenum mode = GL_TRIANGLES) const
+    {
+        glDrawElementsInstanced(mode, count, m_type, (void*)(first * sizeOf(m_type)), instances);
+    }
+
+    // several ranges in one call, offsets from offsetOf()
+    void multiDraw(std::span<const GLsizei> counts, std::span<const void* const> offsets, GLenum mode = GL_TRIANGLES) const
+    {
+        glMultiDrawElements(mode, counts.data(), m_type, offsets.data(), static_cast<GLsizei>(counts.size()));
+    }
+
+    // byte offset of index `first`, as the draw calls take it
+    const void* offsetOf(std::size_t first) const { return (const void*)(first * sizeOf(m_type)); }
+
+    GLenum      type() const { return m_type; }
+    GLsizei     count() const { return m_count; }
+    std::size_t bytes() const { return static_cast<std::size_t>(m_count) * sizeOf(m_type); }
+
+    void deleteBuffer()
+    {
+        glDeleteBuffers(1, &m_EBO);
+        m_EBO = 0;
+        m_count = 0;
+    }
+
+private:
+    // the ranges as 16 bit indices, written into the bound buffer of `size` bytes through a mapping
+    static bool narrowMapped(std::span<const std::span<const unsigned int>> ranges, GLsizeiptr size)
+    {
+        void* destination{ glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT) };
+        if (!destination)
+            return false;
+
+        auto narrow{ static_cast<std::uint16_t*>(destination) };
+        for (const auto& range : ranges)
+            narrow = std::transform(range.begin(), range.end(), narrow, [](unsigned int index) { return static_cast<std::uint16_t>(index); });
+
+        // false: contents lost (e.g. display mode change), upload from client memory instead
+        return glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER) == GL_TRUE;
+    }
+};
+
+
+#endif
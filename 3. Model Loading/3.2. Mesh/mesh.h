@@ -3,28 +3,22 @@
 
 #include <vector>
 #include <string>
+#include <utility>
+#include <span>
+#include <array>
+#include <algorithm>
+#include <cstdint>
 
 #include <glm/glm.hpp>
 #include <glad/glad.h>
 
 #include <shader_header/shader.h>
-
-
-#define MAX_BONE_INFLUENCE 4
-
-
-struct Vertex
-{
-    glm::vec3 m_position{};
-    glm::vec3 m_normal{};
-    glm::vec2 m_texCoords{};
-    glm::vec3 m_tangent{};
-    glm::vec3 m_bitangent{};
-        // bone indexes which will influence this vertex
-        int m_boneIDs[MAX_BONE_INFLUENCE]{};
-        // weights from each bone
-        float m_weights[MAX_BONE_INFLUENCE]{};
-};
+#include <gl_state_header/gl_state.h>
+#include <texture_header/texture_units.h>
+#include <mesh_header/vertex_layout.h>      // Vertex, VertexFormat, VertexLayout
+#include <mesh_header/index_buffer.h>
+#include <mesh_header/mesh_lod.h>           // MeshLod, LodChain
+#include <mesh_header/meshlet.h>            // Meshlet, Frustum
 
 struct Texture
 {
@@ -42,16 +36,39 @@ public:
     std::vector<Texture>      m_textures{};
     unsigned int VAO{};
 
+    // takes ownership of the data (kept on the CPU side, as Vertex whatever the format of the GPU copy),
+    // the levels of detail go to the GPU only, the meshlets (ranges of `indices`) are copied
     Mesh(
         std::vector<Vertex> vertices,
         std::vector<unsigned int> indices,
-        std::vector<Texture> textures
+        std::vector<Texture> textures,
+        VertexFormat format = VertexFormat::FULL,
+        LodChain lods = {},
+        std::span<const Meshlet> meshlets = {}
     )
-        : m_vertices{ vertices }
-        , m_indices{ indices }
-        , m_textures{ textures }
+        : m_vertices{ std::move(vertices) }
+        , m_indices{ std::move(indices) }
+        , m_textures{ std::move(textures) }
+        , m_meshlets{ meshlets.begin(), meshlets.end() }
     {
-        setupMesh();
+        buildSamplerNames();
+        setupMesh(m_vertices, m_indices, format, lods);
+    }
+
+    // upload straight from external memory (e.g. a memory mapped mesh cache), m_vertices and m_indices stay empty
+    Mesh(
+        std::span<const Vertex> vertices,
+        std::span<const unsigned int> indices,
+        std::vector<Texture> textures,
+        VertexFormat format = VertexFormat::FULL,
+        LodChain lods = {},
+        std::span<const Meshlet> meshlets = {}
+    )
+        : m_textures{ std::move(textures) }
+        , m_meshlets{ meshlets.begin(), meshlets.end() }
+    {
+        buildSamplerNames();
+        setupMesh(vertices, indices, format, lods);
     }
 
     void draw(Shader& shader)
@@ -68,17 +85,149 @@ public:
                               materials[N].texture_diffuse
         */
 
+        // meshes sharing maps (a model's materials) find them still bound
+        TextureUnits::beginDraw();
+        for (unsigned int i{ 0 }; i < m_textures.size(); ++i)
+            TextureUnits::bind(shader, m_samplerNames[i], GL_TEXTURE_2D, m_textures[i].m_id);
+
+        // compact vertices are relative to the mesh bounds (COMPACT_VERTICES shader variant)
+        if (m_format == VertexFormat::COMPACT)
+            setDecodeUniforms(shader);
+
+        // draw mesh (the VAO stays bound, redundant binds are filtered)
+        GLState::bindVertexArray(VAO);
+        drawElements();
+    }
+
+    // the triangles of the selected level, or the meshlets left by cull(): one draw call, several
+    // ranges merged into a glMultiDrawElements. expects VAO bound
+    void drawElements() const
+    {
+        if (!m_culling)
+        {
+            const MeshLod& level{ m_lods[m_lod] };
+            m_indexBuffer.draw(level.first, static_cast<GLsizei>(level.count));
+        }
+        else if (m_drawCounts.size() == 1)
+            m_indexBuffer.draw(m_drawFirsts[0], m_drawCounts[0]);
+        else if (!m_drawCounts.empty())
+            m_indexBuffer.multiDraw(m_drawCounts, m_drawOffsets);
+    }
+
+    /*
+        drop the meshlets outside `frustum` or facing away from `camera` (both in object space,
+        see Frustum::fromMatrix()) from the draws until the next cull() or uncull(). the cone test
+        assumes back faces aren't visible anyway (closed meshes, GL_CULL_FACE). meshlets cover
+        the full mesh: at a coarser level of detail nothing is culled
+    */
+    void cull(const Frustum& frustum, const glm::vec3& camera, MeshletCullStats& stats)
+    {
+        m_culling = !m_meshlets.empty() && m_lod == 0;
+        if (!m_culling)
+            return;
+
+        meshlet::cull(m_meshlets, frustum, camera, m_visible, stats);
+
+        m_drawFirsts.clear();
+        m_drawCounts.clear();
+        m_drawOffsets.clear();
+        for (const auto& [first, count] : m_visible)
+        {
+            m_drawFirsts.push_back(first);
+            m_drawCounts.push_back(static_cast<GLsizei>(count));
+            m_drawOffsets.push_back(m_indexBuffer.offsetOf(first));
+        }
+    }
+
+    void uncull() { m_culling = false; }
+
+    std::span<const Meshlet> meshlets() const { return m_meshlets; }
+
+    // the level drawn from now on, from the pixels one object space unit covers on screen
+    // (lod::pixelsPerUnit()), with hysteresis
+    void selectLod(float pixelsPerUnit)
+    {
+        setLod(lod::select(m_lods, m_lod, pixelsPerUnit));
+    }
+
+    // a new level drops the ranges of the last cull()
+    void setLod(int level)
+    {
+        level = std::clamp(level, 0, static_cast<int>(m_lods.size()) - 1);
+        if (level != m_lod)
+            m_culling = false;
+        m_lod = level;
+    }
+
+    int lod() const { return m_lod; }
+
+    // level 0 is the full mesh
+    std::span<const MeshLod> lods() const { return m_lods; }
+
+    // triangles of the level drawn, after culling
+    std::size_t triangleCount() const
+    {
+        if (!m_culling)
+            return m_lods[m_lod].count / 3;
+
+        std::size_t triangles{ 0 };
+        for (GLsizei count : m_drawCounts)
+            triangles += static_cast<std::size_t>(count) / 3;
+        return triangles;
+    }
+
+    void setDecodeUniforms(Shader& shader) const
+    {
+        shader.setVec3("positionScale", m_decode.positionScale);
+        shader.setVec3("positionOffset", m_decode.positionOffset);
+        shader.setVec2("texCoordScale", m_decode.texCoordScale);
+        shader.setVec2("texCoordOffset", m_decode.texCoordOffset);
+    }
+
+    // indices of the full mesh
+    unsigned int indexCount() const { return m_lods[0].count; }
+    VertexFormat format() const { return m_format; }
+
+    // 16 bit indices up to 65536 vertices, the full mesh first then every level of detail,
+    // draws of the mesh with VAO bound go through it
+    const IndexBuffer& indexBuffer() const { return m_indexBuffer; }
+
+    // size of the vertex and index buffers on the GPU
+    std::size_t vertexBytes() const { return m_vertexBytes; }
+    std::size_t indexBytes() const { return m_indexBuffer.bytes(); }
+
+private:
+    // render data
+    unsigned int VBO{};
+    IndexBuffer  m_indexBuffer{};
+    std::vector<MeshLod> m_lods{};
+    int          m_lod{ 0 };
+    VertexFormat m_format{ VertexFormat::FULL };
+    VertexDecode m_decode{};
+    std::size_t  m_vertexBytes{};
+
+    // meshlets of the full mesh, and the index ranges they left to draw
+    std::vector<Meshlet> m_meshlets{};
+    bool         m_culling{ false };        // cull() ran at level 0
+    std::vector<std::array<std::uint32_t, 2>> m_visible{};
+    std::vector<std::uint32_t> m_drawFirsts{};
+    std::vector<GLsizei>       m_drawCounts{};
+    std::vector<const void*>   m_drawOffsets{};
+
+    // sampler uniform name of each texture, built once instead of on every draw
+    std::vector<std::string> m_samplerNames{};
+
+    void buildSamplerNames()
+    {
         unsigned int diffuseNr { 0 };
         unsigned int specularNr{ 0 };
         unsigned int normalNr  { 0 };
         unsigned int heightNr  { 0 };
 
-        for (unsigned int i{ 0 }; i < m_textures.size(); ++i)
+        for (const auto& texture : m_textures)
         {
-            glActiveTexture(GL_TEXTURE0+i);
-
             std::string number{};
-            std::string name{ m_textures[i].m_type };
+            const std::string& name{ texture.m_type };
 
             if (name == "texture_diffuse")
                 number = std::to_string(diffuseNr++);
@@ -89,63 +238,59 @@ public:
             else if (name == "texture_height")
                 number = std::to_string(heightNr++);
 
-            // shader.setInt(("material." + name + number).c_str(), i);            // material.texture_diffuseN
-            shader.setInt(("materials[" + number + "]." + name).c_str(), i);     // materials[N].texture_diffuse
-            // std::cout << "materials[" + number + "]." + name << '\n';
-            glBindTexture(GL_TEXTURE_2D, m_textures[i].m_id);
+            // m_samplerNames.push_back("material." + name + number);           // material.texture_diffuseN
+            m_samplerNames.push_back("materials[" + number + "]." + name);      // materials[N].texture_diffuse
         }
-
-        // draw mesh
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(m_indices.size()), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-
-        glActiveTexture(GL_TEXTURE0);       // set to default
     }
 
-private:
-    // render data
-    unsigned int VBO{};
-    unsigned int EBO{};
-
-    void setupMesh()
+    void setupMesh(std::span<const Vertex> vertices, std::span<const unsigned int> indices, VertexFormat format, LodChain lods)
     {
+        // bone IDs past 255 don't fit the compact layout
+        if (format == VertexFormat::COMPACT && !vertex_layout::canEncodeCompact(vertices))
+            format = VertexFormat::FULL;
+        m_format = format;
+
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
 
-        glBindVertexArray(VAO);
+        GLState::bindVertexArray(VAO);
         
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        // a great thing about structs is that their memory layout is sequential, so we can do this:
-        glBufferData(GL_ARRAY_BUFFER, m_vertices.size()*sizeof(Vertex), &m_vertices.front(), GL_STATIC_DRAW);
+        VertexLayout layout{};
+        if (format == VertexFormat::COMPACT)
+        {
+            auto encoded{ vertex_layout::encodeCompact(vertices) };
+            glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(encoded.bytes.size()), encoded.bytes.data(), GL_STATIC_DRAW);
+            m_vertexBytes = encoded.bytes.size();
+            m_decode = encoded.decode;
+            layout = std::move(encoded.layout);
+        }
+        else
+        {
+            // a great thing about structs is that their memory layout is sequential, so we can do this:
+            glBufferData(GL_ARRAY_BUFFER, vertices.size_bytes(), vertices.data(), GL_STATIC_DRAW);
+            m_vertexBytes = vertices.size_bytes();
+            layout = vertex_layout::full();
+        }
         
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices.size()*sizeof(unsigned int), &m_indices.front(), GL_STATIC_DRAW);
-
-        // vertex positions
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(0));
-        // vertex normals
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(offsetof(Vertex, m_normal)));
-        // vertex texture coords
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(offsetof(Vertex, m_texCoords)));
-        // vertex tangent
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(offsetof(Vertex, m_tangent)));
-        // vertex bitangent
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(offsetof(Vertex, m_bitangent)));
-            // ids
-            glEnableVertexAttribArray(5);
-            glVertexAttribPointer(5, MAX_BONE_INFLUENCE, GL_INT, GL_FALSE, sizeof(Vertex), (void*)(offsetof(Vertex, m_boneIDs)));
-            // weights
-            glEnableVertexAttribArray(6);
-            glVertexAttribPointer(6, MAX_BONE_INFLUENCE, GL_INT, GL_FALSE, sizeof(Vertex), (void*)(offsetof(Vertex, m_weights)));
-
-        glBindVertexArray(0);
+        // the levels of detail after the full mesh, in one buffer
+        m_lods.push_back({ 0, static_cast<std::uint32_t>(indices.size()), 0.0f });
+        if (lods.levels.empty())
+            m_indexBuffer.upload(indices, vertices.size());
+        else
+        {
+            std::array<std::span<const unsigned int>, 2> ranges{ indices, lods.indices };
+            m_indexBuffer.upload(ranges, vertices.size());
+
+            for (const auto& level : lods.levels)
+                m_lods.push_back({ static_cast<std::uint32_t>(indices.size()) + level.first, level.count, level.error });
+        }
+
+        // glVertexAttribPointer of every attribute of the layout (positions 0, normals 1, texture coords 2,
+        // tangents 3, bitangents 4, bone ids 5, bone weights 6)
+        layout.apply();
+
+        GLState::bindVertexArray(0);
     }
 };
 
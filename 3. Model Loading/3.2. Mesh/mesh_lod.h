@@ -0,0 +1,69 @@
+#ifndef MESH_LOD_H
+#define MESH_LOD_H
+
+#include <glm/glm.hpp>
+
+#include <span>
+#include <cmath>
+#include <limits>
+#include <cstdint>
+
+
+// a level of detail of a mesh: a range of its index buffer
+struct MeshLod
+{
+    std::uint32_t first{};      // index of the first index
+    std::uint32_t count{};
+    float         error{};      // geometric error, in object space units (0 for the full mesh)
+};
+
+// levels 1..n of a mesh (level 0 is the mesh itself): their index lists one after the other,
+// MeshLod::first relative to `indices`
+struct LodChain
+{
+    std::span<const unsigned int> indices{};
+    std::span<const MeshLod>      levels{};
+};
+
+
+/*
+    runtime level selection from the projected error
+
+    the error of a level (its distance from the full mesh, see mesh_simplifier.h) times the
+    pixels one unit covers on screen is its error in pixels. the coarsest level within
+    s_pixelError pixels is drawn. a coarser level than the current one has to be within
+    s_pixelError * s_hysteresis, so a mesh at the distance where two levels meet doesn't
+    switch back and forth every frame.
+*/
+namespace lod
+{
+    constexpr float s_pixelError{ 1.0f };
+    constexpr float s_hysteresis{ 0.75f };
+
+    // pixels covered by one unit at `distance` (of a viewport `viewportHeight` pixels high),
+    // unbounded at or behind the camera
+    inline float pixelsPerUnit(float distance, float fovDegrees, int viewportHeight)
+    {
+        if (distance <= 0.0f)
+            return std::numeric_limits<float>::max();
+        return static_cast<float>(viewportHeight) / (2.0f * distance * std::tan(glm::radians(fovDegrees) * 0.5f));
+    }
+
+    // errors grow with the level
+    inline int select(std::span<const MeshLod> levels, int current, float pixelsPerUnit,
+                      float pixelError = s_pixelError, float hysteresis = s_hysteresis)
+    {
+        int selected{ 0 };
+        for (int level{ 1 }; level < static_cast<int>(levels.size()); ++level)
+        {
+            float threshold{ level > current ? pixelError * hysteresis : pixelError };
+            if (levels[level].error * pixelsPerUnit > threshold)
+                break;
+            selected = level;
+        }
+        return selected;
+    }
+}
+
+
+#endif
@@ -0,0 +1,409 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <span>
+#include <numeric>
+#include <algorithm>
+#include <functional>       // std::invoke
+#include <cstdint>
+#include <cstddef>
+
+
+// post-transform vertex cache behaviour of an index list (FIFO cache simulated on the CPU)
+struct VertexCacheStats
+{
+    std::size_t triangles{};
+    std::size_t vertices{};         // distinct vertices referenced
+    std::size_t transformed{};      // cache misses, vertex shader invocations
+
+    // average cache miss ratio: transformed vertices per triangle, 0.5 at best, 3 at worst
+    float acmr() const { return triangles ? static_cast<float>(transformed) / triangles : 0.0f; }
+
+    // average transform to vertex ratio: transformed vertices per vertex, 1 at best
+    float atvr() const { return vertices ? static_cast<float>(transformed) / vertices : 0.0f; }
+
+    VertexCacheStats& operator+=(const VertexCacheStats& other)
+    {
+        triangles += other.triangles;
+        vertices += other.vertices;
+        transformed += other.transformed;
+        return *this;
+    }
+};
+
+
+/*
+    index and vertex order optimization of triangle lists, done once when a mesh is imported or
+    cooked (Model::convertMesh(), Sphere::buildVertices()):
+
+        indices = mesh_optimizer::optimizeVertexCache(indices, vertexCount);      // Tipsify
+        indices = mesh_optimizer::optimizeOverdraw(indices, positions);           // cluster order
+        remap   = mesh_optimizer::optimizeVertexFetch(indices, vertexCount);      // first use order
+        vertices = mesh_optimizer::remapVertices<Vertex>(vertices, remap);
+
+    or mesh_optimizer::optimize(vertices, indices, &Vertex::m_position) for all of it.
+
+    optimizeVertexCache() is Tipsify (Sander, Nehab, Barczak, "Fast Triangle Reordering for
+    Vertex Locality and Reduced Overdraw", 2007): it fans around a vertex, then continues with
+    the neighbour that is still in the cache, so the triangles come in cache sized patches.
+    optimizeOverdraw() cuts the result into clusters where the cache was flushed (or where a
+    cluster is already almost as cache friendly as its patch) and sorts the clusters so the
+    outward facing ones on the outside of the mesh are drawn first, they occlude the rest.
+    clusters keep their triangles in order, so the cache efficiency barely changes.
+
+    optimizeVertexFetch() renumbers the vertices in the order the index list first uses them,
+    the vertex fetches then walk the vertex buffer front to back. vertices that no triangle uses
+    (e.g. ones only drawn as lines) are kept after the others.
+
+    index lists must be triangle lists, every index smaller than vertexCount.
+*/
+namespace mesh_optimizer
+{
+    // the post-transform cache of most GPUs holds somewhere between 16 and 32 vertices, a
+    // smaller assumed size still works well on a larger cache (the other way round it doesn't)
+    constexpr unsigned int s_cacheSize{ 16 };
+
+    // a cluster may be split where its prefix has at most this many times the cache misses
+    // per triangle of the whole cluster
+    constexpr float s_overdrawThreshold{ 1.05f };
+
+
+    namespace detail
+    {
+        // triangles around each vertex: triangles[offsets[v] .. offsets[v + 1])
+        struct Adjacency
+        {
+            std::vector<unsigned int> offsets{};
+            std::vector<unsigned int> triangles{};
+        };
+
+        inline Adjacency buildAdjacency(std::span<const unsigned int> indices, std::size_t vertexCount)
+        {
+            Adjacency adjacency{};
+            adjacency.offsets.assign(vertexCount + 1, 0);
+            for (unsigned int index : indices)
+                ++adjacency.offsets[index + 1];
+            std::partial_sum(adjacency.offsets.begin(), adjacency.offsets.end(), adjacency.offsets.begin());
+
+            adjacency.triangles.resize(indices.size());
+            std::vector<unsigned int> fill{ adjacency.offsets.begin(), adjacency.offsets.end() - 1 };
+            for (std::size_t i{ 0 }; i < indices.size(); ++i)
+                adjacency.triangles[fill[indices[i]]++] = static_cast<unsigned int>(i / 3);
+
+            return adjacency;
+        }
+
+        // FIFO cache, a vertex is cached if it was one of the last `size` misses
+        class FifoCache
+        {
+        public:
+            FifoCache(std::size_t vertexCount, unsigned int size)
+                : m_size{ size }
+                , m_time{ size }
+                , m_insertTimes(vertexCount, 0)
+            {
+            }
+
+            // true on a miss (the vertex is transformed and pushed)
+            bool access(unsigned int vertex)
+            {
+                if (m_time - m_insertTimes[vertex] < m_size)
+                    return false;
+                m_insertTimes[vertex] = m_time++;
+                return true;
+            }
+
+            // the next accesses all miss, as with a new draw call
+            void flush() { m_time += m_size; }
+
+        private:
+            unsigned int              m_size{};
+            std::uint64_t             m_time{};
+            std::vector<std::uint64_t> m_insertTimes{};
+        };
+
+        inline unsigned int triangleMisses(FifoCache& cache, std::span<const unsigned int> indices, std::size_t triangle)
+        {
+            unsigned int misses{ 0 };
+            for (std::size_t k{ 0 }; k < 3; ++k)
+                misses += cache.access(indices[triangle * 3 + k]) ? 1 : 0;
+            return misses;
+        }
+    }
+
+
+    inline VertexCacheStats analyzeVertexCache(std::span<const unsigned int> indices, std::size_t vertexCount, unsigned int cacheSize = s_cacheSize)
+    {
+        VertexCacheStats stats{};
+        stats.triangles = indices.size() / 3;
+
+        detail::FifoCache cache{ vertexCount, cacheSize };
+        std::vector<bool> used(vertexCount, false);
+        for (unsigned int index : indices)
+        {
+            stats.transformed += cache.access(index) ? 1 : 0;
+            if (!used[index])
+            {
+                used[index] = true;
+                ++stats.vertices;
+            }
+        }
+        return stats;
+    }
+
+
+    // Tipsify, the same triangles in an order that reuses the post-transform cache
+    inline std::vector<unsigned int> optimizeVertexCache(std::span<const unsigned int> indices, std::size_t vertexCount, unsigned int cacheSize = s_cacheSize)
+    {
+        std::size_t triangleCount{ indices.size() / 3 };
+        std::vector<unsigned int> result{};
+        result.reserve(triangleCount * 3);
+        if (triangleCount == 0 || vertexCount == 0)
+            return result;
+
+        detail::Adjacency adjacency{ detail::buildAdjacency(indices, vertexCount) };
+
+        // triangles left to emit around each vertex
+        std::vector<unsigned int> live(vertexCount);
+        for (std::size_t v{ 0 }; v < vertexCount; ++v)
+            live[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+
+        std::vector<std::uint64_t> cacheTimes(vertexCount, 0);
+        std::vector<bool> emitted(triangleCount, false);
+        std::vector<unsigned int> deadEnd{};            // recently used vertices, to continue from when a fan runs dry
+        std::vector<unsigned int> candidates{};
+        std::uint64_t time{ cacheSize + 1u };
+        std::size_t cursor{ 0 };                        // every vertex before it has no live triangle left
+
+        // a vertex with live triangles, from the dead end stack first, then in input order
+        auto skipDeadEnd{ [&]() -> std::int64_t {
+            while (!deadEnd.empty())
+            {
+                unsigned int vertex{ deadEnd.back() };
+                deadEnd.pop_back();
+                if (live[vertex] > 0)
+                    return vertex;
+            }
+            for (; cursor < vertexCount; ++cursor)
+                if (live[cursor] > 0)
+                    return static_cast<std::int64_t>(cursor);
+            return -1;
+        } };
+
+        std::int64_t fan{ skipDeadEnd() };
+        while (fan >= 0)
+        {
+            candidates.clear();
+
+            auto vertex{ static_cast<std::size_t>(fan) };
+            for (unsigned int a{ adjacency.offsets[vertex] }; a < adjacency.offsets[vertex + 1]; ++a)
+            {
+                unsigned int triangle{ adjacency.triangles[a] };
+                if (emitted[triangle])
+                    continue;
+                emitted[triangle] = true;
+
+                for (std::size_t k{ 0 }; k < 3; ++k)
+                {
+                    unsigned int v{ indices[triangle * 3 + k] };
+                    result.push_back(v);
+                    deadEnd.push_back(v);
+                    candidates.push_back(v);
+                    --live[v];
+                    if (time - cacheTimes[v] > cacheSize)
+                        cacheTimes[v] = time++;
+                }
+            }
+
+            // the candidate that stays in the cache while its remaining fan is emitted, the
+            // oldest of them (it would leave the cache first), otherwise a dead end vertex
+            std::int64_t next{ -1 };
+            std::uint64_t best{ 0 };
+            for (unsigned int v : candidates)
+            {
+                if (live[v] == 0)
+                    continue;
+
+                std::uint64_t age{ time - cacheTimes[v] };
+                std::uint64_t priority{ age + 2u * live[v] <= cacheSize ? age : 0 };
+                if (next < 0 || priority > best)
+                {
+                    next = v;
+                    best = priority;
+                }
+            }
+
+            fan = next >= 0 ? next : skipDeadEnd();
+        }
+
+        return result;
+    }
+
+
+    // reorders the clusters of a cache optimized index list (optimizeVertexCache()) so that the
+    // surfaces in front are drawn first
+    inline std::vector<unsigned int> optimizeOverdraw(
+        std::span<const unsigned int> indices,
+        std::span<const glm::vec3> positions,
+        float threshold = s_overdrawThreshold,
+        unsigned int cacheSize = s_cacheSize
+    )
+    {
+        std::size_t triangleCount{ indices.size() / 3 };
+        if (triangleCount == 0)
+            return {};
+
+        // hard boundaries: triangles that miss all 3 vertices, the cache holds nothing of what came before
+        std::vector<std::size_t> hard{};
+        {
+            detail::FifoCache cache{ positions.size(), cacheSize };
+            for (std::size_t t{ 0 }; t < triangleCount; ++t)
+                if (detail::triangleMisses(cache, indices, t) == 3 || t == 0)
+                    hard.push_back(t);
+            hard.push_back(triangleCount);
+        }
+
+        // soft boundaries: a cluster is cut where its prefix is already about as cache friendly
+        // as the whole cluster, cutting there costs (almost) nothing
+        std::vector<std::size_t> starts{};
+        {
+            detail::FifoCache cache{ positions.size(), cacheSize };
+            for (std::size_t c{ 0 }; c + 1 < hard.size(); ++c)
+            {
+                std::size_t begin{ hard[c] };
+                std::size_t end{ hard[c + 1] };
+
+                cache.flush();
+                unsigned int clusterMisses{ 0 };
+                for (std::size_t t{ begin }; t < end; ++t)
+                    clusterMisses += detail::triangleMisses(cache, indices, t);
+                float clusterACMR{ static_cast<float>(clusterMisses) / static_cast<float>(end - begin) };
+
+                cache.flush();
+                starts.push_back(begin);
+                unsigned int misses{ 0 };
+                std::size_t triangles{ 0 };
+                for (std::size_t t{ begin }; t < end; ++t)
+                {
+                    misses += detail::triangleMisses(cache, indices, t);
+                    ++triangles;
+
+                    if (t + 1 < end && static_cast<float>(misses) <= clusterACMR * threshold * static_cast<float>(triangles))
+                    {
+                        starts.push_back(t + 1);
+                        cache.flush();
+                        misses = 0;
+                        triangles = 0;
+                    }
+                }
+            }
+            starts.push_back(triangleCount);
+        }
+
+        // area weighted centroid and normal of each cluster, and of the whole mesh
+        std::size_t clusterCount{ starts.size() - 1 };
+        std::vector<glm::vec3> centroids(clusterCount, glm::vec3{ 0.0f });
+        std::vector<glm::vec3> normals(clusterCount, glm::vec3{ 0.0f });
+        std::vector<float> areas(clusterCount, 0.0f);
+        glm::vec3 meshCentroid{ 0.0f };
+        float meshArea{ 0.0f };
+
+        for (std::size_t c{ 0 }; c < clusterCount; ++c)
+        {
+            for (std::size_t t{ starts[c] }; t < starts[c + 1]; ++t)
+            {
+                const glm::vec3& p0{ positions[indices[t * 3]] };
+                const glm::vec3& p1{ positions[indices[t * 3 + 1]] };
+                const glm::vec3& p2{ positions[indices[t * 3 + 2]] };
+
+                glm::vec3 normal{ glm::cross(p1 - p0, p2 - p0) };     // length: twice the area
+                float area{ glm::length(normal) };
+                centroids[c] += (p0 + p1 + p2) * (area / 3.0f);
+                normals[c] += normal;
+                areas[c] += area;
+            }
+            meshCentroid += centroids[c];
+            meshArea += areas[c];
+            if (areas[c] > 0.0f)
+                centroids[c] /= areas[c];
+        }
+        if (meshArea > 0.0f)
+            meshCentroid /= meshArea;
+
+        // the farther out a cluster is along its normal, the earlier it's drawn
+        std::vector<float> keys(clusterCount, 0.0f);
+        for (std::size_t c{ 0 }; c < clusterCount; ++c)
+        {
+            float length{ glm::length(normals[c]) };
+            if (length > 0.0f)
+                keys[c] = glm::dot(centroids[c] - meshCentroid, normals[c] / length);
+        }
+
+        std::vector<std::size_t> order(clusterCount);
+        std::iota(order.begin(), order.end(), std::size_t{ 0 });
+        std::stable_sort(order.begin(), order.end(), [&keys](std::size_t a, std::size_t b) { return keys[a] > keys[b]; });
+
+        std::vector<unsigned int> result{};
+        result.reserve(triangleCount * 3);
+        for (std::size_t c : order)
+            result.insert(result.end(), indices.begin() + starts[c] * 3, indices.begin() + starts[c + 1] * 3);
+        return result;
+    }
+
+
+    // renumbers the vertices in first use order (rewrites `indices`), returns old -> new index
+    inline std::vector<unsigned int> optimizeVertexFetch(std::span<unsigned int> indices, std::size_t vertexCount)
+    {
+        constexpr unsigned int unused{ ~0u };
+        std::vector<unsigned int> remap(vertexCount, unused);
+
+        unsigned int next{ 0 };
+        for (unsigned int& index : indices)
+        {
+            if (remap[index] == unused)
+                remap[index] = next++;
+            index = remap[index];
+        }
+
+        // unreferenced vertices go to the end, in their old order
+        for (auto& slot : remap)
+            if (slot == unused)
+                slot = next++;
+
+        return remap;
+    }
+
+    // the vertices in their new order, a vertex being `components` consecutive values
+    // (1 for a vertex struct, e.g. 3 for a flat array of positions)
+    template<typename T>
+    std::vector<T> remapVertices(std::span<const T> values, std::span<const unsigned int> remap, std::size_t components = 1)
+    {
+        std::vector<T> result(values.size());
+        for (std::size_t v{ 0 }; v < remap.size(); ++v)
+            std::copy_n(values.begin() + v * components, components, result.begin() + remap[v] * components);
+        return result;
+    }
+
+    // every step on a vertex array, `position` gets the glm::vec3 position of a vertex
+    // (a member pointer such as &Vertex::m_position works)
+    template<typename V, typename Position>
+    void optimize(std::vector<V>& vertices, std::vector<unsigned int>& indices, Position position)
+    {
+        std::vector<glm::vec3> positions{};
+        positions.reserve(vertices.size());
+        for (const auto& vertex : vertices)
+            positions.push_back(std::invoke(position, vertex));
+
+        indices = optimizeVertexCache(indices, vertices.size());
+        indices = optimizeOverdraw(indices, positions);
+
+        std::vector<unsigned int> remap{ optimizeVertexFetch(indices, vertices.size()) };
+        vertices = remapVertices<V>(vertices, remap);
+    }
+}
+
+
+#endif
@@ -0,0 +1,386 @@
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+#include <glm/glm.hpp>
+
+#include <mesh_header/mesh_lod.h>           // MeshLod
+#include <mesh_header/mesh_optimizer.h>     // optimizeVertexCache()
+#include <mesh_header/vertex_welder.h>      // vertices sharing a position
+
+#include <vector>
+#include <span>
+#include <unordered_set>
+#include <algorithm>
+#include <numeric>          // std::iota
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
+
+// per vertex attributes the simplifier keeps an eye on, `weights.size()` floats per vertex
+struct SimplifyAttributes
+{
+    std::span<const float> values{};
+    std::span<const float> weights{};
+};
+
+
+/*
+    mesh simplification by edge collapse with quadric error metrics (Garland, Heckbert, "Surface
+    Simplification Using Quadric Error Metrics", 1997)
+
+    a vertex is collapsed onto a neighbour, only the index list changes: every level of detail
+    uses the vertex buffer of the full mesh, the levels are ranges of one index buffer. the
+    cost of a collapse is the squared distance of the neighbour to the planes of the triangles
+    the vertex was part of (its quadric), plus the weighted squared difference of their
+    attributes (normal, texture coordinates), so a collapse that visibly stretches the texture
+    or bends the shading costs more.
+
+    vertices on a border (an edge with a single triangle) or on a seam (several vertices at one
+    position, e.g. where the texture coordinates wrap) are never moved, the outline of the mesh
+    and its UV seams stay where they are. collapses that would flip a triangle are rejected.
+
+    errors are relative to the mesh extent inside the simplifier (so the attribute weights
+    don't depend on the size of the model), the levels of buildLods() have them in mesh units.
+
+        auto levels{ mesh_simplifier::buildLods(indices, positions, attributes) };
+*/
+namespace mesh_simplifier
+{
+    constexpr int   s_maxLevels{ 4 };
+    constexpr float s_levelRatio{ 0.5f };           // triangles of a level relative to the previous one
+    constexpr float s_minReduction{ 0.9f };         // a level with more than 90% of the previous one's triangles isn't worth it
+    constexpr std::size_t s_minTriangles{ 32 };     // no level below this
+    constexpr float s_maxError{ 0.05f };            // no collapse moves the surface by more than this part of the mesh extent
+
+    struct Level
+    {
+        std::vector<unsigned int> indices{};
+        float                     error{};          // in mesh units
+    };
+
+
+    namespace detail
+    {
+        // symmetric 4x4 matrix, sum of squared distances to weighted planes
+        struct Quadric
+        {
+            double a00{}, a01{}, a02{}, a03{};
+            double a11{}, a12{}, a13{};
+            double a22{}, a23{};
+            double a33{};
+            double weight{};
+
+            static Quadric plane(const glm::dvec3& normal, double distance, double weight)
+            {
+                Quadric q{};
+                q.a00 = normal.x * normal.x * weight;
+                q.a01 = normal.x * normal.y * weight;
+                q.a02 = normal.x * normal.z * weight;
+                q.a03 = normal.x * distance * weight;
+                q.a11 = normal.y * normal.y * weight;
+                q.a12 = normal.y * normal.z * weight;
+                q.a13 = normal.y * distance * weight;
+                q.a22 = normal.z * normal.z * weight;
+                q.a23 = normal.z * distance * weight;
+                q.a33 = distance * distance * weight;
+                q.weight = weight;
+                return q;
+            }
+
+            Quadric& operator+=(const Quadric& q)
+            {
+                a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+                a11 += q.a11; a12 += q.a12; a13 += q.a13;
+                a22 += q.a22; a23 += q.a23;
+                a33 += q.a33;
+                weight += q.weight;
+                return *this;
+            }
+
+            // mean squared distance of p to the planes
+            double error(const glm::dvec3& p) const
+            {
+                if (weight <= 0.0)
+                    return 0.0;
+
+                double sum{ a00 * p.x * p.x + a11 * p.y * p.y + a22 * p.z * p.z + a33
+                          + 2.0 * (a01 * p.x * p.y + a02 * p.x * p.z + a12 * p.y * p.z + a03 * p.x + a13 * p.y + a23 * p.z) };
+                return std::max(sum, 0.0) / weight;
+            }
+        };
+
+        inline glm::dvec3 triangleNormal(const glm::dvec3& p0, const glm::dvec3& p1, const glm::dvec3& p2)
+        {
+            return glm::cross(p1 - p0, p2 - p0);
+        }
+    }
+
+
+    /*
+        the triangles of `indices` reduced to `targetIndexCount` indices or fewer, as long as no
+        collapse costs more than `targetError` (relative to the mesh extent). `resultError` gets
+        the largest error of the collapses done (relative as well).
+    */
+    inline std::vector<unsigned int> simplify(
+        std::span<const unsigned int> indices,
+        std::span<const glm::vec3> positions,
+        const SimplifyAttributes& attributes,
+        std::size_t targetIndexCount,
+        float targetError = 1.0f,
+        float* resultError = nullptr
+    )
+    {
+        std::size_t vertexCount{ positions.size() };
+        std::size_t attributeCount{ attributes.weights.size() };
+        std::vector<unsigned int> result(indices.begin(), indices.end());
+        if (resultError)
+            *resultError = 0.0f;
+        if (result.size() <= targetIndexCount || vertexCount == 0)
+            return result;
+
+        // positions relative to the mesh extent
+        glm::vec3 minimum{ positions[0] };
+        glm::vec3 maximum{ positions[0] };
+        for (const auto& p : positions)
+        {
+            minimum = glm::min(minimum, p);
+            maximum = glm::max(maximum, p);
+        }
+        float extent{ std::max({ maximum.x - minimum.x, maximum.y - minimum.y, maximum.z - minimum.z }) };
+        double scale{ extent > 0.0f ? 1.0 / extent : 1.0 };
+
+        std::vector<glm::dvec3> points(vertexCount);
+        for (std::size_t v{ 0 }; v < vertexCount; ++v)
+            points[v] = glm::dvec3{ positions[v] - minimum } * scale;
+
+        // vertices at the same position share a group
+        std::vector<unsigned int> group{};
+        std::vector<unsigned int> groupSize{};
+        {
+            std::span<const float> floats{ reinterpret_cast<const float*>(positions.data()), vertexCount * 3 };
+            vertex_welder::Welded welded{ vertex_welder::weld(floats, 3) };
+            group = std::move(welded.remap);
+            groupSize.assign(welded.vertexCount, 0);
+            for (unsigned int g : group)
+                ++groupSize[g];
+        }
+
+        // movable vertices: alone at their position, every edge around them shared by two triangles
+        std::vector<bool> movable(vertexCount, false);
+        {
+            auto edgeKey{ [](unsigned int a, unsigned int b) { return (std::uint64_t{ a } << 32) | b; } };
+            std::unordered_set<std::uint64_t> edges{};
+            edges.reserve(result.size());
+            for (std::size_t i{ 0 }; i + 2 < result.size(); i += 3)
+                for (std::size_t k{ 0 }; k < 3; ++k)
+                    edges.insert(edgeKey(group[result[i + k]], group[result[i + (k + 1) % 3]]));
+
+            for (std::size_t v{ 0 }; v < vertexCount; ++v)
+                movable[v] = groupSize[group[v]] == 1;
+
+            // an edge without its opposite is on a border, both ends stay
+            for (std::size_t i{ 0 }; i + 2 < result.size(); i += 3)
+                for (std::size_t k{ 0 }; k < 3; ++k)
+                {
+                    unsigned int a{ result[i + k] };
+                    unsigned int b{ result[i + (k + 1) % 3] };
+                    if (!edges.contains(edgeKey(group[b], group[a])))
+                        movable[a] = movable[b] = false;
+                }
+        }
+
+        // quadric of each vertex: the planes of its triangles, weighted by their area
+        std::vector<detail::Quadric> quadrics(vertexCount);
+        for (std::size_t i{ 0 }; i + 2 < result.size(); i += 3)
+        {
+            glm::dvec3 normal{ detail::triangleNormal(points[result[i]], points[result[i + 1]], points[result[i + 2]]) };
+            double area{ glm::length(normal) };
+            if (area <= 0.0)
+                continue;
+            normal /= area;
+
+            detail::Quadric plane{ detail::Quadric::plane(normal, -glm::dot(normal, points[result[i]]), area * 0.5) };
+            for (std::size_t k{ 0 }; k < 3; ++k)
+                quadrics[result[i + k]] += plane;
+        }
+
+        auto attributeError{ [&](unsigned int a, unsigned int b) {
+            double sum{ 0.0 };
+            for (std::size_t k{ 0 }; k < attributeCount; ++k)
+            {
+                double difference{ (attributes.values[a * attributeCount + k] - attributes.values[b * attributeCount + k]) * attributes.weights[k] };
+                sum += difference * difference;
+            }
+            return sum;
+        } };
+
+        struct Collapse
+        {
+            unsigned int from{};
+            unsigned int to{};
+            double       cost{};
+        };
+
+        double targetCost{ static_cast<double>(targetError) * targetError };
+        double maxCost{ 0.0 };
+        std::vector<Collapse> collapses{};
+        std::vector<bool> touched(vertexCount, false);
+        std::vector<unsigned int> target(vertexCount);
+
+        // passes of independent collapses (no two share a triangle) until the target is reached
+        while (result.size() > targetIndexCount)
+        {
+            auto adjacency{ mesh_optimizer::detail::buildAdjacency(result, vertexCount) };
+
+            collapses.clear();
+            for (std::size_t i{ 0 }; i + 2 < result.size(); i += 3)
+                for (std::size_t k{ 0 }; k < 3; ++k)
+                    for (std::size_t j{ 1 }; j < 3; ++j)
+                    {
+                        unsigned int from{ result[i + k] };
+                        unsigned int to{ result[i + (k + j) % 3] };
+                        if (movable[from] && group[from] != group[to])
+                            collapses.push_back({ from, to, quadrics[from].error(points[to]) + attributeError(from, to) });
+                    }
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+            std::fill(touched.begin(), touched.end(), false);
+            std::iota(target.begin(), target.end(), 0u);
+
+            // each collapse removes about two triangles
+            std::size_t trianglesLeft{ (result.size() - targetIndexCount) / 3 };
+            std::size_t removed{ 0 };
+            std::size_t applied{ 0 };
+
+            for (const auto& collapse : collapses)
+            {
+                if (collapse.cost > targetCost || removed >= trianglesLeft)
+                    break;
+                if (touched[collapse.from] || touched[collapse.to])
+                    continue;
+
+                // the triangles around `from` that stay must not flip
+                bool flips{ false };
+                std::size_t degenerate{ 0 };
+                for (unsigned int a{ adjacency.offsets[collapse.from] }; a < adjacency.offsets[collapse.from + 1] && !flips; ++a)
+                {
+                    const unsigned int* triangle{ &result[std::size_t{ adjacency.triangles[a] } * 3] };
+                    if (group[triangle[0]] == group[collapse.to] || group[triangle[1]] == group[collapse.to] || group[triangle[2]] == group[collapse.to])
+                    {
+                        ++degenerate;
+                        continue;
+                    }
+
+                    glm::dvec3 corners[3]{};
+                    for (std::size_t k{ 0 }; k < 3; ++k)
+                        corners[k] = points[triangle[k] == collapse.from ? collapse.to : triangle[k]];
+                    glm::dvec3 before{ detail::triangleNormal(points[triangle[0]], points[triangle[1]], points[triangle[2]]) };
+                    glm::dvec3 after{ detail::triangleNormal(corners[0], corners[1], corners[2]) };
+
+                    flips = glm::dot(before, after) <= 0.0;
+                }
+                if (flips)
+                    continue;
+
+                // neither end nor any vertex around `from` takes part in another collapse of this pass
+                for (unsigned int a{ adjacency.offsets[collapse.from] }; a < adjacency.offsets[collapse.from + 1]; ++a)
+                    for (std::size_t k{ 0 }; k < 3; ++k)
+                        touched[result[std::size_t{ adjacency.triangles[a] } * 3 + k]] = true;
+                touched[collapse.to] = true;
+
+                target[collapse.from] = collapse.to;
+                quadrics[collapse.to] += quadrics[collapse.from];
+                maxCost = std::max(maxCost, collapse.cost);
+                removed += degenerate;
+                ++applied;
+            }
+
+            if (applied == 0)
+                break;
+
+            // rewrite the triangles, the ones that lost their area are dropped
+            std::size_t write{ 0 };
+            for (std::size_t i{ 0 }; i + 2 < result.size(); i += 3)
+            {
+                unsigned int a{ target[result[i]] };
+                unsigned int b{ target[result[i + 1]] };
+                unsigned int c{ target[result[i + 2]] };
+                if (group[a] == group[b] || group[b] == group[c] || group[a] == group[c])
+                    continue;
+
+                result[write++] = a;
+                result[write++] = b;
+                result[write++] = c;
+            }
+            result.resize(write);
+        }
+
+        if (resultError)
+            *resultError = static_cast<float>(std::sqrt(maxCost));
+        return result;
+    }
+
+
+    /*
+        levels 1..n of a mesh, each with about half the triangles of the previous one, simplified
+        from the previous level (the errors add up), their triangles in vertex cache order
+    */
+    inline std::vector<Level> buildLods(
+        std::span<const unsigned int> indices,
+        std::span<const glm::vec3> positions,
+        const SimplifyAttributes& attributes = {},
+        int maxLevels = s_maxLevels
+    )
+    {
+        std::vector<Level> levels{};
+        if (positions.empty() || indices.size() % 3 != 0)
+            return levels;
+
+        glm::vec3 minimum{ positions[0] };
+        glm::vec3 maximum{ positions[0] };
+        for (const auto& p : positions)
+        {
+            minimum = glm::min(minimum, p);
+            maximum = glm::max(maximum, p);
+        }
+        float extent{ std::max({ maximum.x - minimum.x, maximum.y - minimum.y, maximum.z - minimum.z }) };
+
+        std::vector<unsigned int> previous(indices.begin(), indices.end());
+        float error{ 0.0f };
+
+        for (int level{ 1 }; level <= maxLevels; ++level)
+        {
+            std::size_t triangles{ previous.size() / 3 };
+            std::size_t target{ static_cast<std::size_t>(static_cast<float>(triangles) * s_levelRatio) };
+            if (target < s_minTriangles)
+                break;
+
+            float levelError{};
+            std::vector<unsigned int> simplified{ simplify(previous, positions, attributes, target * 3, s_maxError, &levelError) };
+            if (simplified.empty() || static_cast<float>(simplified.size()) > static_cast<float>(previous.size()) * s_minReduction)
+                break;
+
+            error += levelError;
+            previous = simplified;
+            levels.push_back({ mesh_optimizer::optimizeVertexCache(simplified, positions.size()), error * extent });
+        }
+
+        return levels;
+    }
+
+    // the levels one after the other, as a LodChain of the mesh expects them
+    inline void flatten(const std::vector<Level>& levels, std::vector<unsigned int>& indices, std::vector<MeshLod>& lods)
+    {
+        indices.clear();
+        lods.clear();
+        for (const auto& level : levels)
+        {
+            lods.push_back({ static_cast<std::uint32_t>(indices.size()), static_cast<std::uint32_t>(level.indices.size()), level.error });
+            indices.insert(indices.end(), level.indices.begin(), level.indices.end());
+        }
+    }
+}
+
+
+#endif
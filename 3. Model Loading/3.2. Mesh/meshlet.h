@@ -0,0 +1,243 @@
+#ifndef MESHLET_H
+#define MESHLET_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <array>
+#include <span>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
+
+// a cluster of triangles of a mesh: a range of its index buffer, with bounds for culling
+struct Meshlet
+{
+    std::uint32_t firstIndex{};     // into the indices of the full mesh
+    std::uint32_t indexCount{};
+    std::uint32_t vertexCount{};    // distinct vertices
+    float         coneCutoff{};     // sin of the widest angle between coneAxis and a triangle normal, 1: never culled as back-facing
+
+    glm::vec3     center{};         // bounding sphere
+    float         radius{};
+    glm::vec3     coneAxis{};       // average triangle normal
+    float         padding{};
+};
+
+struct MeshletCullStats
+{
+    std::size_t meshlets{};
+    std::size_t triangles{};
+    std::size_t backfacing{};       // meshlets rejected by their normal cone
+    std::size_t outside{};          // meshlets rejected by the frustum
+    std::size_t culledTriangles{};
+
+    MeshletCullStats& operator+=(const MeshletCullStats& other)
+    {
+        meshlets += other.meshlets;
+        triangles += other.triangles;
+        backfacing += other.backfacing;
+        outside += other.outside;
+        culledTriangles += other.culledTriangles;
+        return *this;
+    }
+};
+
+
+// the 6 planes of a view frustum, normalized, pointing inwards
+struct Frustum
+{
+    std::array<glm::vec4, 6> planes{};
+
+    // planes of the clip space of `matrix` (Gribb, Hartmann): with projection * view * model
+    // they are in object space
+    static Frustum fromMatrix(const glm::mat4& matrix)
+    {
+        auto row{ [&matrix](int i) { return glm::vec4{ matrix[0][i], matrix[1][i], matrix[2][i], matrix[3][i] }; } };
+
+        Frustum frustum{};
+        frustum.planes = {
+            row(3) + row(0), row(3) - row(0),       // left, right
+            row(3) + row(1), row(3) - row(1),       // bottom, top
+            row(3) + row(2), row(3) - row(2),       // near, far
+        };
+        for (auto& plane : frustum.planes)
+        {
+            float length{ glm::length(glm::vec3{ plane }) };
+            if (length > 0.0f)
+                plane /= length;
+        }
+        return frustum;
+    }
+
+    bool intersects(const glm::vec3& center, float radius) const
+    {
+        for (const auto& plane : planes)
+            if (glm::dot(glm::vec3{ plane }, center) + plane.w < -radius)
+                return false;
+        return true;
+    }
+};
+
+
+/*
+    meshlets: a mesh split into clusters of at most s_maxVertices vertices and s_maxTriangles
+    triangles, each with a bounding sphere and a normal cone, so clusters can be culled on the
+    CPU every frame instead of the mesh as a whole
+
+    build() cuts the index list into consecutive ranges, no triangle is moved: on an index list
+    in vertex cache order (mesh_optimizer.h) the ranges are compact patches already, and the
+    cache and overdraw order stay as they were. the visible meshlets of a frame are drawn with
+    glMultiDrawElements, neighbouring ranges merged into one.
+
+    a meshlet is back-facing as a whole when the camera sees every triangle from behind:
+
+        dot(center - camera, coneAxis) >= coneCutoff * |center - camera| + radius
+
+    (the cone test of meshoptimizer in its bounding sphere form, the camera position in object
+    space; exact for uniform scale).
+*/
+namespace meshlet
+{
+    constexpr std::size_t s_maxVertices{ 64 };
+    constexpr std::size_t s_maxTriangles{ 124 };
+
+    namespace detail
+    {
+        inline void computeBounds(Meshlet& meshlet, std::span<const unsigned int> indices, std::span<const glm::vec3> positions)
+        {
+            auto triangles{ indices.subspan(meshlet.firstIndex, meshlet.indexCount) };
+
+            // sphere around the center of the bounding box
+            glm::vec3 minimum{ positions[triangles[0]] };
+            glm::vec3 maximum{ minimum };
+            for (unsigned int index : triangles)
+            {
+                minimum = glm::min(minimum, positions[index]);
+                maximum = glm::max(maximum, positions[index]);
+            }
+            meshlet.center = (minimum + maximum) * 0.5f;
+            meshlet.radius = 0.0f;
+            for (unsigned int index : triangles)
+                meshlet.radius = std::max(meshlet.radius, glm::length(positions[index] - meshlet.center));
+
+            // normal cone: the average normal, opened to the triangle furthest from it
+            std::vector<glm::vec3> normals{};
+            normals.reserve(triangles.size() / 3);
+            glm::vec3 sum{ 0.0f };
+            for (std::size_t i{ 0 }; i + 2 < triangles.size(); i += 3)
+            {
+                const glm::vec3& p0{ positions[triangles[i]] };
+                glm::vec3 normal{ glm::cross(positions[triangles[i + 1]] - p0, positions[triangles[i + 2]] - p0) };
+                float length{ glm::length(normal) };
+                if (length <= 0.0f)
+                    continue;
+                normals.push_back(normal / length);
+                sum += normals.back();
+            }
+
+            meshlet.coneCutoff = 1.0f;
+            float length{ glm::length(sum) };
+            if (normals.empty() || length <= 0.0f)
+                return;
+
+            meshlet.coneAxis = sum / length;
+            float minDot{ 1.0f };
+            for (const auto& normal : normals)
+                minDot = std::min(minDot, glm::dot(normal, meshlet.coneAxis));
+
+            // a cone wider than a hemisphere always has a triangle facing the camera
+            if (minDot > 0.0f)
+                meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+        }
+    }
+
+    // meshlets of a triangle list, in index order
+    inline std::vector<Meshlet> build(std::span<const unsigned int> indices, std::span<const glm::vec3> positions)
+    {
+        std::vector<Meshlet> meshlets{};
+        if (indices.size() < 3 || indices.size() % 3 != 0)
+            return meshlets;
+
+        // vertex -> meshlet it was last counted in (+1, 0: none)
+        std::vector<std::uint32_t> seenIn(positions.size(), 0);
+
+        Meshlet current{};
+        for (std::size_t i{ 0 }; i < indices.size(); i += 3)
+        {
+            auto id{ static_cast<std::uint32_t>(meshlets.size() + 1) };
+            std::size_t added{ 0 };
+            for (std::size_t k{ 0 }; k < 3; ++k)
+                added += seenIn[indices[i + k]] != id ? 1 : 0;
+
+            // the triangle starts the next meshlet if it doesn't fit this one
+            if (current.vertexCount + added > s_maxVertices || current.indexCount / 3 + 1 > s_maxTriangles)
+            {
+                detail::computeBounds(current, indices, positions);
+                meshlets.push_back(current);
+                current = Meshlet{};
+                current.firstIndex = static_cast<std::uint32_t>(i);
+                id = static_cast<std::uint32_t>(meshlets.size() + 1);
+            }
+
+            for (std::size_t k{ 0 }; k < 3; ++k)
+            {
+                if (seenIn[indices[i + k]] != id)
+                {
+                    seenIn[indices[i + k]] = id;
+                    ++current.vertexCount;
+                }
+            }
+            current.indexCount += 3;
+        }
+
+        detail::computeBounds(current, indices, positions);
+        meshlets.push_back(current);
+        return meshlets;
+    }
+
+    inline bool isBackfacing(const Meshlet& meshlet, const glm::vec3& camera)
+    {
+        glm::vec3 toCenter{ meshlet.center - camera };
+        return glm::dot(toCenter, meshlet.coneAxis) >= meshlet.coneCutoff * glm::length(toCenter) + meshlet.radius;
+    }
+
+    /*
+        visible meshlets as index ranges (first index, index count), neighbours merged. `frustum`
+        and `camera` in object space
+    */
+    inline void cull(std::span<const Meshlet> meshlets, const Frustum& frustum, const glm::vec3& camera,
+                     std::vector<std::array<std::uint32_t, 2>>& ranges, MeshletCullStats& stats)
+    {
+        ranges.clear();
+        for (const auto& meshlet : meshlets)
+        {
+            ++stats.meshlets;
+            stats.triangles += meshlet.indexCount / 3;
+
+            bool culled{ true };
+            if (!frustum.intersects(meshlet.center, meshlet.radius))
+                ++stats.outside;
+            else if (isBackfacing(meshlet, camera))
+                ++stats.backfacing;
+            else
+                culled = false;
+
+            if (culled)
+            {
+                stats.culledTriangles += meshlet.indexCount / 3;
+                continue;
+            }
+
+            if (!ranges.empty() && ranges.back()[0] + ranges.back()[1] == meshlet.firstIndex)
+                ranges.back()[1] += meshlet.indexCount;
+            else
+                ranges.push_back({ meshlet.firstIndex, meshlet.indexCount });
+        }
+    }
+}
+
+
+#endif
@@ -0,0 +1,35 @@
+// decoding of the compact vertex layout (GLSL counterpart of vertex_layout.h)
+// include with: #include "<relative path>/mesh_header/vertex_layout.glsl"
+//
+// attributes: position snorm16 x4 (w: bitangent sign), normal and tangent octahedral snorm16 x2,
+// texCoords unorm16 x2. GL normalizes them to [-1, 1] / [0, 1], the uniforms undo the bounds.
+
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+uniform vec2 texCoordScale;
+uniform vec2 texCoordOffset;
+
+// [-1, 1]^2 -> unit vector, the inverse of vertex_layout::octahedral()
+vec3 octDecode(vec2 p)
+{
+    vec3 v = vec3(p, 1.0 - abs(p.x) - abs(p.y));
+    float t = max(-v.z, 0.0);
+    v.xy += mix(vec2(t), vec2(-t), greaterThanEqual(v.xy, vec2(0.0)));
+    return normalize(v);
+}
+
+vec3 decodePosition(vec4 position)
+{
+    return position.xyz * positionScale + positionOffset;
+}
+
+vec2 decodeTexCoords(vec2 texCoords)
+{
+    return texCoords * texCoordScale + texCoordOffset;
+}
+
+// bitangent of an octahedral normal/tangent pair, the sign is the w of the position attribute
+vec3 decodeBitangent(vec3 normal, vec3 tangent, float sign)
+{
+    return cross(normal, tangent) * (sign < 0.0 ? -1.0 : 1.0);
+}
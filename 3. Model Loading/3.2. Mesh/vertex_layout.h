@@ -0,0 +1,286 @@
+#ifndef VERTEX_LAYOUT_H
+#define VERTEX_LAYOUT_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <span>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>          // std::memcpy
+
+
+#define MAX_BONE_INFLUENCE 4
+
+
+struct Vertex
+{
+    glm::vec3 m_position{};
+    glm::vec3 m_normal{};
+    glm::vec2 m_texCoords{};
+    glm::vec3 m_tangent{};
+    glm::vec3 m_bitangent{};
+        // bone indexes which will influence this vertex
+        int m_boneIDs[MAX_BONE_INFLUENCE]{};
+        // weights from each bone
+        float m_weights[MAX_BONE_INFLUENCE]{};
+};
+
+
+// how the vertices of a mesh are stored in its vertex buffer
+enum class VertexFormat
+{
+    FULL,           // Vertex as it is, 88 bytes
+    COMPACT,        // quantized, 20 bytes (28 with bones), see vertex_layout::encodeCompact()
+};
+
+
+// one glVertexAttrib(I)Pointer call
+struct VertexAttribute
+{
+    GLuint      location{};
+    GLint       size{};
+    GLenum      type{};
+    bool        normalized{};
+    bool        integer{};          // glVertexAttribIPointer, read as int/ivec in the shader
+    std::size_t offset{};
+};
+
+
+// attribute setup of a vertex buffer, applied to the bound VAO and GL_ARRAY_BUFFER
+struct VertexLayout
+{
+    std::vector<VertexAttribute> attributes{};
+    std::size_t                  stride{};
+
+    void apply() const
+    {
+        for (const auto& attribute : attributes)
+        {
+            glEnableVertexAttribArray(attribute.location);
+            if (attribute.integer)
+                glVertexAttribIPointer(attribute.location, attribute.size, attribute.type, static_cast<GLsizei>(stride), (void*)(attribute.offset));
+            else
+                glVertexAttribPointer(attribute.location, attribute.size, attribute.type, attribute.normalized ? GL_TRUE : GL_FALSE,
+                                      static_cast<GLsizei>(stride), (void*)(attribute.offset));
+        }
+    }
+};
+
+
+// dequantization of a compact mesh, set as uniforms by Mesh::draw (see vertex_layout.glsl)
+struct VertexDecode
+{
+    glm::vec3 positionScale{ 1.0f };        // position = snorm16 position * scale + offset
+    glm::vec3 positionOffset{ 0.0f };
+    glm::vec2 texCoordScale{ 1.0f };        // texCoords = unorm16 texCoords * scale + offset
+    glm::vec2 texCoordOffset{ 0.0f };
+};
+
+
+/*
+    compact vertex layout:
+
+        location 0  position    4 x snorm16   relative to the mesh bounds, w: bitangent sign
+        location 1  normal      2 x snorm16   octahedral
+        location 2  texCoords   2 x unorm16   relative to the mesh UV bounds
+        location 3  tangent     2 x snorm16   octahedral, bitangent = cross(normal, tangent) * sign
+        location 5  bone IDs    4 x uint8     integer, only if the mesh has bone weights
+        location 6  weights     4 x unorm8    only if the mesh has bone weights
+
+    20 bytes per vertex without bones, 28 with, against 88 for Vertex. the vertex shader decodes
+    with the functions of vertex_layout.glsl (COMPACT_VERTICES variant).
+*/
+namespace vertex_layout
+{
+    struct CompactVertex
+    {
+        std::int16_t  position[4]{};
+        std::int16_t  normal[2]{};
+        std::uint16_t texCoords[2]{};
+        std::int16_t  tangent[2]{};
+    };
+    static_assert(sizeof(CompactVertex) == 20);
+
+    struct CompactBones
+    {
+        std::uint8_t ids[MAX_BONE_INFLUENCE]{};
+        std::uint8_t weights[MAX_BONE_INFLUENCE]{};
+    };
+    static_assert(sizeof(CompactBones) == 8);
+
+    struct Encoded
+    {
+        std::vector<std::uint8_t> bytes{};
+        VertexLayout              layout{};
+        VertexDecode              decode{};
+    };
+
+    // the attributes of Vertex
+    inline VertexLayout full()
+    {
+        return { {
+            { 0, 3, GL_FLOAT, false, false, offsetof(Vertex, m_position) },
+            { 1, 3, GL_FLOAT, false, false, offsetof(Vertex, m_normal) },
+            { 2, 2, GL_FLOAT, false, false, offsetof(Vertex, m_texCoords) },
+            { 3, 3, GL_FLOAT, false, false, offsetof(Vertex, m_tangent) },
+            { 4, 3, GL_FLOAT, false, false, offsetof(Vertex, m_bitangent) },
+            { 5, MAX_BONE_INFLUENCE, GL_INT, false, true, offsetof(Vertex, m_boneIDs) },
+            { 6, MAX_BONE_INFLUENCE, GL_FLOAT, false, false, offsetof(Vertex, m_weights) },
+        }, sizeof(Vertex) };
+    }
+
+    inline VertexLayout compact(bool bones)
+    {
+        VertexLayout layout{ {
+            { 0, 4, GL_SHORT, true, false, offsetof(CompactVertex, position) },
+            { 1, 2, GL_SHORT, true, false, offsetof(CompactVertex, normal) },
+            { 2, 2, GL_UNSIGNED_SHORT, true, false, offsetof(CompactVertex, texCoords) },
+            { 3, 2, GL_SHORT, true, false, offsetof(CompactVertex, tangent) },
+        }, sizeof(CompactVertex) };
+
+        if (bones)
+        {
+            layout.attributes.push_back({ 5, MAX_BONE_INFLUENCE, GL_UNSIGNED_BYTE, false, true, sizeof(CompactVertex) + offsetof(CompactBones, ids) });
+            layout.attributes.push_back({ 6, MAX_BONE_INFLUENCE, GL_UNSIGNED_BYTE, true, false, sizeof(CompactVertex) + offsetof(CompactBones, weights) });
+            layout.stride += sizeof(CompactBones);
+        }
+        return layout;
+    }
+
+    inline std::int16_t snorm16(float value)
+    {
+        return static_cast<std::int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+    }
+
+    inline std::uint16_t unorm16(float value)
+    {
+        return static_cast<std::uint16_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+    }
+
+    // unit vector -> [-1, 1]^2 (the octahedron folded onto a square), a zero vector gives +z
+    inline glm::vec2 octahedral(const glm::vec3& v)
+    {
+        float sum{ std::abs(v.x) + std::abs(v.y) + std::abs(v.z) };
+        if (sum == 0.0f)
+            return {};
+
+        glm::vec2 p{ v.x / sum, v.y / sum };
+        if (v.z < 0.0f)
+        {
+            glm::vec2 sign{ p.x >= 0.0f ? 1.0f : -1.0f, p.y >= 0.0f ? 1.0f : -1.0f };
+            p = (1.0f - glm::abs(glm::vec2{ p.y, p.x })) * sign;
+        }
+        return p;
+    }
+
+    // inverse of octahedral(), same as octDecode() in vertex_layout.glsl
+    inline glm::vec3 fromOctahedral(const glm::vec2& p)
+    {
+        glm::vec3 v{ p.x, p.y, 1.0f - std::abs(p.x) - std::abs(p.y) };
+        float t{ std::max(-v.z, 0.0f) };
+        v.x += v.x >= 0.0f ? -t : t;
+        v.y += v.y >= 0.0f ? -t : t;
+        return glm::normalize(v);
+    }
+
+    inline bool hasBones(std::span<const Vertex> vertices)
+    {
+        return std::any_of(vertices.begin(), vertices.end(), [](const Vertex& vertex) {
+            return std::any_of(std::begin(vertex.m_weights), std::end(vertex.m_weights), [](float weight) { return weight != 0.0f; });
+        });
+    }
+
+    // bone IDs in use (weight != 0) have to fit in a byte, false if the mesh needs the full layout
+    inline bool canEncodeCompact(std::span<const Vertex> vertices)
+    {
+        return std::all_of(vertices.begin(), vertices.end(), [](const Vertex& vertex) {
+            for (int i{ 0 }; i < MAX_BONE_INFLUENCE; ++i)
+                if (vertex.m_weights[i] != 0.0f && (vertex.m_boneIDs[i] < 0 || vertex.m_boneIDs[i] > 255))
+                    return false;
+            return true;
+        });
+    }
+
+    inline Encoded encodeCompact(std::span<const Vertex> vertices)
+    {
+        Encoded encoded{};
+        bool bones{ hasBones(vertices) };
+        encoded.layout = compact(bones);
+
+        // bounds of the positions and texture coordinates
+        glm::vec3 minPosition{ 0.0f };
+        glm::vec3 maxPosition{ 0.0f };
+        glm::vec2 minTexCoords{ 0.0f };
+        glm::vec2 maxTexCoords{ 0.0f };
+        if (!vertices.empty())
+        {
+            minPosition = maxPosition = vertices[0].m_position;
+            minTexCoords = maxTexCoords = vertices[0].m_texCoords;
+        }
+        for (const auto& vertex : vertices)
+        {
+            minPosition = glm::min(minPosition, vertex.m_position);
+            maxPosition = glm::max(maxPosition, vertex.m_position);
+            minTexCoords = glm::min(minTexCoords, vertex.m_texCoords);
+            maxTexCoords = glm::max(maxTexCoords, vertex.m_texCoords);
+        }
+
+        // a flat axis keeps a scale of 1, every vertex is at its offset anyway
+        auto& decode{ encoded.decode };
+        decode.positionOffset = (minPosition + maxPosition) * 0.5f;
+        decode.positionScale = (maxPosition - minPosition) * 0.5f;
+        decode.positionScale = glm::mix(decode.positionScale, glm::vec3{ 1.0f }, glm::equal(decode.positionScale, glm::vec3{ 0.0f }));
+        decode.texCoordOffset = minTexCoords;
+        decode.texCoordScale = maxTexCoords - minTexCoords;
+        decode.texCoordScale = glm::mix(decode.texCoordScale, glm::vec2{ 1.0f }, glm::equal(decode.texCoordScale, glm::vec2{ 0.0f }));
+
+        encoded.bytes.resize(vertices.size() * encoded.layout.stride);
+        std::uint8_t* out{ encoded.bytes.data() };
+
+        for (const auto& vertex : vertices)
+        {
+            CompactVertex compact{};
+
+            glm::vec3 position{ (vertex.m_position - decode.positionOffset) / decode.positionScale };
+            glm::vec2 normal{ octahedral(vertex.m_normal) };
+            glm::vec2 texCoords{ (vertex.m_texCoords - decode.texCoordOffset) / decode.texCoordScale };
+            glm::vec2 tangent{ octahedral(vertex.m_tangent) };
+            float handedness{ glm::dot(glm::cross(vertex.m_normal, vertex.m_tangent), vertex.m_bitangent) < 0.0f ? -1.0f : 1.0f };
+
+            compact.position[0] = snorm16(position.x);
+            compact.position[1] = snorm16(position.y);
+            compact.position[2] = snorm16(position.z);
+            compact.position[3] = snorm16(handedness);
+            compact.normal[0] = snorm16(normal.x);
+            compact.normal[1] = snorm16(normal.y);
+            compact.texCoords[0] = unorm16(texCoords.x);
+            compact.texCoords[1] = unorm16(texCoords.y);
+            compact.tangent[0] = snorm16(tangent.x);
+            compact.tangent[1] = snorm16(tangent.y);
+            std::memcpy(out, &compact, sizeof(compact));
+
+            if (bones)
+            {
+                CompactBones packed{};
+                for (int i{ 0 }; i < MAX_BONE_INFLUENCE; ++i)
+                {
+                    // unused influences (often ID -1) become bone 0 with weight 0
+                    packed.ids[i] = vertex.m_weights[i] != 0.0f ? static_cast<std::uint8_t>(vertex.m_boneIDs[i]) : 0;
+                    packed.weights[i] = static_cast<std::uint8_t>(std::lround(std::clamp(vertex.m_weights[i], 0.0f, 1.0f) * 255.0f));
+                }
+                std::memcpy(out + sizeof(compact), &packed, sizeof(packed));
+            }
+
+            out += encoded.layout.stride;
+        }
+
+        return encoded;
+    }
+}
+
+
+#endif
@@ -0,0 +1,154 @@
+#ifndef VERTEX_WELDER_H
+#define VERTEX_WELDER_H
+
+#include <vector>
+#include <span>
+#include <algorithm>
+#include <bit>              // std::bit_ceil
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>          // std::memcpy, std::memcmp
+#include <type_traits>
+
+
+/*
+    joins identical vertices, the vertex buffer shrinks and an index buffer addresses it
+
+        auto welded{ vertex_welder::weldExact<Vertex>(vertices) };
+        vertex_welder::remapIndices(indices, welded);           // or indices = welded.remap if there were none
+        vertices = vertex_welder::compact<Vertex>(vertices, welded);
+
+    weldExact() compares the bytes of the vertices, for any trivially copyable vertex type
+    without padding (Vertex is). the bytes are hashed 8 at a time, the hash table is open
+    addressed, so a mesh of n vertices is welded in O(n).
+
+    weld() works on vertices made of floats (the interleaved arrays of Cube and Sphere): with an
+    epsilon, components are snapped to a grid of that size before they are compared, vertices
+    whose components round to the same grid points are joined. two values just either side of a
+    grid line stay apart, the weld never joins vertices more than epsilon apart in any
+    component. without an epsilon the values are compared exactly (+0 and -0 are the same).
+
+    the first vertex of each group is kept, the vertices keep their relative order.
+*/
+namespace vertex_welder
+{
+    struct Welded
+    {
+        std::vector<unsigned int> remap{};      // old vertex -> new vertex
+        unsigned int              vertexCount{};
+    };
+
+
+    namespace detail
+    {
+        inline std::uint64_t mix(std::uint64_t hash, std::uint64_t word)
+        {
+            hash ^= word;
+            hash *= 0x100000001b3ull;
+            return hash ^ (hash >> 32);
+        }
+
+        inline std::uint64_t hashBytes(const std::uint8_t* bytes, std::size_t size)
+        {
+            std::uint64_t hash{ 0xcbf29ce484222325ull };
+            std::size_t i{ 0 };
+            for (; i + 8 <= size; i += 8)
+            {
+                std::uint64_t word{};
+                std::memcpy(&word, bytes + i, sizeof(word));
+                hash = mix(hash, word);
+            }
+            if (i < size)
+            {
+                std::uint64_t tail{};
+                std::memcpy(&tail, bytes + i, size - i);
+                hash = mix(hash, tail);
+            }
+            return hash;
+        }
+
+        // vertex keys of `keySize` bytes each, equal keys are one vertex
+        inline Welded weldKeys(const std::uint8_t* keys, std::size_t keySize, std::size_t vertexCount)
+        {
+            Welded welded{};
+            welded.remap.resize(vertexCount);
+
+            constexpr unsigned int empty{ ~0u };
+            std::size_t tableSize{ std::bit_ceil(vertexCount + vertexCount / 4 + 1) };     // load factor < 0.8
+            std::vector<unsigned int> table(tableSize, empty);      // first vertex of each key
+            std::size_t mask{ tableSize - 1 };
+
+            for (std::size_t v{ 0 }; v < vertexCount; ++v)
+            {
+                const std::uint8_t* key{ keys + v * keySize };
+                std::size_t slot{ static_cast<std::size_t>(hashBytes(key, keySize)) & mask };
+
+                // linear probing until the key or an empty slot is found
+                while (table[slot] != empty && std::memcmp(keys + std::size_t{ table[slot] } * keySize, key, keySize) != 0)
+                    slot = (slot + 1) & mask;
+
+                if (table[slot] == empty)
+                {
+                    table[slot] = static_cast<unsigned int>(v);
+                    welded.remap[v] = welded.vertexCount++;
+                }
+                else
+                    welded.remap[v] = welded.remap[table[slot]];
+            }
+
+            return welded;
+        }
+    }
+
+
+    template<typename V>
+    Welded weldExact(std::span<const V> vertices)
+    {
+        static_assert(std::is_trivially_copyable_v<V>, "vertices are compared as raw bytes");
+        return detail::weldKeys(reinterpret_cast<const std::uint8_t*>(vertices.data()), sizeof(V), vertices.size());
+    }
+
+    // `components` floats per vertex
+    inline Welded weld(std::span<const float> values, std::size_t components, float epsilon = 0.0f)
+    {
+        // every component as an integer: its grid point, or its value with -0 turned into +0
+        std::vector<std::int64_t> keys(values.size());
+        for (std::size_t i{ 0 }; i < values.size(); ++i)
+        {
+            if (epsilon > 0.0f)
+                keys[i] = std::llround(static_cast<double>(values[i]) / epsilon);
+            else
+            {
+                float value{ values[i] == 0.0f ? 0.0f : values[i] };
+                std::uint32_t bits{};
+                std::memcpy(&bits, &value, sizeof(value));
+                keys[i] = bits;
+            }
+        }
+
+        return detail::weldKeys(reinterpret_cast<const std::uint8_t*>(keys.data()), components * sizeof(std::int64_t), values.size() / components);
+    }
+
+
+    // the kept vertices, `components` values each
+    template<typename T>
+    std::vector<T> compact(std::span<const T> values, const Welded& welded, std::size_t components = 1)
+    {
+        std::vector<T> result(std::size_t{ welded.vertexCount } * components);
+        for (std::size_t v{ welded.remap.size() }; v-- > 0;)         // backwards: the first vertex of a group is written last
+            std::copy_n(values.begin() + v * components, components, result.begin() + std::size_t{ welded.remap[v] } * components);
+        return result;
+    }
+
+    // indices into the welded vertices, for any container of unsigned integers
+    template<typename Indices>
+    void remapIndices(Indices& indices, const Welded& welded)
+    {
+        for (auto& index : indices)
+            index = static_cast<std::remove_reference_t<decltype(index)>>(welded.remap[index]);
+    }
+}
+
+
+#endif
@@ -0,0 +1,303 @@
+#ifndef MATERIAL_PACKER_H
+#define MATERIAL_PACKER_H
+
+#include <glad/glad.h>
+#ifndef STBI_INCLUDE_STB_IMAGE_H
+#include <stb_image/stb_image.h>
+#endif
+
+#include <shader_header/shader.h>
+#include <mesh_header/mesh.h>               // Vertex, Mesh
+#include <model_header/mesh_cache.h>        // TextureRef
+#include <gl_state_header/gl_state.h>
+#include <texture_header/texture_units.h>
+#include <texture_header/mipmap.h>
+#include <thread_header/thread_pool.h>
+
+#include <vector>
+#include <array>
+#include <string>
+#include <span>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <iostream>
+
+
+// same sized maps of one type, one layer each
+struct TextureArray
+{
+    unsigned int             id{};
+    int                      width{};
+    int                      height{};
+    std::vector<std::string> layers{};      // source file of each layer
+};
+
+// where the maps of a mesh were packed
+struct PackedMaterial
+{
+    struct Slot
+    {
+        int array{ -1 };            // index into MaterialPacker::arrays(), -1 if the mesh has no such map
+        int layer{};
+    };
+
+    std::array<Slot, 2> slots{};    // MaterialPacker::DIFFUSE, MaterialPacker::SPECULAR
+};
+
+
+/*
+    packs the diffuse and specular maps of a model into GL_TEXTURE_2D_ARRAY layers
+
+    maps of the same type and size share an array, so every mesh whose maps landed in the same
+    arrays can be merged into one MeshBatch and drawn with one call, the layer is a vertex
+    attribute. the shader samples sampler2DArray instead of sampler2D (TEXTURE_ARRAYS in
+    3.3. Model/test/shader.fs).
+
+        MaterialPacker packer{ directory, gamma, flipVertically };
+        PackedMaterial material{ packer.add(mesh.textures) };      // per mesh, only reads the image headers
+        packer.upload();                                            // decodes on the thread pool, creates the arrays
+
+    images are decoded to RGBA with stb_image, their mip chains are generated on the thread pool
+    as well. packing bypasses the rest of the texture path: cooked .dds files (TextureCooker)
+    aren't used and the arrays are always fully resident, TextureResidency doesn't stream their
+    levels (ModelOptions::streamTextures is ignored).
+*/
+class MaterialPacker
+{
+public:
+    enum Type
+    {
+        DIFFUSE,
+        SPECULAR,
+        TYPE_COUNT
+    };
+
+    static constexpr std::array<const char*, TYPE_COUNT> s_types{ "texture_diffuse", "texture_specular" };
+    static constexpr std::array<const char*, TYPE_COUNT> s_samplers{ "materials[0].texture_diffuse", "materials[0].texture_specular" };
+
+    // GL 3.3 guarantees at least 256 layers (GL_MAX_ARRAY_TEXTURE_LAYERS), a full array starts another one
+    static constexpr std::size_t s_maxLayers{ 256 };
+
+    // flipVertically: the images are flipped on the y-axis as they are decoded (TextureOptions::flipVertically)
+    MaterialPacker(std::string directory, bool gamma, bool flipVertically = false)
+        : m_directory{ std::move(directory) }
+        , m_gamma{ gamma }
+        , m_flipVertically{ flipVertically }
+    {
+    }
+
+    // the first map of each type of a mesh gets a layer, a file already packed keeps its layer
+    PackedMaterial add(const std::vector<TextureRef>& refs)
+    {
+        PackedMaterial material{};
+
+        for (int type{ 0 }; type < TYPE_COUNT; ++type)
+        {
+            auto ref{ std::find_if(refs.begin(), refs.end(), [type](const TextureRef& r) { return r.type == s_types[type]; }) };
+            if (ref != refs.end())
+                material.slots[type] = place(static_cast<Type>(type), m_directory + "/" + ref->path);
+        }
+
+        return material;
+    }
+
+    // decode every layer on the pool, then create the arrays (render thread)
+    void upload(ThreadPool& pool = ThreadPool::shared())
+    {
+        struct Layer
+        {
+            std::size_t               array{};
+            std::size_t               index{};
+            std::vector<std::uint8_t> pixels{};
+            MipChain                  mips{};
+        };
+
+        std::vector<Layer> layers{};
+        for (std::size_t a{ 0 }; a < m_arrays.size(); ++a)
+            for (std::size_t l{ 0 }; l < m_arrays[a].layers.size(); ++l)
+                layers.push_back({ a, l });
+
+        pool.parallelFor(layers.size(), [&](std::size_t i) {
+            auto& layer{ layers[i] };
+            const auto& array{ m_arrays[layer.array] };
+            decodeLayer(array, array.layers[layer.index], m_flipVertically, layer.pixels);
+            layer.mips = mipmap::generate(layer.pixels, array.width, array.height, 4, isSRGB(layer.array));
+        });
+
+        for (std::size_t a{ 0 }; a < m_arrays.size(); ++a)
+        {
+            auto& array{ m_arrays[a] };
+            GLenum internalFormat{ isSRGB(a) ? GLenum{ GL_SRGB8_ALPHA8 } : GLenum{ GL_RGBA8 } };
+            auto layerCount{ static_cast<GLsizei>(array.layers.size()) };
+
+            glGenTextures(1, &array.id);
+            GLState::bindTexture(GL_TEXTURE_2D_ARRAY, array.id);
+
+            // storage of every level first, then each layer with its mip chain
+            const auto& chain{ std::find_if(layers.begin(), layers.end(), [a](const Layer& l) { return l.array == a; })->mips };
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, static_cast<GLint>(internalFormat), array.width, array.height, layerCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            for (std::size_t mip{ 0 }; mip < chain.levels.size(); ++mip)
+                glTexImage3D(GL_TEXTURE_2D_ARRAY, static_cast<GLint>(mip + 1), static_cast<GLint>(internalFormat),
+                             chain.levels[mip].width, chain.levels[mip].height, layerCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+            for (const auto& layer : layers)
+            {
+                if (layer.array != a)
+                    continue;
+
+                auto z{ static_cast<GLint>(layer.index) };
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, z, array.width, array.height, 1, GL_RGBA, GL_UNSIGNED_BYTE, layer.pixels.data());
+                for (std::size_t mip{ 0 }; mip < layer.mips.levels.size(); ++mip)
+                {
+                    const auto& level{ layer.mips.levels[mip] };
+                    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, static_cast<GLint>(mip + 1), 0, 0, z, level.width, level.height, 1,
+                                    GL_RGBA, GL_UNSIGNED_BYTE, layer.mips.data.data() + level.offset);
+                }
+            }
+
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(chain.levels.size()));
+        }
+    }
+
+    const std::vector<TextureArray>& arrays() const { return m_arrays; }
+
+    // GL texture of a slot, 0 (samples black) if the mesh has no such map
+    unsigned int textureOf(const PackedMaterial::Slot& slot) const
+    {
+        return slot.array < 0 ? 0 : m_arrays[static_cast<std::size_t>(slot.array)].id;
+    }
+
+private:
+    std::string               m_directory{};
+    bool                      m_gamma{};
+    bool                      m_flipVertically{};
+    std::vector<TextureArray> m_arrays{};
+    std::vector<Type>         m_arrayTypes{};
+    std::unordered_map<std::string, PackedMaterial::Slot> m_placed{};      // "type|path" -> slot
+
+    // only color maps are stored in sRGB, specular maps hold linear data
+    bool isSRGB(std::size_t array) const { return m_gamma && m_arrayTypes[array] == DIFFUSE; }
+
+    PackedMaterial::Slot place(Type type, const std::string& path)
+    {
+        std::string key{ std::string{ s_types[type] } + '|' + path };
+        if (auto it{ m_placed.find(key) }; it != m_placed.end())
+            return it->second;
+
+        int width{};
+        int height{};
+        int channels{};
+        if (!stbi_info(path.c_str(), &width, &height, &channels))
+        {
+            std::cerr << "ERROR::MATERIAL_PACKER::could not read " << path << std::endl;
+            return m_placed[key] = {};
+        }
+
+        // an array of this type and size with room left, or a new one
+        std::size_t index{ 0 };
+        for (; index < m_arrays.size(); ++index)
+        {
+            const auto& array{ m_arrays[index] };
+            if (m_arrayTypes[index] == type && array.width == width && array.height == height && array.layers.size() < s_maxLayers)
+                break;
+        }
+        if (index == m_arrays.size())
+        {
+            m_arrays.push_back({ 0, width, height });
+            m_arrayTypes.push_back(type);
+        }
+
+        m_arrays[index].layers.push_back(path);
+        return m_placed[key] = { static_cast<int>(index), static_cast<int>(m_arrays[index].layers.size() - 1) };
+    }
+
+    // worker thread: RGBA pixels of a layer, black if the file can't be decoded
+    static void decodeLayer(const TextureArray& array, const std::string& path, bool flipVertically, std::vector<std::uint8_t>& pixels)
+    {
+        pixels.assign(static_cast<std::size_t>(array.width) * array.height * 4, 0);
+
+        // the flip flag of stb_image is global, the thread-local one doesn't race with other loads
+        stbi_set_flip_vertically_on_load_thread(flipVertically);
+
+        int width{};
+        int height{};
+        int channels{};
+        unsigned char* data{ stbi_load(path.c_str(), &width, &height, &channels, 4) };
+        if (data && width == array.width && height == array.height)
+            std::copy_n(data, pixels.size(), pixels.begin());
+        else
+            std::cerr << "ERROR::MATERIAL_PACKER::could not decode " << path << std::endl;
+        stbi_image_free(data);
+    }
+};
+
+
+/*
+    meshes merged into one draw: their vertices and (rebased) indices are concatenated, the
+    texture array layers of every vertex are an extra attribute (location 7, ivec2 aLayers:
+    diffuse, specular). the meshlets of the members, rebased too, are culled as one mesh. the
+    LOD chains of the members are dropped, a batch is always drawn in full (Model::selectLods()).
+*/
+class MeshBatch
+{
+public:
+    using Layers = std::array<std::uint16_t, MaterialPacker::TYPE_COUNT>;
+
+    MeshBatch(
+        std::span<const Vertex> vertices,
+        std::span<const unsigned int> indices,
+        std::span<const Layers> layers,
+        std::array<unsigned int, MaterialPacker::TYPE_COUNT> arrays,
+        VertexFormat format = VertexFormat::FULL,
+        std::span<const Meshlet> meshlets = {}
+    )
+        : m_mesh{ vertices, indices, {}, format, {}, meshlets }
+        , m_arrays{ arrays }
+    {
+        GLState::bindVertexArray(m_mesh.VAO);
+
+        glGenBuffers(1, &m_layerVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, m_layerVBO);
+        glBufferData(GL_ARRAY_BUFFER, layers.size_bytes(), layers.data(), GL_STATIC_DRAW);
+
+        glEnableVertexAttribArray(7);
+        glVertexAttribIPointer(7, MaterialPacker::TYPE_COUNT, GL_UNSIGNED_SHORT, sizeof(Layers), (void*)(0));
+
+        GLState::bindVertexArray(0);
+    }
+
+    void draw(Shader& shader)
+    {
+        // both samplers are always set: a sampler2DArray left on a unit that holds a 2D texture fails the draw
+        TextureUnits::beginDraw();
+        for (int type{ 0 }; type < MaterialPacker::TYPE_COUNT; ++type)
+            TextureUnits::bind(shader, MaterialPacker::s_samplers[type], GL_TEXTURE_2D_ARRAY, m_arrays[type]);
+
+        if (m_mesh.format() == VertexFormat::COMPACT)
+            m_mesh.setDecodeUniforms(shader);
+
+        GLState::bindVertexArray(m_mesh.VAO);
+        m_mesh.drawElements();
+    }
+
+    // see Mesh::cull()
+    void cull(const Frustum& frustum, const glm::vec3& camera, MeshletCullStats& stats) { m_mesh.cull(frustum, camera, stats); }
+
+    std::size_t vertexBytes() const { return m_mesh.vertexBytes(); }
+    std::size_t indexBytes() const { return m_mesh.indexBytes(); }
+    std::size_t triangleCount() const { return m_mesh.triangleCount(); }
+
+private:
+    Mesh                                                 m_mesh;
+    unsigned int                                         m_layerVBO{};
+    std::array<unsigned int, MaterialPacker::TYPE_COUNT> m_arrays{};
+};
+
+
+#endif
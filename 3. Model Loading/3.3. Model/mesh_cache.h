@@ -0,0 +1,435 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <mesh_header/mesh.h>               // Vertex
+#include <mesh_header/mesh_lod.h>           // MeshLod
+#include <mesh_header/meshlet.h>            // Meshlet
+#include <shader_header/shader_source.h>    // MappedFile
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <span>
+#include <filesystem>
+#include <fstream>
+#include <cstdint>
+#include <cstring>          // std::memcpy
+#include <algorithm>
+#include <type_traits>
+
+
+// CPU side of a mesh: produced by the import (worker threads) and stored in the mesh cache
+struct TextureRef
+{
+    std::string type{};         // texture_diffuse, texture_specular, ...
+    std::string path{};         // relative to the model directory
+};
+
+struct MeshData
+{
+    std::vector<Vertex>       vertices{};
+    std::vector<unsigned int> indices{};
+    std::vector<TextureRef>   textures{};
+    std::vector<unsigned int> lodIndices{};     // levels of detail 1..n (see mesh_simplifier.h)
+    std::vector<MeshLod>      lods{};           // ranges of lodIndices
+    std::vector<Meshlet>      meshlets{};       // ranges of indices (see meshlet.h)
+};
+
+
+/*
+    binary cache of the imported meshes of a model, stored next to the source as <source>.mesh
+
+    layout (every blob starts on a 16 byte boundary):
+        FileHeader
+        MeshEntry[meshCount]
+        TextureEntry[textureCount]
+        MeshLod[lodCount]
+        Meshlet[meshletCount]
+        string bytes (texture types and paths)
+        per mesh: Vertex[vertexCount], unsigned int[indexCount + lodIndexCount]
+
+    the header stores a hash of the source file (and of the size and write time of the material
+    libraries an .obj references) together with the import flags, sizeof(Vertex) and the format
+    version, a cache written for another source, other flags or another vertex layout is never
+    used. opening a cache checks every table range and index against the file and the vertex
+    counts, a damaged file is treated as missing. a cache is opened by mapping the file;
+    vertices() and indices() point straight into the mapping, so they can be handed to
+    glBufferData without any copy.
+
+        MeshCache cache{ MeshCache::pathOf(path) };
+        if (cache.isValid(MeshCache::hashSource(path, flags), flags))
+            for (std::size_t i{ 0 }; i < cache.meshCount(); ++i)
+                Mesh mesh{ cache.vertices(i), cache.indices(i), ... };
+*/
+class MeshCache
+{
+    static constexpr std::uint32_t s_version{ 5 };         // 2: index/vertex order optimized (mesh_optimizer.h), 3: vertices welded, 4: levels of detail, 5: meshlets
+    static constexpr std::uint64_t s_alignment{ 16 };
+
+    struct FileHeader
+    {
+        char          magic[4]{ 'L', 'G', 'M', 'C' };
+        std::uint32_t version{ s_version };
+        std::uint64_t sourceHash{};
+        std::uint32_t importFlags{};
+        std::uint32_t vertexSize{ sizeof(Vertex) };
+        std::uint32_t meshCount{};
+        std::uint32_t textureCount{};
+        std::uint64_t stringsOffset{};
+        std::uint64_t fileSize{};
+        std::uint32_t lodCount{};
+        std::uint32_t meshletCount{};
+        std::uint32_t padding[2]{};
+    };
+
+    struct MeshEntry
+    {
+        std::uint64_t vertexOffset{};
+        std::uint64_t indexOffset{};
+        std::uint32_t vertexCount{};
+        std::uint32_t indexCount{};
+        std::uint32_t firstTexture{};
+        std::uint32_t textureCount{};
+        std::uint32_t lodIndexCount{};      // after the indices of the full mesh
+        std::uint32_t firstLod{};
+        std::uint32_t lodCount{};
+        std::uint32_t firstMeshlet{};
+        std::uint32_t meshletCount{};
+        std::uint32_t padding[3]{};
+    };
+
+    struct TextureEntry
+    {
+        // offsets relative to FileHeader::stringsOffset
+        std::uint32_t typeOffset{};
+        std::uint32_t typeLength{};
+        std::uint32_t pathOffset{};
+        std::uint32_t pathLength{};
+    };
+
+    static_assert(std::is_trivially_copyable_v<Vertex>, "Vertex is written to the cache as raw bytes");
+    static_assert(std::is_trivially_copyable_v<MeshLod> && std::is_trivially_copyable_v<Meshlet>);
+    static_assert(sizeof(FileHeader) % s_alignment == 0 && sizeof(MeshEntry) % s_alignment == 0);
+
+    MappedFile m_file;
+    const FileHeader*   m_header{ nullptr };
+    const MeshEntry*    m_meshes{ nullptr };
+    const TextureEntry* m_textures{ nullptr };
+    const MeshLod*      m_lods{ nullptr };
+    const Meshlet*      m_meshlets{ nullptr };
+
+public:
+    explicit MeshCache(const std::filesystem::path& path)
+        : m_file{ path }
+    {
+        std::string_view bytes{ m_file.view() };
+        if (bytes.size() < sizeof(FileHeader))
+            return;
+
+        auto header{ reinterpret_cast<const FileHeader*>(bytes.data()) };
+        if (std::memcmp(header->magic, FileHeader{}.magic, sizeof(header->magic)) != 0
+            || header->version != s_version
+            || header->vertexSize != sizeof(Vertex)
+            || header->fileSize != bytes.size())
+            return;
+
+        // tables must fit in the file, the blobs are checked per mesh below
+        std::uint64_t tablesEnd{ sizeof(FileHeader) + header->meshCount * sizeof(MeshEntry) + header->textureCount * sizeof(TextureEntry)
+                                 + header->lodCount * sizeof(MeshLod) + header->meshletCount * sizeof(Meshlet) };
+        if (tablesEnd > header->stringsOffset || header->stringsOffset > bytes.size())
+            return;
+
+        auto meshes{ reinterpret_cast<const MeshEntry*>(bytes.data() + sizeof(FileHeader)) };
+        auto textures{ reinterpret_cast<const TextureEntry*>(meshes + header->meshCount) };
+        auto lods{ reinterpret_cast<const MeshLod*>(textures + header->textureCount) };
+        auto meshlets{ reinterpret_cast<const Meshlet*>(lods + header->lodCount) };
+
+        for (std::uint32_t i{ 0 }; i < header->meshCount; ++i)
+        {
+            const MeshEntry& mesh{ meshes[i] };
+            if (!fits(mesh.vertexOffset, std::uint64_t{ mesh.vertexCount } * sizeof(Vertex), bytes.size())
+                || !fits(mesh.indexOffset, (std::uint64_t{ mesh.indexCount } + mesh.lodIndexCount) * sizeof(unsigned int), bytes.size())
+                || std::uint64_t{ mesh.firstTexture } + mesh.textureCount > header->textureCount
+                || std::uint64_t{ mesh.firstLod } + mesh.lodCount > header->lodCount
+                || std::uint64_t{ mesh.firstMeshlet } + mesh.meshletCount > header->meshletCount)
+                return;
+
+            for (std::uint32_t l{ 0 }; l < mesh.lodCount; ++l)
+                if (std::uint64_t{ lods[mesh.firstLod + l].first } + lods[mesh.firstLod + l].count > mesh.lodIndexCount)
+                    return;
+
+            for (std::uint32_t m{ 0 }; m < mesh.meshletCount; ++m)
+                if (std::uint64_t{ meshlets[mesh.firstMeshlet + m].firstIndex } + meshlets[mesh.firstMeshlet + m].indexCount > mesh.indexCount)
+                    return;
+
+            // an index past the vertices would make the GPU read outside the vertex buffer
+            if (mesh.indexOffset % alignof(unsigned int) != 0)
+                return;
+            auto indices{ reinterpret_cast<const unsigned int*>(bytes.data() + mesh.indexOffset) };
+            if (std::any_of(indices, indices + mesh.indexCount + mesh.lodIndexCount, [&mesh](unsigned int index) { return index >= mesh.vertexCount; }))
+                return;
+        }
+
+        for (std::uint32_t i{ 0 }; i < header->textureCount; ++i)
+        {
+            const TextureEntry& texture{ textures[i] };
+            if (!fits(header->stringsOffset + texture.typeOffset, texture.typeLength, bytes.size())
+                || !fits(header->stringsOffset + texture.pathOffset, texture.pathLength, bytes.size()))
+                return;
+        }
+
+        m_header = header;
+        m_meshes = meshes;
+        m_textures = textures;
+        m_lods = lods;
+        m_meshlets = meshlets;
+    }
+
+    // the file exists, is well formed and was written for this source and these import flags
+    bool isValid(std::uint64_t sourceHash, unsigned int importFlags) const
+    {
+        return m_header && m_header->sourceHash == sourceHash && m_header->importFlags == importFlags;
+    }
+
+    std::size_t meshCount() const { return m_header ? m_header->meshCount : 0; }
+
+    // views into the mapping, valid as long as the cache is open
+    std::span<const Vertex> vertices(std::size_t mesh) const
+    {
+        return { reinterpret_cast<const Vertex*>(data() + m_meshes[mesh].vertexOffset), m_meshes[mesh].vertexCount };
+    }
+
+    std::span<const unsigned int> indices(std::size_t mesh) const
+    {
+        return { reinterpret_cast<const unsigned int*>(data() + m_meshes[mesh].indexOffset), m_meshes[mesh].indexCount };
+    }
+
+    // levels of detail: their indices follow the ones of the full mesh
+    LodChain lods(std::size_t mesh) const
+    {
+        const MeshEntry& entry{ m_meshes[mesh] };
+        return {
+            { reinterpret_cast<const unsigned int*>(data() + entry.indexOffset) + entry.indexCount, entry.lodIndexCount },
+            { m_lods + entry.firstLod, entry.lodCount }
+        };
+    }
+
+    // ranges of indices(mesh)
+    std::span<const Meshlet> meshlets(std::size_t mesh) const
+    {
+        return { m_meshlets + m_meshes[mesh].firstMeshlet, m_meshes[mesh].meshletCount };
+    }
+
+    std::vector<TextureRef> textures(std::size_t mesh) const
+    {
+        std::vector<TextureRef> refs{};
+        refs.reserve(m_meshes[mesh].textureCount);
+
+        const char* strings{ data() + m_header->stringsOffset };
+        for (std::uint32_t i{ 0 }; i < m_meshes[mesh].textureCount; ++i)
+        {
+            const TextureEntry& texture{ m_textures[m_meshes[mesh].firstTexture + i] };
+            refs.push_back({
+                std::string{ strings + texture.typeOffset, texture.typeLength },
+                std::string{ strings + texture.pathOffset, texture.pathLength }
+            });
+        }
+        return refs;
+    }
+
+    // write the meshes of a model, returns false if the file couldn't be written
+    static bool write(const std::filesystem::path& path, std::uint64_t sourceHash, unsigned int importFlags, std::span<const MeshData> meshes)
+    {
+        FileHeader header{};
+        header.sourceHash = sourceHash;
+        header.importFlags = importFlags;
+        header.meshCount = static_cast<std::uint32_t>(meshes.size());
+
+        // tables and strings
+        std::vector<MeshEntry> meshEntries(meshes.size());
+        std::vector<TextureEntry> textureEntries{};
+        std::vector<MeshLod> lodEntries{};
+        std::vector<Meshlet> meshletEntries{};
+        std::string strings{};
+
+        auto addString{ [&strings](const std::string& str) {
+            auto offset{ static_cast<std::uint32_t>(strings.size()) };
+            strings += str;
+            return offset;
+        } };
+
+        for (std::size_t i{ 0 }; i < meshes.size(); ++i)
+        {
+            meshEntries[i].firstTexture = static_cast<std::uint32_t>(textureEntries.size());
+            meshEntries[i].textureCount = static_cast<std::uint32_t>(meshes[i].textures.size());
+            for (const auto& texture : meshes[i].textures)
+            {
+                TextureEntry entry{};
+                entry.typeLength = static_cast<std::uint32_t>(texture.type.size());
+                entry.typeOffset = addString(texture.type);
+                entry.pathLength = static_cast<std::uint32_t>(texture.path.size());
+                entry.pathOffset = addString(texture.path);
+                textureEntries.push_back(entry);
+            }
+
+            meshEntries[i].firstLod = static_cast<std::uint32_t>(lodEntries.size());
+            meshEntries[i].lodCount = static_cast<std::uint32_t>(meshes[i].lods.size());
+            lodEntries.insert(lodEntries.end(), meshes[i].lods.begin(), meshes[i].lods.end());
+
+            meshEntries[i].firstMeshlet = static_cast<std::uint32_t>(meshletEntries.size());
+            meshEntries[i].meshletCount = static_cast<std::uint32_t>(meshes[i].meshlets.size());
+            meshletEntries.insert(meshletEntries.end(), meshes[i].meshlets.begin(), meshes[i].meshlets.end());
+        }
+        header.textureCount = static_cast<std::uint32_t>(textureEntries.size());
+        header.lodCount = static_cast<std::uint32_t>(lodEntries.size());
+        header.meshletCount = static_cast<std::uint32_t>(meshletEntries.size());
+        header.stringsOffset = sizeof(FileHeader) + meshEntries.size() * sizeof(MeshEntry) + textureEntries.size() * sizeof(TextureEntry)
+                             + lodEntries.size() * sizeof(MeshLod) + meshletEntries.size() * sizeof(Meshlet);
+
+        // blob offsets
+        std::uint64_t offset{ align(header.stringsOffset + strings.size()) };
+        for (std::size_t i{ 0 }; i < meshes.size(); ++i)
+        {
+            meshEntries[i].vertexOffset = offset;
+            meshEntries[i].vertexCount = static_cast<std::uint32_t>(meshes[i].vertices.size());
+            offset = align(offset + meshes[i].vertices.size() * sizeof(Vertex));
+
+            meshEntries[i].indexOffset = offset;
+            meshEntries[i].indexCount = static_cast<std::uint32_t>(meshes[i].indices.size());
+            meshEntries[i].lodIndexCount = static_cast<std::uint32_t>(meshes[i].lodIndices.size());
+            offset = align(offset + (meshes[i].indices.size() + meshes[i].lodIndices.size()) * sizeof(unsigned int));
+        }
+        header.fileSize = offset;
+
+        // write to a temporary file first so a crash never leaves a truncated cache behind
+        auto tempPath{ path };
+        tempPath += ".tmp";
+        {
+            std::ofstream file{ tempPath, std::ios::binary | std::ios::trunc };
+            auto writeBytes{ [&file](const void* bytes, std::size_t size) {
+                file.write(static_cast<const char*>(bytes), static_cast<std::streamsize>(size));
+            } };
+            auto pad{ [&file, &writeBytes]() {
+                static constexpr char zeros[s_alignment]{};
+                auto position{ static_cast<std::uint64_t>(file.tellp()) };
+                writeBytes(zeros, align(position) - position);
+            } };
+
+            writeBytes(&header, sizeof(header));
+            writeBytes(meshEntries.data(), meshEntries.size() * sizeof(MeshEntry));
+            writeBytes(textureEntries.data(), textureEntries.size() * sizeof(TextureEntry));
+            writeBytes(lodEntries.data(), lodEntries.size() * sizeof(MeshLod));
+            writeBytes(meshletEntries.data(), meshletEntries.size() * sizeof(Meshlet));
+            writeBytes(strings.data(), strings.size());
+            pad();
+
+            for (const auto& mesh : meshes)
+            {
+                writeBytes(mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex));
+                pad();
+                writeBytes(mesh.indices.data(), mesh.indices.size() * sizeof(unsigned int));
+                writeBytes(mesh.lodIndices.data(), mesh.lodIndices.size() * sizeof(unsigned int));
+                pad();
+            }
+
+            if (!file)
+                return false;
+        }
+
+        std::error_code error{};
+        std::filesystem::rename(tempPath, path, error);
+        return !error;
+    }
+
+    static std::filesystem::path pathOf(const std::filesystem::path& source)
+    {
+        auto path{ source };
+        path += ".mesh";
+        return path;
+    }
+
+    // content hash of the source file, 0 if it can't be read.
+    // FNV-1a on 8 byte words (the byte-wise version is too slow for a 50 MB .obj)
+    static std::uint64_t hashSource(const std::filesystem::path& source, unsigned int importFlags)
+    {
+        MappedFile file{ source };
+        if (!file.isOpen())
+            return 0;
+
+        std::string_view bytes{ file.view() };
+        std::uint64_t hash{ 0xcbf29ce484222325ull };
+        auto mix{ [&hash](std::uint64_t word) {
+            hash ^= word;
+            hash *= 0x100000001b3ull;
+            hash ^= hash >> 32;
+        } };
+
+        std::size_t i{ 0 };
+        for (; i + 8 <= bytes.size(); i += 8)
+        {
+            std::uint64_t word{};
+            std::memcpy(&word, bytes.data() + i, sizeof(word));
+            mix(word);
+        }
+        if (i < bytes.size())
+        {
+            std::uint64_t tail{};
+            std::memcpy(&tail, bytes.data() + i, bytes.size() - i);
+            mix(tail);
+        }
+
+        mix(bytes.size());
+        mix(importFlags);
+
+        // the textures of an .obj come from its .mtl files, they aren't part of its bytes
+        for (const auto& library : materialLibraries(source, bytes))
+        {
+            std::error_code sizeError{};
+            std::error_code timeError{};
+            auto size{ std::filesystem::file_size(library, sizeError) };
+            auto time{ std::filesystem::last_write_time(library, timeError) };
+            mix(sizeError ? 0 : size);
+            mix(timeError ? 0 : static_cast<std::uint64_t>(time.time_since_epoch().count()));
+        }
+        return hash;
+    }
+
+private:
+    const char* data() const { return m_file.view().data(); }
+
+    // files named by the "mtllib" lines of an .obj, relative to its directory
+    static std::vector<std::filesystem::path> materialLibraries(const std::filesystem::path& source, std::string_view bytes)
+    {
+        std::vector<std::filesystem::path> libraries{};
+        std::string extension{ source.extension().string() };
+        if (extension != ".obj" && extension != ".OBJ")
+            return libraries;
+
+        constexpr std::string_view keyword{ "mtllib" };
+        for (auto position{ bytes.find(keyword) }; position != std::string_view::npos; position = bytes.find(keyword, position + keyword.size()))
+        {
+            // only at the start of a line, followed by white space
+            if ((position > 0 && bytes[position - 1] != '\n') || position + keyword.size() >= bytes.size()
+                || (bytes[position + keyword.size()] != ' ' && bytes[position + keyword.size()] != '\t'))
+                continue;
+
+            auto lineEnd{ bytes.find_first_of("\r\n", position) };
+            std::string_view name{ bytes.substr(position + keyword.size(), lineEnd == std::string_view::npos ? std::string_view::npos : lineEnd - position - keyword.size()) };
+            auto first{ name.find_first_not_of(" \t") };
+            auto last{ name.find_last_not_of(" \t") };
+            if (first != std::string_view::npos)
+                libraries.push_back(source.parent_path() / std::string{ name.substr(first, last - first + 1) });
+        }
+        return libraries;
+    }
+
+    static std::uint64_t align(std::uint64_t offset) { return (offset + s_alignment - 1) & ~(s_alignment - 1); }
+
+    static bool fits(std::uint64_t offset, std::uint64_t size, std::uint64_t fileSize)
+    {
+        return offset <= fileSize && size <= fileSize - offset;
+    }
+};
+
+
+#endif
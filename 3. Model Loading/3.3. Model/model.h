@@ -5,7 +5,12 @@
 #include <string>
 #include <string_view>
 #include <iostream>
-#include <cstring>                  // std::strcmp
+#include <unordered_map>
+#include <map>
+#include <span>
+#include <array>
+#include <limits>
+#include <algorithm>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
@@ -17,36 +22,208 @@
 
 #include <shader_header/shader.h>
 #include <mesh_header/mesh.h>       // Vertex, Texture, Mesh
+#include <mesh_header/mesh_optimizer.h>
+#include <mesh_header/vertex_welder.h>
+#include <mesh_header/mesh_simplifier.h>
+#include <mesh_header/meshlet.h>
+#include <model_header/mesh_cache.h>    // MeshData, TextureRef, MeshCache
+#include <model_header/material_packer.h>   // MaterialPacker, MeshBatch
+#include <gl_state_header/gl_state.h>
+#include <texture_header/texture_loader.h>
+#include <texture_header/texture_cache.h>
+#include <texture_header/texture_residency.h>
+#include <camera_header/camera.h>
+#include <thread_header/thread_pool.h>
+#include <transform_header/transform.h>     // normalMatrix()
 
 
 unsigned int TextureFromFile(const char* path, const std::string& directory, bool gamma=false);
 
+
+struct ModelOptions
+{
+    bool         gamma{};                   // diffuse maps are sRGB
+    bool         flipTextures{};            // textures flipped on the y-axis as they are decoded (the loaders set
+                                            // stb_image's thread-local flag, a global stbi_set_flip_vertically_on_load() has no effect)
+    bool         packMaterials{};           // diffuse/specular maps in texture arrays, the meshes sharing them merged,
+                                            // drawn with the TEXTURE_ARRAYS variant of the shader (see material_packer.h),
+                                            // without levels of detail, cooked .dds files or streaming
+    bool         streamTextures{};          // textures through TextureResidency::shared() instead of the TextureCache,
+                                            // their levels follow requestTextures() (not with packMaterials)
+    VertexFormat vertexFormat{ VertexFormat::FULL };    // COMPACT: drawn with the COMPACT_VERTICES variant of the shader
+};
+
+
 class Model
 {
 public:
     Model(const std::string& path, bool gamma=false)
-        : m_gammaCorrection{ gamma }
+        : Model{ path, ModelOptions{ gamma } }
+    {
+    }
+
+    Model(const std::string& path, const ModelOptions& options)
+        : m_gammaCorrection{ options.gamma }
+        , m_flipTextures{ options.flipTextures }
+        , m_packMaterials{ options.packMaterials }
+        , m_streamTextures{ options.streamTextures }
+        , m_vertexFormat{ options.vertexFormat }
     {
         loadModel(path);
     }
 
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
+
+    // the streamed textures belong to this model alone (cached ones go with their handles)
+    ~Model()
+    {
+        for (const auto& [key, texture] : m_streamed)
+            TextureResidency::shared().remove(texture);
+    }
+
     void draw(Shader& shader)
     {
         for (auto& mesh : m_meshes)
             mesh.draw(shader);
+        for (auto& batch : m_batches)
+            batch.draw(shader);
+    }
+
+    // set the "model" and "normalMatrix" uniforms once for the whole model, then draw it
+    void draw(Shader& shader, const glm::mat4& modelMatrix)
+    {
+        shader.setMat4("model", modelMatrix);
+        shader.setMat3("normalMatrix", normalMatrix(modelMatrix));
+        draw(shader);
+    }
+
+    // streamed textures: request the levels needed to draw the model at `modelMatrix` this frame,
+    // from the projected size of its bounding sphere. call before TextureResidency::shared().update()
+    void requestTextures(const Camera& camera, const glm::mat4& modelMatrix, int viewportHeight) const
+    {
+        if (m_streamed.empty())
+            return;
+
+        glm::vec3 center{ modelMatrix * glm::vec4{ (m_boundsMin + m_boundsMax) * 0.5f, 1.0f } };
+        float scale{ std::max({ glm::length(glm::vec3{ modelMatrix[0] }), glm::length(glm::vec3{ modelMatrix[1] }), glm::length(glm::vec3{ modelMatrix[2] }) }) };
+        float radius{ glm::length(m_boundsMax - m_boundsMin) * 0.5f * scale };
+
+        auto& residency{ TextureResidency::shared() };
+        for (const auto& [key, texture] : m_streamed)
+            residency.request(texture, camera, center, radius, viewportHeight);
+    }
+
+    // levels of detail for drawing the model at `modelMatrix`: each mesh takes the coarsest level
+    // whose error covers less than a pixel (lod::select()), seen from the camera at the nearest
+    // point of the bounding sphere. merged meshes (packMaterials) are always drawn in full
+    void selectLods(const Camera& camera, const glm::mat4& modelMatrix, int viewportHeight)
+    {
+        glm::vec3 center{ modelMatrix * glm::vec4{ (m_boundsMin + m_boundsMax) * 0.5f, 1.0f } };
+        float scale{ std::max({ glm::length(glm::vec3{ modelMatrix[0] }), glm::length(glm::vec3{ modelMatrix[1] }), glm::length(glm::vec3{ modelMatrix[2] }) }) };
+        float radius{ glm::length(m_boundsMax - m_boundsMin) * 0.5f * scale };
+
+        // errors are in object space, the model matrix scales them
+        float pixelsPerUnit{ lod::pixelsPerUnit(glm::length(center - camera.position) - radius, camera.fov, viewportHeight) * scale };
+        for (auto& mesh : m_meshes)
+            mesh.selectLod(pixelsPerUnit);
+    }
+
+    /*
+        meshlet culling for drawing the model at `modelMatrix`: the clusters of triangles outside
+        the view frustum or facing away from the camera are left out of the next draws, until
+        the next call (see Mesh::cull()). meshes at a coarser level of detail are drawn whole,
+        call after selectLods()
+    */
+    MeshletCullStats cullMeshlets(const glm::mat4& projection, const glm::mat4& view, const glm::mat4& modelMatrix)
+    {
+        // frustum and camera position in object space
+        glm::mat4 modelView{ view * modelMatrix };
+        Frustum frustum{ Frustum::fromMatrix(projection * modelView) };
+        glm::vec3 camera{ glm::inverse(modelView)[3] };
+
+        MeshletCullStats stats{};
+        for (auto& mesh : m_meshes)
+            mesh.cull(frustum, camera, stats);
+        for (auto& batch : m_batches)
+            batch.cull(frustum, camera, stats);
+        return stats;
+    }
+
+    // triangles of one draw() at the selected levels of detail, after meshlet culling
+    std::size_t triangleCount() const
+    {
+        std::size_t triangles{ 0 };
+        for (const auto& mesh : m_meshes)
+            triangles += mesh.triangleCount();
+        for (const auto& batch : m_batches)
+            triangles += batch.triangleCount();
+        return triangles;
+    }
+
+    // draw calls of one draw(): one per mesh, or one per batch of meshes sharing texture arrays
+    std::size_t drawCalls() const { return m_meshes.size() + m_batches.size(); }
+
+    // GPU size of the vertex buffers
+    std::size_t vertexBytes() const
+    {
+        std::size_t bytes{ 0 };
+        for (const auto& mesh : m_meshes)
+            bytes += mesh.vertexBytes();
+        for (const auto& batch : m_batches)
+            bytes += batch.vertexBytes();
+        return bytes;
+    }
+
+    // GPU size of the index buffers (16 bit indices wherever a mesh allows)
+    std::size_t indexBytes() const
+    {
+        std::size_t bytes{ 0 };
+        for (const auto& mesh : m_meshes)
+            bytes += mesh.indexBytes();
+        for (const auto& batch : m_batches)
+            bytes += batch.indexBytes();
+        return bytes;
     }
 
 private:
     // model data
-    std::vector<Texture> m_texturesLoaded{};    // stores all the textures loaded so far, optimization to make sure texture aren't loaded more than once.
+    std::unordered_map<std::string, TextureHandle> m_texturesLoaded{};  // the textures of this model (by path), shared with every other user through the TextureCache
     std::vector<Mesh>    m_meshes{};
+    std::vector<MeshBatch> m_batches{};         // instead of m_meshes with packed materials
     std::string          m_directory{};
     bool                 m_gammaCorrection{};
+    bool                 m_flipTextures{};
+    bool                 m_packMaterials{};
+    bool                 m_streamTextures{};
+    VertexFormat         m_vertexFormat{};
+    std::unordered_map<std::string, unsigned int> m_streamed{};        // streamed textures (by path), in TextureResidency::shared() until ~Model
+
+    // object space bounds of every vertex
+    glm::vec3            m_boundsMin{ std::numeric_limits<float>::max() };
+    glm::vec3            m_boundsMax{ std::numeric_limits<float>::lowest() };
+
+    // geometry of a converted or cached mesh, not owned
+    struct MeshView
+    {
+        std::span<const Vertex>       vertices{};
+        std::span<const unsigned int> indices{};
+        std::vector<TextureRef>       textures{};
+        std::span<const Meshlet>      meshlets{};
+    };
 
     void loadModel(const std::string& path)
     {
+        // retrieve the directory path of the filepath
+        m_directory = path.substr(0, path.find_last_of('/'));
+
+        // an up to date cache skips Assimp entirely
+        std::uint64_t sourceHash{ MeshCache::hashSource(path, s_importFlags) };
+        if (sourceHash != 0 && loadCache(path, sourceHash))
+            return;
+
         Assimp::Importer importer{};
-        const aiScene* scene{ importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs) };
+        const aiScene* scene{ importer.ReadFile(path, s_importFlags) };
         /**
          * the second argument of Assimp::Importer.ReadFile() function allows us to specify
          * several options that forces Assimp to do extra calculations/operations on the
@@ -71,149 +248,348 @@ private:
             return;
         }
 
-        // retrieve the directory path of the filepath
-        m_directory = path.substr(0, path.find_last_of('/'));
-        processNode(scene->mRootNode, scene);
+        // convert every mesh on the thread pool (CPU only), then create the GL objects here,
+        // on the thread that owns the context, in node order
+        std::vector<MeshData> meshes{ convertScene(scene) };
+        for (const auto& mesh : meshes)
+            growBounds(mesh.vertices);
+
+        if (sourceHash != 0 && !MeshCache::write(MeshCache::pathOf(path), sourceHash, s_importFlags, meshes))
+            std::cerr << "WARNING::MODEL::could not write the mesh cache of " << path << std::endl;
+
+        if (m_packMaterials)
+        {
+            std::vector<MeshView> views{};
+            for (const auto& mesh : meshes)
+                views.push_back({ mesh.vertices, mesh.indices, mesh.textures, mesh.meshlets });
+            packMeshes(views);
+            return;
+        }
+
+        m_meshes.reserve(meshes.size());
+        for (auto& mesh : meshes)
+            m_meshes.emplace_back(std::move(mesh.vertices), std::move(mesh.indices), loadTextures(mesh.textures), m_vertexFormat,
+                                  LodChain{ mesh.lodIndices, mesh.lods }, mesh.meshlets);
     }
 
-    void processNode(aiNode* node, const aiScene* scene)
+    // mmap the cache and upload the vertex/index ranges straight from the mapping
+    bool loadCache(const std::string& path, std::uint64_t sourceHash)
     {
-        // process all the node's meshes (if any)
-        for (unsigned int i{ 0 }; i < node->mNumMeshes; ++i)
+        MeshCache cache{ MeshCache::pathOf(path) };
+        if (!cache.isValid(sourceHash, s_importFlags))
+            return false;
+
+        for (std::size_t i{ 0 }; i < cache.meshCount(); ++i)
+            growBounds(cache.vertices(i));
+
+        if (m_packMaterials)
+        {
+            std::vector<MeshView> views{};
+            for (std::size_t i{ 0 }; i < cache.meshCount(); ++i)
+                views.push_back({ cache.vertices(i), cache.indices(i), cache.textures(i), cache.meshlets(i) });
+            packMeshes(views);
+            return true;
+        }
+
+        m_meshes.reserve(cache.meshCount());
+        for (std::size_t i{ 0 }; i < cache.meshCount(); ++i)
+            m_meshes.emplace_back(cache.vertices(i), cache.indices(i), loadTextures(cache.textures(i)), m_vertexFormat, cache.lods(i), cache.meshlets(i));
+        return true;
+    }
+
+    void growBounds(std::span<const Vertex> vertices)
+    {
+        for (const auto& vertex : vertices)
         {
-            aiMesh* mesh{ scene->mMeshes[node->mMeshes[i]] };
-            m_meshes.push_back(processMesh(mesh, scene));
+            m_boundsMin = glm::min(m_boundsMin, vertex.m_position);
+            m_boundsMax = glm::max(m_boundsMax, vertex.m_position);
         }
+    }
+
+    // pack the maps into texture arrays, then merge the meshes drawing from the same arrays
+    void packMeshes(const std::vector<MeshView>& meshes)
+    {
+        MaterialPacker packer{ m_directory, m_gammaCorrection, m_flipTextures };
+
+        std::vector<PackedMaterial> materials{};
+        materials.reserve(meshes.size());
+        for (const auto& mesh : meshes)
+            materials.push_back(packer.add(mesh.textures));
+        packer.upload();
+
+        // meshes by (diffuse array, specular array), in a stable order
+        std::map<std::array<int, MaterialPacker::TYPE_COUNT>, std::vector<std::size_t>> groups{};
+        for (std::size_t i{ 0 }; i < meshes.size(); ++i)
+            groups[{ materials[i].slots[MaterialPacker::DIFFUSE].array, materials[i].slots[MaterialPacker::SPECULAR].array }].push_back(i);
+
+        for (const auto& [arrays, members] : groups)
+        {
+            std::vector<Vertex> vertices{};
+            std::vector<unsigned int> indices{};
+            std::vector<MeshBatch::Layers> layers{};
+            std::vector<Meshlet> meshlets{};
+
+            for (std::size_t i : members)
+            {
+                for (Meshlet meshlet : meshes[i].meshlets)
+                {
+                    meshlet.firstIndex += static_cast<std::uint32_t>(indices.size());
+                    meshlets.push_back(meshlet);
+                }
+
+                auto base{ static_cast<unsigned int>(vertices.size()) };
+                vertices.insert(vertices.end(), meshes[i].vertices.begin(), meshes[i].vertices.end());
+                for (unsigned int index : meshes[i].indices)
+                    indices.push_back(base + index);
+
+                const auto& slots{ materials[i].slots };
+                MeshBatch::Layers layer{ static_cast<std::uint16_t>(slots[MaterialPacker::DIFFUSE].layer),
+                                         static_cast<std::uint16_t>(slots[MaterialPacker::SPECULAR].layer) };
+                layers.insert(layers.end(), meshes[i].vertices.size(), layer);
+            }
+
+            const auto& slots{ materials[members.front()].slots };
+            m_batches.emplace_back(vertices, indices, layers,
+                std::array<unsigned int, MaterialPacker::TYPE_COUNT>{ packer.textureOf(slots[MaterialPacker::DIFFUSE]), packer.textureOf(slots[MaterialPacker::SPECULAR]) },
+                m_vertexFormat, meshlets);
+        }
+    }
+
+public:
+    static constexpr unsigned int s_importFlags{ aiProcess_Triangulate | aiProcess_FlipUVs };
+
+    // post-transform cache efficiency of a model's triangles before (as Assimp imports them)
+    // and after the index optimization
+    struct CookStats
+    {
+        VertexCacheStats source{};
+        VertexCacheStats optimized{};
+        std::size_t      sourceVertices{};
+        std::size_t      weldedVertices{};
+        std::size_t      triangles{};
+        std::size_t      meshlets{};
+    };
+
+    // import a model and write its mesh cache without creating any GL object (offline cooking)
+    static bool cook(const std::string& path, CookStats* stats = nullptr)
+    {
+        std::uint64_t sourceHash{ MeshCache::hashSource(path, s_importFlags) };
+        if (sourceHash == 0)
+        {
+            std::cerr << "ERROR::MODEL::could not read " << path << std::endl;
+            return false;
+        }
+
+        Assimp::Importer importer{};
+        const aiScene* scene{ importer.ReadFile(path, s_importFlags) };
+        if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+        {
+            std::cerr << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
+            return false;
+        }
+
+        std::vector<MeshData> meshes{ convertScene(scene) };
+        if (stats)
+        {
+            *stats = {};
+            for (unsigned int i{ 0 }; i < scene->mNumMeshes; ++i)
+            {
+                stats->sourceVertices += scene->mMeshes[i]->mNumVertices;
+                if (scene->mMeshes[i]->mPrimitiveTypes == aiPrimitiveType_TRIANGLE)
+                    stats->source += sourceCacheStats(scene->mMeshes[i]);
+            }
+            for (const auto& mesh : meshes)
+            {
+                stats->weldedVertices += mesh.vertices.size();
+                stats->triangles += mesh.indices.size() / 3;
+                stats->meshlets += mesh.meshlets.size();
+                if (mesh.indices.size() % 3 == 0)
+                    stats->optimized += mesh_optimizer::analyzeVertexCache(mesh.indices, mesh.vertices.size());
+            }
+        }
+
+        return MeshCache::write(MeshCache::pathOf(path), sourceHash, s_importFlags, meshes);
+    }
+
+    // convert every mesh of the scene in parallel, the result is in node order (depth first, like
+    // the recursive processNode() this replaces) no matter which thread finished first.
+    // doesn't touch GL, so it can run without a context (e.g. to benchmark the import)
+    static std::vector<MeshData> convertScene(const aiScene* scene, ThreadPool& pool = ThreadPool::shared())
+    {
+        std::vector<const aiMesh*> order{};
+        collectMeshes(scene->mRootNode, scene, order);
+
+        std::vector<MeshData> meshes(order.size());
+        pool.parallelFor(order.size(), [&](std::size_t i) {
+            meshes[i] = convertMesh(order[i], scene);
+        });
+        return meshes;
+    }
+
+private:
+    static void collectMeshes(const aiNode* node, const aiScene* scene, std::vector<const aiMesh*>& order)
+    {
+        // the node's meshes (if any)
+        for (unsigned int i{ 0 }; i < node->mNumMeshes; ++i)
+            order.push_back(scene->mMeshes[node->mMeshes[i]]);
 
         // then do the same for each of its children
         for (unsigned int i{ 0 }; i < node->mNumChildren; ++i)
-            processNode(node->mChildren[i], scene);
+            collectMeshes(node->mChildren[i], scene, order);
     }
 
-    Mesh processMesh(aiMesh* mesh, const aiScene* scene)
+    // worker thread
+    static MeshData convertMesh(const aiMesh* mesh, const aiScene* scene)
     {
-        std::vector<Vertex> vertices{};
-        std::vector<unsigned int> indices{};
-        std::vector<Texture> textures{};
+        MeshData data{};
+
+        // vertices, written in place (the size is known up front)
+        data.vertices.resize(mesh->mNumVertices);
+
+        bool hasNormals{ mesh->HasNormals() };
+        bool hasTexCoords{ mesh->HasTextureCoords(0) };
+        bool hasTangents{ mesh->HasTangentsAndBitangents() };
 
         for (unsigned int i{ 0 }; i < mesh->mNumVertices; ++i)
         {
-            // process vertex positions, normals and texture coordinates
-
-            Vertex vertex{
-                // position (Assimp calls their vertex position array mVertices)
-                { mesh->mVertices[i].x,
-                  mesh->mVertices[i].y,
-                  mesh->mVertices[i].z },
-                // normals
-                [&]() -> glm::vec3 {
-                    if (mesh->HasNormals())
-                        return { mesh->mNormals[i].x,
-                                 mesh->mNormals[i].y,
-                                 mesh->mNormals[i].z };
-                    else
-                        return {};
-                }(),
-                // textures (Assimp allows a model to have up to 8 different texture coordinates per vertex)
-                // for now, we're going to use the first set of texture coordinates
-                [&]() -> glm::vec2 {
-                    if (mesh->HasTextureCoords(0))
-                        return { mesh->mTextureCoords[0][i].x,
-                                 mesh->mTextureCoords[0][i].y };
-                    else
-                        return {};
-                }(),
-                // tangent
-                [&]() -> glm::vec3 {
-                    if (mesh->HasTangentsAndBitangents())
-                        return { mesh->mTangents[i].x,
-                                 mesh->mTangents[i].y,
-                                 mesh->mTangents[i].z };
-                    else
-                        return {};
-                }(),
-                // bitangent
-                [&]() -> glm::vec3 {
-                    if (mesh->HasTangentsAndBitangents())
-                        return { mesh->mBitangents[i].x,
-                                 mesh->mBitangents[i].y,
-                                 mesh->mBitangents[i].z };
-                    else
-                        return {};
-                }()
-            };
-            vertices.push_back(vertex);
+            Vertex& vertex{ data.vertices[i] };
+
+            // position (Assimp calls their vertex position array mVertices)
+            vertex.m_position = { mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z };
+
+            // normals
+            if (hasNormals)
+                vertex.m_normal = { mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z };
+
+            // textures (Assimp allows a model to have up to 8 different texture coordinates per vertex)
+            // for now, we're going to use the first set of texture coordinates
+            if (hasTexCoords)
+                vertex.m_texCoords = { mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y };
+
+            // tangent and bitangent
+            if (hasTangents)
+            {
+                vertex.m_tangent = { mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z };
+                vertex.m_bitangent = { mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z };
+            }
         }
 
-        // process indices
+        // indices (faces are triangles after aiProcess_Triangulate, points/lines may still be smaller)
+        data.indices.reserve(static_cast<std::size_t>(mesh->mNumFaces) * 3);
         for (unsigned int i{ 0 }; i < mesh->mNumFaces; ++i)
         {
-            aiFace face{ mesh->mFaces[i] };
-            for (unsigned int j{ 0 }; j < face.mNumIndices; ++j)
-                indices.push_back(face.mIndices[j]);
+            const aiFace& face{ mesh->mFaces[i] };
+            data.indices.insert(data.indices.end(), face.mIndices, face.mIndices + face.mNumIndices);
         }
 
-        // process material
-        if (mesh->mMaterialIndex >= 0)
+        // Assimp gives every face corner its own vertex (the import runs without
+        // aiProcess_JoinIdenticalVertices), join the identical ones
+        vertex_welder::Welded welded{ vertex_welder::weldExact<Vertex>(data.vertices) };
+        if (welded.vertexCount < data.vertices.size())
         {
-            aiMaterial* material{ scene->mMaterials[mesh->mMaterialIndex] };
-            
-            auto diffuseMaps{
-                loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse")
-            };
-            textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
-
-            auto specularMaps{
-                loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular")
-            };
-            textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
-
-            auto normalMaps{
-                loadMaterialTextures(material, aiTextureType_NORMALS, "texture_normal")
-            };
-            textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
-
-            auto heightMaps{
-                loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_height")
-            };
-            textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+            vertex_welder::remapIndices(data.indices, welded);
+            data.vertices = vertex_welder::compact<Vertex>(data.vertices, welded);
         }
 
-        return { vertices, indices, textures };
+        // vertex cache, overdraw and vertex fetch order, stored like this in the mesh cache
+        if (mesh->mPrimitiveTypes == aiPrimitiveType_TRIANGLE)
+        {
+            mesh_optimizer::optimize(data.vertices, data.indices, &Vertex::m_position);
+            buildLods(data);
+            buildMeshlets(data);
+        }
+
+        // material, only the texture paths here: loading them needs the GL context
+        const aiMaterial* material{ scene->mMaterials[mesh->mMaterialIndex] };
+        collectTextures(material, aiTextureType_DIFFUSE, "texture_diffuse", data.textures);
+        collectTextures(material, aiTextureType_SPECULAR, "texture_specular", data.textures);
+        collectTextures(material, aiTextureType_NORMALS, "texture_normal", data.textures);
+        collectTextures(material, aiTextureType_HEIGHT, "texture_height", data.textures);
+
+        return data;
     }
 
-    std::vector<Texture> loadMaterialTextures(aiMaterial* mat, aiTextureType type, const std::string& typeName)
+    // weights of the attribute differences in a collapse cost (normal xyz, texture coordinates uv),
+    // against distances relative to the mesh extent
+    static constexpr std::array<float, 5> s_lodAttributeWeights{ 0.1f, 0.1f, 0.1f, 0.1f, 0.1f };
+
+    // worker thread: simplified levels of the (optimized) mesh, sharing its vertices
+    static void buildLods(MeshData& data)
+    {
+        std::vector<glm::vec3> positions{};
+        std::vector<float> attributes{};
+        positions.reserve(data.vertices.size());
+        attributes.reserve(data.vertices.size() * s_lodAttributeWeights.size());
+        for (const auto& vertex : data.vertices)
+        {
+            positions.push_back(vertex.m_position);
+            attributes.insert(attributes.end(), { vertex.m_normal.x, vertex.m_normal.y, vertex.m_normal.z, vertex.m_texCoords.x, vertex.m_texCoords.y });
+        }
+
+        auto levels{ mesh_simplifier::buildLods(data.indices, positions, { attributes, s_lodAttributeWeights }) };
+        mesh_simplifier::flatten(levels, data.lodIndices, data.lods);
+    }
+
+    // worker thread: clusters of the (optimized) full mesh, for culling
+    static void buildMeshlets(MeshData& data)
+    {
+        std::vector<glm::vec3> positions{};
+        positions.reserve(data.vertices.size());
+        for (const auto& vertex : data.vertices)
+            positions.push_back(vertex.m_position);
+
+        data.meshlets = meshlet::build(data.indices, positions);
+    }
+
+    static VertexCacheStats sourceCacheStats(const aiMesh* mesh)
+    {
+        std::vector<unsigned int> indices{};
+        for (unsigned int i{ 0 }; i < mesh->mNumFaces; ++i)
+            indices.insert(indices.end(), mesh->mFaces[i].mIndices, mesh->mFaces[i].mIndices + mesh->mFaces[i].mNumIndices);
+        return mesh_optimizer::analyzeVertexCache(indices, mesh->mNumVertices);
+    }
+
+    static void collectTextures(const aiMaterial* mat, aiTextureType type, const char* typeName, std::vector<TextureRef>& textures)
     {
-        std::vector<Texture> texes{};
         for (unsigned int i{ 0 }; i < mat->GetTextureCount(type); ++i)
         {
             aiString str;
             mat->GetTexture(type, i, &str);
+            textures.push_back({ typeName, str.C_Str() });
+        }
+    }
 
-            bool skip{ false };
-            // check if texture has been loaded already
-            for (auto& tex : m_texturesLoaded)
-            {
-                // if (std::strcmp(tex.m_path.data(), str.C_Str()) == 0)
-                if (std::strcmp(tex.m_path.c_str(), str.C_Str()) == 0)
-                {
-                    texes.push_back(tex);
-                    skip = true;
-                    break;
-                }
-            }
+    // main thread: load the textures of a mesh, each file only once per model
+    std::vector<Texture> loadTextures(const std::vector<TextureRef>& refs)
+    {
+        std::vector<Texture> texes{};
+        texes.reserve(refs.size());
+
+        for (const auto& ref : refs)
+        {
+            // only color maps are stored in sRGB, specular/normal/height maps hold linear data
+            TextureOptions options{};
+            options.gamma = m_gammaCorrection && ref.type == "texture_diffuse";
+            options.flipVertically = m_flipTextures;
 
-            // if texture hasn't been loaded already, load it
-            if (!skip)
+            // check if texture has been loaded already (by this model, then by anyone through the cache)
+            std::string key{ options.gamma ? ref.path + "|srgb" : ref.path };
+
+            if (m_streamTextures)
             {
-                Texture tex{
-                    TextureFromFile(str.C_Str(), m_directory),  // id
-                    typeName,                                   // type
-                    str.C_Str()                                 // path
-                };
-                texes.push_back(tex);
-                m_texturesLoaded.push_back(tex);
+                auto streamed{ m_streamed.find(key) };
+                if (streamed == m_streamed.end())
+                    streamed = m_streamed.emplace(key, TextureResidency::shared().add(m_directory + "/" + ref.path, options)).first;
+
+                texes.push_back({ streamed->second, ref.type, ref.path });
+                continue;
             }
+
+            auto it{ m_texturesLoaded.find(key) };
+            if (it == m_texturesLoaded.end())
+                it = m_texturesLoaded.emplace(key, TextureCache::acquire(m_directory + "/" + ref.path, options)).first;
+
+            texes.push_back({ it->second.id(), ref.type, ref.path });
         }
 
         return texes;
@@ -221,46 +597,14 @@ private:
 };
 
 
+// the texture shows a placeholder texel until TextureLoader::shared().update() uploads the decoded image
 unsigned int TextureFromFile(const char* path, const std::string& directory, bool gamma)
 {
     std::string fileName{ directory + "/" + path };
-    unsigned int textureID{};
-    
-    glGenTextures(1, &textureID);
-
-    int width{};
-    int height{};
-    int nrComponents{};
 
-    unsigned char* data{ stbi_load(fileName.c_str(), &width, &height, &nrComponents, 0) };
-    if (data)
-    {
-        GLenum format{};
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
-    else
-    {
-        std::cerr << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
-    
-    return textureID;
+    TextureOptions options{};
+    options.gamma = gamma;
+    return TextureLoader::shared().load(fileName, options);
 }
 
 #endif
\ No newline at end of file
@@ -33,6 +33,21 @@ namespace configuration
     constexpr int screenWidth{ 800 };
     constexpr int screenHeight{ 600 };
     float aspectRatio{ static_cast<float>(screenWidth)/screenHeight };
+
+    // diffuse/specular maps in texture arrays, meshes sharing them merged into one draw call.
+    // off by default: packed maps are always decoded from the images at full size (no cooked
+    // .dds, no streaming) and merged meshes have no levels of detail
+    constexpr bool packMaterials{ false };
+
+    // mip levels streamed in and out by screen size (TextureResidency), used when not packed
+    constexpr bool streamTextures{ true };
+
+    // quantized vertex buffers, 20 instead of 88 bytes per vertex
+    constexpr VertexFormat vertexFormat{ VertexFormat::COMPACT };
+
+    // clusters of triangles off screen or facing away left out of the draws, with back faces
+    // culled by GL as well (the cone test assumes they aren't drawn)
+    constexpr bool cullMeshlets{ true };
 }
 
 namespace timing
@@ -99,14 +114,24 @@ int main()
 
     // enable depth testing
     glEnable(GL_DEPTH_TEST);
-
-    // tell stb_image.h to flip loaded texture's on the y-axis (before loading model).
-    stbi_set_flip_vertically_on_load(true);
+    if (configuration::cullMeshlets)
+        glEnable(GL_CULL_FACE);
 
     // backpack model
     //---------------
-    Model model{ "../../../resources/model/backpack/backpack.obj" };
-    Shader modelShader{ "./shader.vs", "./shader.fs" };
+    ModelOptions modelOptions{};
+    modelOptions.flipTextures = true;        // the uvs are flipped by aiProcess_FlipUVs, so are the images
+    modelOptions.packMaterials = configuration::packMaterials;
+    modelOptions.streamTextures = configuration::streamTextures;
+    modelOptions.vertexFormat = configuration::vertexFormat;
+    Model model{ "../../../resources/model/backpack/backpack.obj", modelOptions };
+
+    ShaderDefines modelDefines{};
+    if (configuration::packMaterials)
+        modelDefines.set("TEXTURE_ARRAYS");
+    if (configuration::vertexFormat == VertexFormat::COMPACT)
+        modelDefines.set("COMPACT_VERTICES");
+    Shader modelShader{ "./shader.vs", "./shader.fs", modelDefines };
     glm::vec3 modelPos{ 0.0f, 0.0f, 0.0f };
     glm::vec3 modelScale{ 1.0f, 1.0f, 1.0f };
     //---------------
@@ -130,11 +155,16 @@ int main()
     glm::vec3 lightScale{ 1.0f, 1.0f, 1.0f };
     //-------------
 
+    MeshletCullStats cullStats{};
+
     while (!glfwWindowShouldClose(window))
     {
         // input
         processInput(window);
 
+        // upload the textures decoded since the last frame
+        TextureLoader::shared().update();
+
         // render
         //-------
         glClearColor(0.1f, 0.1f, 0.11f, 1.0f);
@@ -160,7 +190,6 @@ int main()
             glm::mat4 modelMatrix{ 1.0f };
             modelMatrix = glm::translate( modelMatrix , modelPos);
             modelMatrix = glm::scale(modelMatrix, modelScale);
-            modelShader.setMat4("model", modelMatrix);
 
             // uniforms
             // modelShader.setVec3("pointLights[0].position",   lightSource.position);
@@ -172,7 +201,17 @@ int main()
             modelShader.setFloat("pointLights[0].linear",    lightSource.linear);
             modelShader.setFloat("pointLights[0].quadratic", lightSource.quadratic);
 
-            model.draw(modelShader);
+            // streamed textures: the levels for this frame's size on screen (uploaded by the next update())
+            model.requestTextures(camera, modelMatrix, configuration::screenHeight);
+
+            // coarser meshes as the backpack gets smaller on screen (not for packed materials)
+            model.selectLods(camera, modelMatrix, configuration::screenHeight);
+
+            if (configuration::cullMeshlets)
+                cullStats = model.cullMeshlets(projectionMatrix, viewMatrix, modelMatrix);
+
+            // sets model + normal matrix once, not per mesh/vertex
+            model.draw(modelShader, modelMatrix);
 
         }
 
@@ -209,8 +248,26 @@ int main()
         glfwSwapBuffers(window);
         glfwPollEvents();
         updateDeltaTime();
+        TextureResidency::shared().update();
+        GLState::endFrame();
     }
 
+    // draw calls and texture binds of the last frame, packed or not
+    std::cout << "Model: " << model.drawCalls() << " draw call(s) per frame" << (configuration::packMaterials ? " (packed materials)" : "")
+              << " | " << model.vertexBytes() / 1024.0 << " KB of vertices, "
+              << model.indexBytes() / 1024.0 << " KB of indices | " << model.triangleCount() << " triangle(s) in the last frame\n";
+    if (configuration::cullMeshlets)
+        std::cout << "Meshlets: " << cullStats.outside << " outside the frustum, " << cullStats.backfacing << " back-facing of "
+                  << cullStats.meshlets << " | " << cullStats.culledTriangles << " of " << cullStats.triangles << " triangle(s) culled in the last frame\n";
+    GLState::printStats();
+    TextureUnits::printStats();
+    TextureCache::printStats();
+    TextureResidency::shared().printStats();
+
+    // the cached and streamed textures are deleted while the context is current, the locals holding them outlive it
+    TextureCache::clear();
+    TextureResidency::shared().clear();
+
     // clearing all previously allocated GLFW resources.
     glfwTerminate();
     return 0;
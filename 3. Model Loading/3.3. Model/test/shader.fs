@@ -1,6 +1,26 @@
 #version 330 core
 
+// variant defines (overridable through ShaderDefines, see shader_source.h)
+#ifndef NR_MATERIALS
+#define NR_MATERIALS 1
+#endif
+#ifndef NR_POINT_LIGHTS
+#define NR_POINT_LIGHTS 1                           // the number of point lights we want to have in our scene
+#endif
+
 // material
+#ifdef TEXTURE_ARRAYS
+// packed materials (MaterialPacker): every map is a layer of a texture array, the layer comes with the vertex
+struct Material
+{
+    sampler2DArray texture_diffuse;
+    sampler2DArray texture_specular;
+    float shininess;
+};
+flat in ivec2 Layers;
+#define DIFFUSE_MAP(i)  texture(materials[i].texture_diffuse, vec3(TexCoords, Layers.x))
+#define SPECULAR_MAP(i) texture(materials[i].texture_specular, vec3(TexCoords, Layers.y))
+#else
 struct Material
 {
     sampler2D texture_diffuse;
@@ -9,24 +29,17 @@ struct Material
     sampler2D texture_height;
     float shininess;
 };
-#define NR_MATERIALS 1
+#define DIFFUSE_MAP(i)  texture(materials[i].texture_diffuse, TexCoords)
+#define SPECULAR_MAP(i) texture(materials[i].texture_specular, TexCoords)
+#endif
 uniform Material materials[NR_MATERIALS];
 
-// point light source
-struct PointLight
-{
-    vec3 position;
-
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
+// light source structs (DirLight, PointLight, SpotLight)
+#include "../../../include/light_header/light.glsl"
 
-    float constant;
-    float linear;
-    float quadratic;
-};
-#define NR_POINT_LIGHTS 1                           // define the number of point lights we want to have in our scene
+#if NR_POINT_LIGHTS > 0
 uniform PointLight pointLights[NR_POINT_LIGHTS];    // an array of point light
+#endif
 
 in vec2 TexCoords;
 in vec3 Normal;
@@ -81,8 +94,10 @@ void main()
     vec3 result;
 
     // point lights
+#if NR_POINT_LIGHTS > 0
     for (int i = 0; i < NR_POINT_LIGHTS; ++i)
         result += calcPointLight(pointLights[i], norm, FragPos, viewDir);
+#endif
     
     FragColor = vec4(result, 1.0);
     //------------------------
@@ -109,9 +124,9 @@ LightColor calcLight(vec3 lAmb, vec3 lDiff, vec3 lSpec, float diff, float spec)
 
     for (int i = 0; i < NR_MATERIALS; ++i)
     {
-        ambient += lAmb * texture(materials[i].texture_diffuse, TexCoords).xyz;
-        diffuse += lDiff * diff * texture(materials[i].texture_diffuse, TexCoords).xyz;
-        specular += lSpec * spec * texture(materials[i].texture_specular, TexCoords).xyz;
+        ambient += lAmb * DIFFUSE_MAP(i).xyz;
+        diffuse += lDiff * diff * DIFFUSE_MAP(i).xyz;
+        specular += lSpec * spec * SPECULAR_MAP(i).xyz;
     }
 
     return LightColor(ambient, diffuse, specular);
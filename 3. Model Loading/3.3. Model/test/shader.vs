@@ -1,26 +1,51 @@
 #version 330 core
 
+#ifdef COMPACT_VERTICES
+// quantized vertices (VertexFormat::COMPACT), decoded with the mesh's bounds
+#include "../../../include/mesh_header/vertex_layout.glsl"
+layout (location = 0) in vec4 aPosition;
+layout (location = 1) in vec2 aNormalOct;
+layout (location = 2) in vec2 aTexCoordsUnorm;
+#else
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+#endif
+#ifdef TEXTURE_ARRAYS
+layout (location = 7) in ivec2 aLayers;     // diffuse, specular layer of the packed materials
+#endif
 
 out vec3 Normal;
 out vec2 TexCoords;
 out vec3 FragPos;
+#ifdef TEXTURE_ARRAYS
+flat out ivec2 Layers;
+#endif
 
 uniform mat4 model;
+uniform mat3 normalMatrix;      // inverse transpose of model, computed once per object on the CPU
 uniform mat4 view;
 uniform mat4 projection;
 
 
 void main()
 {
+#ifdef COMPACT_VERTICES
+    vec3 aPos = decodePosition(aPosition);
+    vec3 aNormal = octDecode(aNormalOct);
+    vec2 aTexCoords = decodeTexCoords(aTexCoordsUnorm);
+#endif
+
     gl_Position = projection * view * model * vec4(aPos, 1.0);
 
     // remove the effect of wronglyscaling the normal vectors
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+    Normal = normalMatrix * aNormal;
 
     TexCoords = aTexCoords;
 
     FragPos = vec3(model * vec4(aPos, 1));
+
+#ifdef TEXTURE_ARRAYS
+    Layers = aLayers;
+#endif
 }
\ No newline at end of file
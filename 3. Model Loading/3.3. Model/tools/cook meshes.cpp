@@ -0,0 +1,204 @@
+#include <model_header/model.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <chrono>
+#include <limits>
+#include <algorithm>
+#include <iostream>
+
+
+//=======================================================================================
+
+
+// keeps the reads of the benchmarks from being optimized away
+volatile float s_sink{};
+
+
+/*
+    meshlet culling from a few cameras around the cooked model (the meshlets of its mesh cache):
+    triangles rejected by the frustum and by the normal cones, and the CPU time of a culling
+    pass over every mesh
+*/
+void benchmarkCulling(const std::string& path)
+{
+    MeshCache cache{ MeshCache::pathOf(path) };
+    if (!cache.isValid(MeshCache::hashSource(path, Model::s_importFlags), Model::s_importFlags))
+        return;
+
+    glm::vec3 boundsMin{ std::numeric_limits<float>::max() };
+    glm::vec3 boundsMax{ std::numeric_limits<float>::lowest() };
+    for (std::size_t i{ 0 }; i < cache.meshCount(); ++i)
+        for (const auto& vertex : cache.vertices(i))
+        {
+            boundsMin = glm::min(boundsMin, vertex.m_position);
+            boundsMax = glm::max(boundsMax, vertex.m_position);
+        }
+    glm::vec3 center{ (boundsMin + boundsMax) * 0.5f };
+    float radius{ glm::length(boundsMax - boundsMin) * 0.5f };
+
+    // around the model at 3 radii, 20 degrees up, then close enough for the frustum to clip it
+    struct View
+    {
+        float azimuth{};        // degrees
+        float distance{};       // radii
+    };
+    constexpr View views[]{ { 0.0f, 3.0f }, { 60.0f, 3.0f }, { 120.0f, 3.0f }, { 180.0f, 3.0f }, { 240.0f, 3.0f }, { 300.0f, 3.0f },
+                            { 0.0f, 1.2f }, { 90.0f, 1.2f } };
+    constexpr int passes{ 100 };
+
+    glm::mat4 projection{ glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, radius * 0.01f, radius * 100.0f) };
+    std::vector<std::array<std::uint32_t, 2>> ranges{};
+
+    MeshletCullStats total{};
+    double totalMs{ 0.0 };
+    for (const auto& view : views)
+    {
+        float azimuth{ glm::radians(view.azimuth) };
+        float elevation{ glm::radians(20.0f) };
+        glm::vec3 camera{ center + view.distance * radius * glm::vec3{ std::cos(elevation) * std::sin(azimuth), std::sin(elevation), std::cos(elevation) * std::cos(azimuth) } };
+        Frustum frustum{ Frustum::fromMatrix(projection * glm::lookAt(camera, center, glm::vec3{ 0.0f, 1.0f, 0.0f })) };
+
+        MeshletCullStats stats{};
+        auto start{ std::chrono::steady_clock::now() };
+        for (int pass{ 0 }; pass < passes; ++pass)
+        {
+            stats = {};
+            for (std::size_t i{ 0 }; i < cache.meshCount(); ++i)
+                meshlet::cull(cache.meshlets(i), frustum, camera, ranges, stats);
+        }
+        double ms{ std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / passes };
+
+        std::cout << "    camera " << view.azimuth << " deg, " << view.distance << " radii: " << stats.culledTriangles << " of " << stats.triangles
+                  << " triangles culled (" << stats.outside << " meshlets outside, " << stats.backfacing << " back-facing), " << ms * 1000.0 << " us\n";
+        total += stats;
+        totalMs += ms;
+    }
+
+    std::size_t viewCount{ std::size(views) };
+    std::cout << "    average: " << total.culledTriangles / viewCount << " of " << total.triangles / viewCount << " triangles culled per frame, "
+              << totalMs * 1000.0 / viewCount << " us per culling pass" << std::endl;
+}
+
+
+/*
+    CPU side of loading the model without and with its cache: Assimp import + convertScene()
+    (cold) against hashing the source + opening and validating the cache, every vertex and
+    index read once as the upload would (cached)
+*/
+void benchmarkLoad(const std::string& path)
+{
+    auto start{ std::chrono::steady_clock::now() };
+    Assimp::Importer importer{};
+    const aiScene* scene{ importer.ReadFile(path, Model::s_importFlags) };
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+        return;
+    auto meshes{ Model::convertScene(scene) };
+    double coldMs{ std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() };
+
+    start = std::chrono::steady_clock::now();
+    std::uint64_t sourceHash{ MeshCache::hashSource(path, Model::s_importFlags) };
+    double hashMs{ std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() };
+
+    MeshCache cache{ MeshCache::pathOf(path) };
+    if (!cache.isValid(sourceHash, Model::s_importFlags))
+        return;
+
+    float checksum{ 0.0f };
+    for (std::size_t i{ 0 }; i < cache.meshCount(); ++i)
+    {
+        for (const auto& vertex : cache.vertices(i))
+            checksum += vertex.m_position.x;
+        for (unsigned int index : cache.indices(i))
+            checksum += static_cast<float>(index & 1);
+    }
+    s_sink = checksum;
+    double cachedMs{ std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() };
+
+    std::cout << "    load (CPU): " << coldMs << " ms cold, " << cachedMs << " ms from the cache (" << hashMs << " ms of it hashing the source), "
+              << coldMs / cachedMs << "x" << std::endl;
+}
+
+
+/*
+    CPU time of Model::convertScene() (vertex welding, index optimization, LODs, meshlets) on
+    the calling thread alone and on the shared thread pool, the scene imported once
+*/
+void benchmarkConversion(const std::string& path)
+{
+    Assimp::Importer importer{};
+    const aiScene* scene{ importer.ReadFile(path, Model::s_importFlags) };
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+        return;
+
+    constexpr int runs{ 3 };
+    auto time{ [scene](ThreadPool& pool) {
+        double best{ std::numeric_limits<double>::max() };
+        for (int run{ 0 }; run < runs; ++run)
+        {
+            auto start{ std::chrono::steady_clock::now() };
+            auto meshes{ Model::convertScene(scene, pool) };
+            best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    } };
+
+    // no workers: parallelFor() runs every mesh on the calling thread
+    ThreadPool calling{ 0 };
+    double singleMs{ time(calling) };
+    double poolMs{ time(ThreadPool::shared()) };
+
+    std::cout << "    convertScene (" << scene->mNumMeshes << " meshes, best of " << runs << "): " << singleMs << " ms on 1 thread, "
+              << poolMs << " ms on " << ThreadPool::shared().size() + 1 << " threads (" << singleMs / poolMs << "x)" << std::endl;
+}
+
+
+/*
+    writes the mesh cache (<model>.mesh) of every model given on the command line, so the
+    first run of a program doesn't pay for the Assimp import either:
+
+        ./cook_meshes "resources/model/backpack/backpack.obj"
+
+    no window or GL context is created. the post-transform cache statistics (ACMR: transformed
+    vertices per triangle, ATVR: per vertex, simulated 16 entry FIFO cache) are printed for the
+    meshes as imported and as welded and optimized, with the number of meshlets (clusters of at
+    most 64 vertices and 124 triangles, culled at runtime) the triangles were split into,
+    what culling them rejects from a few camera positions, how much faster the cache loads than
+    the import and how much the thread pool speeds up the conversion.
+*/
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: " << argv[0] << " <model> [<model> ...]" << std::endl;
+        return 1;
+    }
+
+    int failed{ 0 };
+    for (int i{ 1 }; i < argc; ++i)
+    {
+        auto start{ std::chrono::steady_clock::now() };
+        Model::CookStats stats{};
+        bool cooked{ Model::cook(argv[i], &stats) };
+        double ms{ std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() };
+
+        if (cooked)
+        {
+            std::cout << argv[i] << " -> " << MeshCache::pathOf(argv[i]).string() << " (" << ms << " ms)\n"
+                      << "    vertices " << stats.sourceVertices << " -> " << stats.weldedVertices
+                      << ", ACMR " << stats.source.acmr() << " -> " << stats.optimized.acmr()
+                      << ", ATVR " << stats.source.atvr() << " -> " << stats.optimized.atvr() << "\n"
+                      << "    " << stats.triangles << " triangles in " << stats.meshlets << " meshlets" << std::endl;
+            benchmarkLoad(argv[i]);
+            benchmarkCulling(argv[i]);
+            benchmarkConversion(argv[i]);
+        }
+        else
+        {
+            std::cerr << "failed to cook " << argv[i] << std::endl;
+            ++failed;
+        }
+    }
+
+    return failed ? 1 : 0;
+}
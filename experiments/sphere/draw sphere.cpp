@@ -272,7 +272,8 @@ int main()
         model_object = glm::rotate(model_object, 0.1f*static_cast<float>(glfwGetTime()), glm::vec3(0.0f, 1.0f, 0.0f));
         lightingShader.setMat4("model", model_object);
 
-        // draw
+        // draw, with fewer triangles when it's small on screen
+        sphere.selectLod(glm::length(camera.position - spherePosition), camera.fov, configuration::screenHeight);
         sphere.draw();
         //------
 
@@ -308,6 +309,7 @@ int main()
         lightSourceShader.setMat4("model", model_light);
         
         // draw
+        lightSphere.selectLod(glm::length(camera.position - lighting::lightPos), camera.fov, configuration::screenHeight);
         lightSphere.draw();
         //-------------------
 
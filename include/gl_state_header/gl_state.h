@@ -0,0 +1,330 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <glad/glad.h>
+
+#include <array>
+#include <unordered_map>
+#include <cstdint>
+#include <type_traits>
+#include <iostream>
+
+
+// GL_TEXTURE_2D_ARRAY / GL_TEXTURE_3D are core in 3.3, kept here in case glad was generated without them
+#ifndef GL_TEXTURE_2D_ARRAY
+#define GL_TEXTURE_2D_ARRAY 0x8C1A
+#endif
+
+
+// issued vs. filtered (redundant, not sent to the driver) state changes
+struct GLStateCounters
+{
+    enum Call
+    {
+        PROGRAM,
+        VERTEX_ARRAY,
+        ACTIVE_TEXTURE,
+        TEXTURE,
+        CAPABILITY,         // glEnable / glDisable
+        DEPTH,              // glDepthFunc / glDepthMask
+        BLEND,              // glBlendFunc
+        SAMPLER,            // glUniform1i of a sampler
+        CALL_COUNT
+    };
+
+    std::array<unsigned int, CALL_COUNT> issued{};
+    std::array<unsigned int, CALL_COUNT> filtered{};
+
+    unsigned int totalIssued() const   { unsigned int total{ 0 }; for (auto n : issued) total += n; return total; }
+    unsigned int totalFiltered() const { unsigned int total{ 0 }; for (auto n : filtered) total += n; return total; }
+};
+
+
+/*
+    shadow copy of the GL state that is changed per draw
+
+    every bind goes through here and is only forwarded to GL if it changes something, e.g.
+    drawing 10 cubes with the same program, VAO and textures costs one glUseProgram, one
+    glBindVertexArray and one glBindTexture per unit instead of 10 of each.
+
+    the cache assumes it sees every change: code that calls glUseProgram, glBindVertexArray,
+    glActiveTexture, glBindTexture, glEnable/glDisable(GL_DEPTH_TEST/GL_BLEND/...) directly must
+    call invalidate() afterwards. deleted objects must be reported with the forget*() functions,
+    GL may hand out their names again. the same goes for sampler uniforms set with setSampler(),
+    they shouldn't also be set with Shader::setInt.
+
+    call endFrame() once per frame, getLastFrame() then returns the counters of the finished frame.
+*/
+class GLState
+{
+    static constexpr unsigned int s_unknown{ ~0u };         // state not known, the next call is always issued
+    static constexpr unsigned int s_maxTextureUnits{ 32 };  // GL 3.3 guarantees at least 48 combined units
+
+    enum TextureTarget
+    {
+        TARGET_2D,
+        TARGET_CUBE_MAP,
+        TARGET_2D_ARRAY,
+        TARGET_3D,
+        TARGET_COUNT
+    };
+
+    struct Capability
+    {
+        GLenum cap{};
+        int    enabled{};       // -1 unknown
+    };
+
+    static inline unsigned int s_program{ 0 };
+    static inline unsigned int s_vertexArray{ 0 };
+    static inline unsigned int s_activeTexture{ 0 };        // unit index, not GL_TEXTURE0 + index
+    static inline std::array<std::array<unsigned int, TARGET_COUNT>, s_maxTextureUnits> s_textures{};
+
+    // default state of a new context
+    static inline std::array<Capability, 5> s_capabilities{ {
+        { GL_DEPTH_TEST, 0 },
+        { GL_BLEND, 0 },
+        { GL_CULL_FACE, 0 },
+        { GL_STENCIL_TEST, 0 },
+        { GL_SCISSOR_TEST, 0 }
+    } };
+    static inline GLenum s_depthFunc{ GL_LESS };
+    static inline int    s_depthMask{ GL_TRUE };
+    static inline GLenum s_blendSource{ GL_ONE };
+    static inline GLenum s_blendDestination{ GL_ZERO };
+
+    static inline std::unordered_map<std::uint64_t, int> s_samplers{};     // (program, location) -> texture unit
+
+    static inline GLStateCounters s_frame{};
+    static inline GLStateCounters s_lastFrame{};
+
+public:
+    // programs
+    //-----------------------------------------------------------------------------------
+    static void useProgram(unsigned int program)
+    {
+        if (!changed(s_program, program, GLStateCounters::PROGRAM))
+            return;
+        glUseProgram(program);
+    }
+
+    static void forgetProgram(unsigned int program)
+    {
+        if (s_program == program)
+            s_program = s_unknown;
+        std::erase_if(s_samplers, [program](const auto& sampler) { return sampler.first >> 32 == program; });
+    }
+
+    // texture unit of a sampler uniform of the program in use, a location of -1 is ignored like in glUniform1i
+    static void setSampler(int location, int unit)
+    {
+        if (location < 0 || s_program == s_unknown)
+        {
+            if (location >= 0)
+                glUniform1i(location, unit);
+            return;
+        }
+
+        auto key{ (static_cast<std::uint64_t>(s_program) << 32) | static_cast<std::uint32_t>(location) };
+        auto [it, inserted]{ s_samplers.try_emplace(key, unit) };
+        if (!inserted && !changed(it->second, unit, GLStateCounters::SAMPLER))
+            return;
+        if (inserted)
+            ++s_frame.issued[GLStateCounters::SAMPLER];
+        glUniform1i(location, unit);
+    }
+
+    // vertex arrays
+    //-----------------------------------------------------------------------------------
+    static void bindVertexArray(unsigned int vertexArray)
+    {
+        if (!changed(s_vertexArray, vertexArray, GLStateCounters::VERTEX_ARRAY))
+            return;
+        glBindVertexArray(vertexArray);
+    }
+
+    static void forgetVertexArray(unsigned int vertexArray)
+    {
+        if (s_vertexArray == vertexArray)
+            s_vertexArray = s_unknown;
+    }
+
+    // textures
+    //-----------------------------------------------------------------------------------
+    static void activeTexture(unsigned int unit)
+    {
+        if (!changed(s_activeTexture, unit, GLStateCounters::ACTIVE_TEXTURE))
+            return;
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+
+    // bind to the active unit
+    static void bindTexture(GLenum target, unsigned int texture)
+    {
+        int index{ targetIndex(target) };
+        if (index < 0 || s_activeTexture >= s_maxTextureUnits)
+        {
+            // not tracked, always issued
+            ++s_frame.issued[GLStateCounters::TEXTURE];
+            glBindTexture(target, texture);
+            return;
+        }
+
+        if (!changed(s_textures[s_activeTexture][index], texture, GLStateCounters::TEXTURE))
+            return;
+        glBindTexture(target, texture);
+    }
+
+    // bind to the given unit, switches the active unit only if the binding changes
+    static void bindTexture(unsigned int unit, GLenum target, unsigned int texture)
+    {
+        int index{ targetIndex(target) };
+        if (index >= 0 && unit < s_maxTextureUnits && s_textures[unit][index] == texture)
+        {
+            ++s_frame.filtered[GLStateCounters::TEXTURE];
+            return;
+        }
+
+        activeTexture(unit);
+        bindTexture(target, texture);
+    }
+
+    // units tracked by the cache, bindings beyond that are always issued
+    static constexpr unsigned int trackedTextureUnits() { return s_maxTextureUnits; }
+
+    static void forgetTexture(unsigned int texture)
+    {
+        for (auto& unit : s_textures)
+            for (auto& binding : unit)
+                if (binding == texture)
+                    binding = s_unknown;
+    }
+
+    // fixed function state
+    //-----------------------------------------------------------------------------------
+    static void enable(GLenum cap)  { setCapability(cap, true); }
+    static void disable(GLenum cap) { setCapability(cap, false); }
+
+    static void depthFunc(GLenum func)
+    {
+        if (!changed(s_depthFunc, func, GLStateCounters::DEPTH))
+            return;
+        glDepthFunc(func);
+    }
+
+    static void depthMask(bool write)
+    {
+        if (!changed(s_depthMask, write ? GL_TRUE : GL_FALSE, GLStateCounters::DEPTH))
+            return;
+        glDepthMask(write ? GL_TRUE : GL_FALSE);
+    }
+
+    static void blendFunc(GLenum source, GLenum destination)
+    {
+        if (s_blendSource == source && s_blendDestination == destination)
+        {
+            ++s_frame.filtered[GLStateCounters::BLEND];
+            return;
+        }
+
+        ++s_frame.issued[GLStateCounters::BLEND];
+        s_blendSource = source;
+        s_blendDestination = destination;
+        glBlendFunc(source, destination);
+    }
+
+    // forget everything, for code that changed the state behind our back
+    //-----------------------------------------------------------------------------------
+    static void invalidate()
+    {
+        s_program = s_unknown;
+        s_vertexArray = s_unknown;
+        s_activeTexture = s_unknown;
+        for (auto& unit : s_textures)
+            unit.fill(s_unknown);
+        for (auto& capability : s_capabilities)
+            capability.enabled = -1;
+        s_depthFunc = s_unknown;
+        s_depthMask = -1;
+        s_blendSource = s_unknown;
+        s_blendDestination = s_unknown;
+        s_samplers.clear();
+    }
+
+    // counters
+    //-----------------------------------------------------------------------------------
+    static void endFrame()
+    {
+        s_lastFrame = s_frame;
+        s_frame = {};
+    }
+
+    static const GLStateCounters& getLastFrame() { return s_lastFrame; }
+    static const GLStateCounters& getCurrentFrame() { return s_frame; }
+
+    static void printStats(std::ostream& out = std::cout)
+    {
+        static constexpr const char* names[GLStateCounters::CALL_COUNT]{
+            "program", "vertex array", "active texture", "texture", "enable/disable", "depth", "blend", "sampler"
+        };
+
+        const auto& frame{ s_lastFrame };
+        out << "GLState (last frame): " << frame.totalIssued() << " issued, " << frame.totalFiltered() << " filtered\n";
+        for (int i{ 0 }; i < GLStateCounters::CALL_COUNT; ++i)
+            if (frame.issued[i] || frame.filtered[i])
+                out << "    " << names[i] << ": " << frame.issued[i] << " issued, " << frame.filtered[i] << " filtered\n";
+    }
+
+private:
+    // updates the shadow value and counts the call, returns false if the call is redundant
+    template <typename T>
+    static bool changed(T& current, std::type_identity_t<T> value, GLStateCounters::Call call)
+    {
+        if (current == value)
+        {
+            ++s_frame.filtered[call];
+            return false;
+        }
+
+        ++s_frame.issued[call];
+        current = value;
+        return true;
+    }
+
+    static int targetIndex(GLenum target)
+    {
+        switch (target)
+        {
+        case GL_TEXTURE_2D:         return TARGET_2D;
+        case GL_TEXTURE_CUBE_MAP:   return TARGET_CUBE_MAP;
+        case GL_TEXTURE_2D_ARRAY:   return TARGET_2D_ARRAY;
+        case GL_TEXTURE_3D:         return TARGET_3D;
+        default:                    return -1;
+        }
+    }
+
+    static void setCapability(GLenum cap, bool enable)
+    {
+        bool tracked{ false };
+        for (auto& capability : s_capabilities)
+            if (capability.cap == cap)
+            {
+                if (!changed(capability.enabled, enable ? 1 : 0, GLStateCounters::CAPABILITY))
+                    return;
+                tracked = true;
+                break;
+            }
+
+        // untracked capabilities are always issued
+        if (!tracked)
+            ++s_frame.issued[GLStateCounters::CAPABILITY];
+
+        if (enable)
+            glEnable(cap);
+        else
+            glDisable(cap);
+    }
+};
+
+
+#endif
@@ -0,0 +1,291 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <shader_header/shader.h>
+#include <transform_header/transform.h>     // normalMatrix()
+
+#include <vector>
+#include <span>
+#include <array>
+#include <unordered_map>
+#include <cstdint>
+#include <cstring>          // std::memcpy
+#include <algorithm>
+#include <utility>
+#include <chrono>
+#include <iostream>
+
+
+enum class RenderPass : std::uint8_t
+{
+    OPAQUE,                 // sorted by program, material, then front to back (early-z)
+    TRANSPARENT,            // sorted back to front, then by program and material
+    OVERLAY,                // drawn last, in submission order within a program/material
+};
+
+
+// number of state changes of the last flush()
+struct RenderQueueStats
+{
+    unsigned int draws{};
+    unsigned int programChanges{};
+    unsigned int materialChanges{};
+    double       sortMs{};          // CPU time of the radix sort
+};
+
+
+/*
+    collects draws for a frame, sorts them by a 64-bit key and submits them in that order
+
+    key layout (most significant bits first):
+        opaque / overlay:   pass (2) | program (10) | material (20) | depth (32, 0 for overlay)
+        transparent:        pass (2) | inverted depth (32) | program (10) | material (20)
+
+    depth is the view space distance; its float bit pattern is used directly (positive floats
+    compare like their bits), so no near/far range is needed. the keys are sorted with an LSD
+    radix sort (8 bits per pass, passes in which every key has the same byte are skipped).
+
+    a draw references its mesh and material, both must stay alive until flush(). the material
+    is bound through a callback that receives the packet's program, it is only called when the
+    material (or the program) differs from the previous draw.
+
+        queue.submit(RenderPass::OPAQUE, shader, cube, model, depth, &material, bindMaterial);
+        ...
+        queue.flush();
+*/
+class RenderQueue
+{
+public:
+    using MaterialBinder = void (*)(void* material, Shader& shader);
+
+private:
+    struct Packet;
+    using DrawFunction = void (*)(Packet& packet, Shader& shader);
+
+    struct Packet
+    {
+        void*          mesh{};
+        DrawFunction   draw{};
+        void*          material{};
+        MaterialBinder bindMaterial{};
+        std::uint32_t  program{};           // index into m_programs
+        glm::mat4      model{};
+
+        // instanced packets (the program reads the per-instance attributes instead of `model`)
+        std::span<const glm::mat4> models{};
+        std::span<const glm::mat3> normalMatrices{};
+        std::span<const glm::vec3> colors{};
+    };
+
+    struct SortItem
+    {
+        std::uint64_t key{};
+        std::uint32_t packet{};
+    };
+
+    struct Program
+    {
+        Shader*       shader{};
+        UniformHandle model{};
+        UniformHandle normalMatrix{};       // optional, set only if the program uses it
+    };
+
+    static constexpr int s_programBits{ 10 };
+    static constexpr int s_materialBits{ 20 };
+
+    std::vector<Packet>   m_packets{};
+    std::vector<SortItem> m_items{};
+    std::vector<SortItem> m_scratch{};          // radix sort ping-pong buffer
+
+    std::vector<Program>                      m_programs{};
+    std::unordered_map<void*, std::uint32_t>  m_materials{};      // material -> index in the key
+
+    RenderQueueStats m_stats{};
+
+public:
+    // queue a draw of anything with draw() or draw(Shader&) (Cube, Sphere, Mesh, Model)
+    template <typename Drawable>
+    void submit(RenderPass pass, Shader& shader, Drawable& mesh, const glm::mat4& model, float depth,
+                void* material = nullptr, MaterialBinder bindMaterial = nullptr)
+    {
+        DrawFunction draw{ [](Packet& packet, Shader& program) {
+            if constexpr (requires (Drawable& d, Shader& s) { d.draw(s); })
+                static_cast<Drawable*>(packet.mesh)->draw(program);
+            else
+                static_cast<Drawable*>(packet.mesh)->draw();
+        } };
+
+        std::uint32_t program{ programIndex(shader) };
+        std::uint32_t materialIndex{ material ? this->materialIndex(material) : 0u };
+
+        m_items.push_back({ makeKey(pass, program, materialIndex, depth), static_cast<std::uint32_t>(m_packets.size()) });
+        m_packets.push_back({ &mesh, draw, material, bindMaterial, program, model });
+    }
+
+    // queue one instanced draw of a shape with drawInstanced() (Cube, Sphere), the spans must stay valid until flush().
+    // depth is the sort depth of the whole batch, e.g. its nearest instance
+    template <typename Drawable>
+    void submitInstanced(RenderPass pass, Shader& shader, Drawable& mesh, std::span<const glm::mat4> models, float depth,
+                         void* material = nullptr, MaterialBinder bindMaterial = nullptr,
+                         std::span<const glm::mat3> normalMatrices = {}, std::span<const glm::vec3> colors = {})
+    {
+        DrawFunction draw{ [](Packet& packet, Shader&) {
+            static_cast<Drawable*>(packet.mesh)->drawInstanced(packet.models, packet.normalMatrices, packet.colors);
+        } };
+
+        std::uint32_t program{ programIndex(shader) };
+        std::uint32_t materialIndex{ material ? this->materialIndex(material) : 0u };
+
+        m_items.push_back({ makeKey(pass, program, materialIndex, depth), static_cast<std::uint32_t>(m_packets.size()) });
+        m_packets.push_back({ &mesh, draw, material, bindMaterial, program, glm::mat4{ 1.0f }, models, normalMatrices, colors });
+    }
+
+    // sort and draw everything submitted since the last flush
+    void flush()
+    {
+        auto sortStart{ std::chrono::steady_clock::now() };
+        sort();
+
+        m_stats = {};
+        m_stats.sortMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sortStart).count();
+        std::uint32_t currentProgram{ ~0u };
+        void*         currentMaterial{ nullptr };
+
+        for (const auto& item : m_items)
+        {
+            Packet& packet{ m_packets[item.packet] };
+            Program& program{ m_programs[packet.program] };
+
+            bool programChanged{ packet.program != currentProgram };
+            if (programChanged)
+            {
+                program.shader->use();
+                currentProgram = packet.program;
+                ++m_stats.programChanges;
+            }
+
+            // material uniforms live in the program, a new program needs them again
+            if (packet.bindMaterial && (programChanged || packet.material != currentMaterial))
+            {
+                packet.bindMaterial(packet.material, *program.shader);
+                ++m_stats.materialChanges;
+            }
+            currentMaterial = packet.material;
+
+            if (packet.models.empty())
+            {
+                program.shader->setMat4(program.model, packet.model);
+                if (program.shader->getUniformLocation(program.normalMatrix) >= 0)
+                    program.shader->setMat3(program.normalMatrix, normalMatrix(packet.model));
+            }
+            packet.draw(packet, *program.shader);
+            ++m_stats.draws;
+        }
+
+        clear();
+    }
+
+    void clear()
+    {
+        m_packets.clear();
+        m_items.clear();
+        m_programs.clear();
+        m_materials.clear();
+    }
+
+    std::size_t size() const { return m_packets.size(); }
+    const RenderQueueStats& getStats() const { return m_stats; }
+
+    // view space distance of the model origin, the depth argument of submit()
+    static float viewDepth(const glm::mat4& view, const glm::mat4& model)
+    {
+        return -(view * model[3]).z;
+    }
+
+    static std::uint64_t makeKey(RenderPass pass, std::uint32_t program, std::uint32_t material, float depth)
+    {
+        constexpr std::uint64_t programMask{ (1ull << s_programBits) - 1 };
+        constexpr std::uint64_t materialMask{ (1ull << s_materialBits) - 1 };
+
+        std::uint64_t depthBits{ pass == RenderPass::OVERLAY ? 0u : floatBits(depth) };      // overlay: stable, submission order
+        std::uint64_t state{ ((program & programMask) << s_materialBits) | (material & materialMask) };
+        std::uint64_t key{ static_cast<std::uint64_t>(pass) << 62 };
+
+        if (pass == RenderPass::TRANSPARENT)
+            return key | ((0xffffffffull - depthBits) << 30) | state;      // far to near
+        return key | (state << 32) | depthBits;
+    }
+
+private:
+    static std::uint32_t floatBits(float value)
+    {
+        if (!(value > 0.0f))
+            return 0;       // behind the camera (or NaN), sort as nearest
+
+        std::uint32_t bits{};
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    std::uint32_t programIndex(Shader& shader)
+    {
+        for (std::uint32_t i{ 0 }; i < m_programs.size(); ++i)
+            if (m_programs[i].shader == &shader)
+                return i;
+
+        m_programs.push_back({ &shader, shader.uniform("model"), shader.uniform("normalMatrix") });
+        return static_cast<std::uint32_t>(m_programs.size() - 1);
+    }
+
+    std::uint32_t materialIndex(void* material)
+    {
+        // 0 is reserved for "no material"
+        auto [it, inserted]{ m_materials.try_emplace(material, static_cast<std::uint32_t>(m_materials.size() + 1)) };
+        return it->second;
+    }
+
+    // LSD radix sort of m_items by key, stable
+    void sort()
+    {
+        std::size_t count{ m_items.size() };
+        if (count < 2)
+            return;
+
+        m_scratch.resize(count);
+        SortItem* source{ m_items.data() };
+        SortItem* destination{ m_scratch.data() };
+
+        for (int shift{ 0 }; shift < 64; shift += 8)
+        {
+            std::array<std::size_t, 256> histogram{};
+            for (std::size_t i{ 0 }; i < count; ++i)
+                ++histogram[(source[i].key >> shift) & 0xff];
+
+            // every key has the same byte here, nothing to reorder
+            if (histogram[(source[0].key >> shift) & 0xff] == count)
+                continue;
+
+            std::size_t offset{ 0 };
+            for (auto& bucket : histogram)
+            {
+                std::size_t n{ bucket };
+                bucket = offset;
+                offset += n;
+            }
+
+            for (std::size_t i{ 0 }; i < count; ++i)
+                destination[histogram[(source[i].key >> shift) & 0xff]++] = source[i];
+
+            std::swap(source, destination);
+        }
+
+        if (source != m_items.data())
+            std::copy(source, source + count, m_items.data());
+    }
+};
+
+
+#endif
@@ -5,6 +5,14 @@
 
 #include <glad/glad.h>
 
+#include <gl_state_header/gl_state.h>
+#include <shapes/instance_buffer.h>
+#include <mesh_header/vertex_welder.h>
+
+#include <span>
+#include <vector>
+#include <cstdint>
+
 #include <iostream>
 
 
@@ -144,18 +152,23 @@ class Cube
 
     float sideLength();
 
+    static constexpr GLsizei vertexCount() { return static_cast<GLsizei>(std::size(s_CubeVertices) / 3); }
+
     // vertices data
     float vertices[108]{};
     float normals[108]{};
     float texCoords[108]{};
 
-    // interleaved vertices data
-    float interleavedVertices[108*2 + 72]{};
+    // interleaved vertices data, welded: the 36 corners of the triangles share 24 vertices
+    std::vector<float> interleavedVertices{};
+    std::vector<std::uint16_t> indices{};
     int interleavedVerticesStrideSize{};
 
     // buffers
     unsigned int VAO;
     unsigned int VBO;
+    unsigned int EBO;
+    InstanceBuffer instanceBuffer{};        // per-instance data of drawInstanced()
 
 public:
     Cube(float sideLength = 1.0f)
@@ -184,26 +197,39 @@ public:
 
     void draw() const
     {
-        // bind buffer
-        glBindVertexArray(VAO);
+        // bind buffer (no unbind, the next draw binds its own VAO, redundant binds are filtered)
+        GLState::bindVertexArray(VAO);
 
         // draw
-        glDrawArrays(GL_TRIANGLES, 0, std::size(interleavedVertices));
+        glDrawElements(GL_TRIANGLES, vertexCount(), GL_UNSIGNED_SHORT, 0);
+    }
 
-        // unbind buffer
-        glBindVertexArray(0);
+    // draw one cube per model matrix in a single call, normal matrices are derived from the
+    // models if not given (see InstanceBuffer for the attribute locations)
+    void drawInstanced(std::span<const glm::mat4> models,
+                       std::span<const glm::mat3> normalMatrices = {},
+                       std::span<const glm::vec3> colors = {})
+    {
+        GLState::bindVertexArray(VAO);
+
+        GLsizei count{ instanceBuffer.upload(models, normalMatrices, colors) };
+        if (count > 0)
+            glDrawElementsInstanced(GL_TRIANGLES, vertexCount(), GL_UNSIGNED_SHORT, 0, count);
     }
 
     void deleteBuffers()
     {
+        GLState::forgetVertexArray(VAO);
         glDeleteVertexArrays(1, &VAO);
         glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+        instanceBuffer.deleteBuffer();
     }
 
     void print() const
     {
         auto& v{ interleavedVertices };
-        for (std::size_t i{ 0 }; i < std::size(interleavedVertices); i += 8)
+        for (std::size_t i{ 0 }; i < interleavedVertices.size(); i += 8)
         {
             std::cout.precision(2);
             std::cout << v[i  ] << '\t' << v[i+1] << '\t' << v[i+2] << "\t\t"
@@ -216,32 +242,42 @@ public:
 private:
     void buildInterleavedVertices()
     {
-        for (std::size_t i{ 0 }, j{ 0 }, k{ 0 }, l{ 0 }; i < std::size(interleavedVertices); i += 8, j += 3, k += 3, l += 2)
+        float expanded[108*2 + 72]{};
+        for (std::size_t i{ 0 }, j{ 0 }, k{ 0 }, l{ 0 }; i < std::size(expanded); i += 8, j += 3, k += 3, l += 2)
         {
-            interleavedVertices[i]   = vertices[j];
-            interleavedVertices[i+1] = vertices[j+1];
-            interleavedVertices[i+2] = vertices[j+2];
+            expanded[i]   = vertices[j];
+            expanded[i+1] = vertices[j+1];
+            expanded[i+2] = vertices[j+2];
 
-            interleavedVertices[i+3] = normals[k];
-            interleavedVertices[i+4] = normals[k+1];
-            interleavedVertices[i+5] = normals[k+2];
+            expanded[i+3] = normals[k];
+            expanded[i+4] = normals[k+1];
+            expanded[i+5] = normals[k+2];
 
-            interleavedVertices[i+6] = texCoords[l];
-            interleavedVertices[i+7] = texCoords[l+1];
+            expanded[i+6] = texCoords[l];
+            expanded[i+7] = texCoords[l+1];
         }
+
+        // the two triangles of a face repeat 2 of their corners, join them (few enough for 16 bit indices)
+        vertex_welder::Welded welded{ vertex_welder::weld(expanded, 8) };
+        interleavedVertices = vertex_welder::compact<float>(expanded, welded, 8);
+        indices.assign(welded.remap.begin(), welded.remap.end());
     }
 
     void setBuffers()
     {
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
 
         //bind
         //----
-        glBindVertexArray(VAO);
+        GLState::bindVertexArray(VAO);
 
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(interleavedVertices), interleavedVertices, GL_STATIC_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, interleavedVertices.size()*sizeof(float), interleavedVertices.data(), GL_STATIC_DRAW);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size()*sizeof(indices[0]), indices.data(), GL_STATIC_DRAW);
 
         // vertex attribute
         //-----------------
@@ -260,7 +296,7 @@ private:
         // unbind
         //----
         glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);
+        GLState::bindVertexArray(0);
     }
 };
 
@@ -0,0 +1,128 @@
+#ifndef INSTANCE_BUFFER_H
+#define INSTANCE_BUFFER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <transform_header/transform.h>     // normalMatrix()
+
+#include <span>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+
+// vertex attribute locations of the per-instance data (the shapes use 0, 1, 2 for position, normal, texcoords)
+namespace instance_attribute
+{
+    constexpr unsigned int MODEL{ 3 };              // mat4, locations 3-6
+    constexpr unsigned int NORMAL_MATRIX{ 7 };      // mat3, locations 7-9
+    constexpr unsigned int COLOR{ 10 };             // vec3
+}
+
+
+/*
+    per-instance vertex buffer for instanced draws of a shape
+
+    the buffer holds [models][normal matrices][colors], each region sized for `capacity`
+    instances. it is orphaned (re-specified) on every upload, so streaming new matrices every
+    frame never waits for the GPU to finish the previous draw. normal matrices are computed
+    here when the caller doesn't provide them, colors default to white.
+
+    the attributes are attached to the VAO of the shape, which must be bound during upload(),
+    and re-pointed at this buffer on each upload: the draw following it reads this buffer even
+    when copies of the shape (sharing the VAO) upload their own instances in between draws.
+*/
+class InstanceBuffer
+{
+    unsigned int m_VBO{ 0 };
+    std::size_t  m_capacity{ 0 };                   // in instances
+    std::vector<glm::mat3> m_normalMatrices{};      // scratch, when no normal matrices are given
+
+public:
+    // upload the instance data, returns the number of instances to draw
+    GLsizei upload(std::span<const glm::mat4> models,
+                   std::span<const glm::mat3> normalMatrices = {},
+                   std::span<const glm::vec3> colors = {})
+    {
+        std::size_t count{ models.size() };
+        if (count == 0)
+            return 0;
+
+        if (m_VBO == 0)
+            glGenBuffers(1, &m_VBO);
+        glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+
+        if (count > m_capacity)
+            m_capacity = std::max(count, m_capacity * 2);
+        glBufferData(GL_ARRAY_BUFFER, bufferSize(), nullptr, GL_STREAM_DRAW);          // orphan
+
+        // every time: copies of a shape share its VAO, another copy's upload may have pointed
+        // it at its own buffer (and the region offsets depend on the capacity)
+        setAttributes();
+
+        if (normalMatrices.size() < count)
+        {
+            m_normalMatrices.resize(count);
+            for (std::size_t i{ 0 }; i < count; ++i)
+                m_normalMatrices[i] = normalMatrix(models[i]);
+            normalMatrices = m_normalMatrices;
+        }
+
+        glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(glm::mat4), models.data());
+        glBufferSubData(GL_ARRAY_BUFFER, normalMatrixOffset(), count * sizeof(glm::mat3), normalMatrices.data());
+
+        if (colors.size() >= count)
+        {
+            glBufferSubData(GL_ARRAY_BUFFER, colorOffset(), count * sizeof(glm::vec3), colors.data());
+            glEnableVertexAttribArray(instance_attribute::COLOR);
+        }
+        else
+        {
+            // constant attribute value for every instance
+            glDisableVertexAttribArray(instance_attribute::COLOR);
+            glVertexAttrib3f(instance_attribute::COLOR, 1.0f, 1.0f, 1.0f);
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        return static_cast<GLsizei>(count);
+    }
+
+    void deleteBuffer()
+    {
+        glDeleteBuffers(1, &m_VBO);
+        m_VBO = 0;
+        m_capacity = 0;
+    }
+
+private:
+    GLsizeiptr bufferSize() const { return static_cast<GLsizeiptr>(m_capacity * (sizeof(glm::mat4) + sizeof(glm::mat3) + sizeof(glm::vec3))); }
+    std::size_t normalMatrixOffset() const { return m_capacity * sizeof(glm::mat4); }
+    std::size_t colorOffset() const { return m_capacity * (sizeof(glm::mat4) + sizeof(glm::mat3)); }
+
+    void setAttributes()
+    {
+        // a matrix attribute takes one location per column
+        for (unsigned int column{ 0 }; column < 4; ++column)
+        {
+            unsigned int location{ instance_attribute::MODEL + column };
+            glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(column * sizeof(glm::vec4)));
+            glEnableVertexAttribArray(location);
+            glVertexAttribDivisor(location, 1);
+        }
+
+        for (unsigned int column{ 0 }; column < 3; ++column)
+        {
+            unsigned int location{ instance_attribute::NORMAL_MATRIX + column };
+            glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, sizeof(glm::mat3), (void*)(normalMatrixOffset() + column * sizeof(glm::vec3)));
+            glEnableVertexAttribArray(location);
+            glVertexAttribDivisor(location, 1);
+        }
+
+        glVertexAttribPointer(instance_attribute::COLOR, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)colorOffset());
+        glVertexAttribDivisor(instance_attribute::COLOR, 1);
+    }
+};
+
+
+#endif
@@ -5,10 +5,21 @@
 
 #include <glad/glad.h>
 
+#include <gl_state_header/gl_state.h>
+#include <shapes/instance_buffer.h>
+#include <mesh_header/mesh_optimizer.h>
+#include <mesh_header/index_buffer.h>
+#include <mesh_header/mesh_simplifier.h>
+#include <mesh_header/mesh_lod.h>
+
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <vector>
+#include <span>
+#include <array>
+#include <algorithm>
+#include <cstdint>
 
 //==========================
 //  Create sphere
@@ -33,6 +44,11 @@ class Sphere
     std::vector<unsigned int> indices;
     std::vector<unsigned int> lineIndices;
 
+    // levels of detail, simplified from the full tessellation (level 0), after it in the index buffer
+    std::vector<unsigned int> lodIndices;
+    std::vector<MeshLod> lods;
+    int lod{ 0 };
+
     // interleaved vertices data
     std::vector<float> interleavedVertices;
     int interleavedVerticesStride;
@@ -40,7 +56,8 @@ class Sphere
     // buffers
     unsigned int VAO;
     unsigned int VBO;
-    unsigned int EBO;
+    IndexBuffer indexBuffer{};              // 16 bit indices up to 65536 vertices (a 255x255 sphere)
+    InstanceBuffer instanceBuffer{};        // per-instance data of drawInstanced()
 
     // primary
     float radius;
@@ -74,21 +91,51 @@ public:
 
     void draw() const
     {
-        // bind buffer
-        glBindVertexArray(VAO);
+        // bind buffer (no unbind, the next draw binds its own VAO, redundant binds are filtered)
+        GLState::bindVertexArray(VAO);
         
         // draw
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+        indexBuffer.draw(lods[lod].first, static_cast<GLsizei>(lods[lod].count));
+    }
 
-        //unbind
-        glBindVertexArray(0);
+    // draw one sphere per model matrix in a single call, normal matrices are derived from the
+    // models if not given (see InstanceBuffer for the attribute locations)
+    void drawInstanced(std::span<const glm::mat4> models,
+                       std::span<const glm::mat3> normalMatrices = {},
+                       std::span<const glm::vec3> colors = {})
+    {
+        GLState::bindVertexArray(VAO);
+
+        GLsizei count{ instanceBuffer.upload(models, normalMatrices, colors) };
+        if (count > 0)
+            indexBuffer.drawInstanced(lods[lod].first, static_cast<GLsizei>(lods[lod].count), count);
+    }
+
+    // the level drawn from now on, for a sphere (scaled by `scale`) whose center is `distance` away
+    // from the camera, see lod::select()
+    void selectLod(float distance, float fovDegrees, int viewportHeight, float scale = 1.0f)
+    {
+        float pixelsPerUnit{ lod::pixelsPerUnit(distance - radius * scale, fovDegrees, viewportHeight) * scale };
+        lod = lod::select(lods, lod, pixelsPerUnit);
+    }
+
+    int getLod() const { return lod; }
+    int getLodCount() const { return static_cast<int>(lods.size()); }
+    std::size_t getTriangleCount() const { return lods[lod].count / 3; }
+
+    // post-transform cache efficiency of the triangles (CPU simulation)
+    VertexCacheStats vertexCacheStats() const
+    {
+        return mesh_optimizer::analyzeVertexCache(indices, interleavedVertices.size() * sizeof(float) / interleavedVerticesStride);
     }
 
     void deleteBuffers()
     {
+        GLState::forgetVertexArray(VAO);
         glDeleteVertexArrays(1, &VAO);
         glDeleteBuffers(1, &VBO);
-        glDeleteBuffers(1, &EBO);
+        indexBuffer.deleteBuffer();
+        instanceBuffer.deleteBuffer();
     }
 
 private:
@@ -198,9 +245,57 @@ private:
             }
         }
 
+        optimizeIndices();
+        buildLods();
         generateInterleavedVertices();
     }
 
+    // stack/sector order leaves most of the vertex cache unused, reorder the triangles and
+    // vertices (see mesh_optimizer.h), the line indices follow the new vertex order
+    void optimizeIndices()
+    {
+        std::size_t vertexCount{ vertices.size() / 3 };
+
+        std::vector<glm::vec3> positions(vertexCount);
+        for (std::size_t i{ 0 }; i < vertexCount; ++i)
+            positions[i] = { vertices[3*i], vertices[3*i + 1], vertices[3*i + 2] };
+
+        indices = mesh_optimizer::optimizeVertexCache(indices, vertexCount);
+        indices = mesh_optimizer::optimizeOverdraw(indices, positions);
+
+        std::vector<unsigned int> remap{ mesh_optimizer::optimizeVertexFetch(indices, vertexCount) };
+        vertices = mesh_optimizer::remapVertices<float>(vertices, remap, 3);
+        normals = mesh_optimizer::remapVertices<float>(normals, remap, 3);
+        texCoords = mesh_optimizer::remapVertices<float>(texCoords, remap, 2);
+        for (auto& index : lineIndices)
+            index = remap[index];
+    }
+
+    // coarser tessellations for small spheres on screen, each with about half the triangles of the
+    // previous one (see mesh_simplifier.h)
+    void buildLods()
+    {
+        std::size_t vertexCount{ vertices.size() / 3 };
+
+        std::vector<glm::vec3> positions(vertexCount);
+        std::vector<float> attributes(vertexCount * 5);
+        for (std::size_t i{ 0 }; i < vertexCount; ++i)
+        {
+            positions[i] = { vertices[3*i], vertices[3*i + 1], vertices[3*i + 2] };
+            std::copy_n(&normals[3*i], 3, &attributes[5*i]);
+            std::copy_n(&texCoords[2*i], 2, &attributes[5*i + 3]);
+        }
+
+        static constexpr float weights[5]{ 0.1f, 0.1f, 0.1f, 0.1f, 0.1f };
+        auto levels{ mesh_simplifier::buildLods(indices, positions, { attributes, weights }) };
+        mesh_simplifier::flatten(levels, lodIndices, lods);
+
+        // level 0 is the full sphere, the others follow it in the index buffer
+        for (auto& level : lods)
+            level.first += static_cast<std::uint32_t>(indices.size());
+        lods.insert(lods.begin(), MeshLod{ 0, static_cast<std::uint32_t>(indices.size()), 0.0f });
+    }
+
     void generateInterleavedVertices()
     {
         size_t i{}, j{};
@@ -254,23 +349,23 @@ private:
         texCoords.clear();
         indices.clear();
         lineIndices.clear();
+        lodIndices.clear();
     }
 
     void setBuffers()
     {
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
 
         // bind
         //-----
-        glBindVertexArray(VAO);
+        GLState::bindVertexArray(VAO);
 
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
         glBufferData(GL_ARRAY_BUFFER, interleavedVertices.size()*sizeof(interleavedVertices[0]), &interleavedVertices.front(), GL_STATIC_DRAW);
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size()*sizeof(indices[0]), &indices.front(), GL_STATIC_DRAW);
+        std::array<std::span<const unsigned int>, 2> allIndices{ indices, lodIndices };
+        indexBuffer.upload(allIndices, interleavedVertices.size() * sizeof(float) / interleavedVerticesStride);
 
         // vertex attribute
         //-----------------
@@ -289,7 +384,7 @@ private:
         // unbind
         //-------
         glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);
+        GLState::bindVertexArray(0);
     }
 };
 
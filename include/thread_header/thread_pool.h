@@ -0,0 +1,113 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <deque>
+#include <functional>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stop_token>
+#include <atomic>
+#include <latch>
+#include <cstddef>
+
+
+/*
+    fixed size pool of worker threads for CPU-only work (no GL calls, the context belongs to the main thread)
+
+        ThreadPool::shared().parallelFor(meshCount, [&](std::size_t i) { convert(i); });
+
+    parallelFor() hands out indices dynamically (an atomic counter), so uneven items (a 100k
+    vertex mesh next to a 12 vertex one) still keep every thread busy. the calling thread works
+    too and the call returns once every index is done.
+*/
+class ThreadPool
+{
+    std::deque<std::function<void()>> m_tasks{};
+    std::mutex                        m_mutex{};
+    std::condition_variable_any       m_condition{};
+    std::vector<std::jthread>         m_workers{};          // last member: joined before the queue is destroyed
+
+public:
+    // by default one worker per core, minus the calling thread that takes part in parallelFor().
+    // at least one, enqueue()d tasks would never run otherwise (an explicit ThreadPool{ 0 } still
+    // runs parallelFor(), on the calling thread alone)
+    explicit ThreadPool(unsigned int threadCount = std::max(2u, std::thread::hardware_concurrency()) - 1)
+    {
+        for (unsigned int i{ 0 }; i < threadCount; ++i)
+            m_workers.emplace_back([this](std::stop_token stop) { work(stop); });
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool()
+    {
+        for (auto& worker : m_workers)
+            worker.request_stop();
+        m_condition.notify_all();
+    }
+
+    // pool shared by the loaders
+    static ThreadPool& shared()
+    {
+        static ThreadPool pool{};
+        return pool;
+    }
+
+    std::size_t size() const { return m_workers.size(); }
+
+    void enqueue(std::function<void()> task)
+    {
+        {
+            std::scoped_lock lock{ m_mutex };
+            m_tasks.push_back(std::move(task));
+        }
+        m_condition.notify_one();
+    }
+
+    // call fn(i) for every i in [0, count), returns when all calls are done
+    template <typename Function>
+    void parallelFor(std::size_t count, Function&& fn)
+    {
+        if (count == 0)
+            return;
+
+        std::atomic<std::size_t> next{ 0 };
+        auto run{ [&]() {
+            for (std::size_t i{ next++ }; i < count; i = next++)
+                fn(i);
+        } };
+
+        std::size_t helpers{ std::min(m_workers.size(), count - 1) };
+        std::latch done{ static_cast<std::ptrdiff_t>(helpers) };
+        for (std::size_t i{ 0 }; i < helpers; ++i)
+            enqueue([&]() { run(); done.count_down(); });
+
+        run();
+        done.wait();
+    }
+
+private:
+    void work(std::stop_token stop)
+    {
+        while (true)
+        {
+            std::function<void()> task{};
+            {
+                std::unique_lock lock{ m_mutex };
+                if (!m_condition.wait(lock, stop, [this] { return !m_tasks.empty(); }))
+                    return;     // stop requested
+
+                task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+            }
+            task();
+        }
+    }
+};
+
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
+
+#include <cmath>
+
+
+/*
+    matrix that transforms normals by `model`: the inverse transpose of its upper 3x3
+
+    most objects are only rotated, translated and uniformly scaled. their columns are then
+    orthogonal with equal length s, and the inverse transpose is simply mat3(model) / s^2,
+    no inverse needed. anything else (non-uniform scale, shear) takes the general path.
+
+    computed once per object on the CPU, instead of per vertex in the vertex shader.
+*/
+inline glm::mat3 normalMatrix(const glm::mat4& model)
+{
+    glm::mat3 linear{ model };
+
+    float xx{ glm::dot(linear[0], linear[0]) };
+    float yy{ glm::dot(linear[1], linear[1]) };
+    float zz{ glm::dot(linear[2], linear[2]) };
+    float xy{ glm::dot(linear[0], linear[1]) };
+    float xz{ glm::dot(linear[0], linear[2]) };
+    float yz{ glm::dot(linear[1], linear[2]) };
+
+    // relative tolerance, matrices built from float rotations are never exactly orthogonal
+    float epsilon{ 1e-4f * xx };
+    bool orthogonal{ std::abs(xy) <= epsilon && std::abs(xz) <= epsilon && std::abs(yz) <= epsilon };
+    bool uniformScale{ std::abs(xx - yy) <= epsilon && std::abs(xx - zz) <= epsilon };
+
+    if (orthogonal && uniformScale && xx > 0.0f)
+    {
+        // rigid (s == 1): the rotation itself
+        if (std::abs(xx - 1.0f) <= 1e-4f)
+            return linear;
+        return linear * (1.0f / xx);
+    }
+
+    return glm::inverseTranspose(linear);
+}
+
+
+#endif